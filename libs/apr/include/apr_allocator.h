@@ -131,6 +131,13 @@ APR_DECLARE(apr_pool_t *) apr_allocator_owner_get(apr_allocator_t *allocator);
 APR_DECLARE(void) apr_allocator_max_free_set(apr_allocator_t *allocator,
                                              apr_size_t size);
 
+/**
+ * Get the number of bytes held on the allocator's free lists.
+ * @param allocator The allocator to inspect
+ * @return The size of all free blocks, including their node headers.
+ */
+APR_DECLARE(apr_size_t) apr_allocator_free_bytes(apr_allocator_t *allocator);
+
 #include "apr_thread_mutex.h"
 
 #if APR_HAS_THREADS
@@ -167,6 +167,34 @@ APR_DECLARE(void) apr_allocator_max_free_set(apr_allocator_t *allocator,
 #endif
 }
 
+APR_DECLARE(apr_size_t) apr_allocator_free_bytes(apr_allocator_t *allocator)
+{
+    apr_memnode_t *node;
+    apr_uint32_t index;
+    apr_size_t bytes = 0;
+
+#if APR_HAS_THREADS
+    apr_thread_mutex_t *mutex;
+
+    mutex = apr_allocator_mutex_get(allocator);
+    if (mutex != NULL)
+        apr_thread_mutex_lock(mutex);
+#endif /* APR_HAS_THREADS */
+
+    for (index = 0; index < MAX_INDEX; index++) {
+        for (node = allocator->free[index]; node; node = node->next) {
+            bytes += (apr_size_t)(node->index + 1) << BOUNDARY_INDEX;
+        }
+    }
+
+#if APR_HAS_THREADS
+    if (mutex != NULL)
+        apr_thread_mutex_unlock(mutex);
+#endif
+
+    return bytes;
+}
+
 static APR_INLINE
 apr_memnode_t *allocator_alloc(apr_allocator_t *allocator, apr_size_t size)
 {
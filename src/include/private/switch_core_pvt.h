@@ -87,6 +87,16 @@
 #define SWITCH_BUFFER_BLOCK_FRAMES 25
 #define SWITCH_BUFFER_START_FRAMES 50
 
+/* small session allocations are carved from chunks of this size without taking the pool mutex */
+#define SWITCH_SESSION_CHUNK_SIZE 4096
+#define SWITCH_SESSION_CHUNK_MAX_ALLOC 256
+
+typedef struct switch_session_chunk_s {
+	char *base;
+	uint32_t used;
+	uint32_t size;
+} switch_session_chunk_t;
+
 typedef enum {
 	SSF_NONE = 0,
 	SSF_DESTROYED = (1 << 0),
@@ -190,6 +200,7 @@ struct switch_core_session {
 	switch_core_video_thread_callback_func_t video_read_callback;
 	void *video_read_user_data;
 	switch_slin_data_t *sdata;
+	switch_session_chunk_t *alloc_chunk;
 };
 
 struct switch_media_bug {
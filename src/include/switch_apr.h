@@ -971,6 +971,31 @@ SWITCH_DECLARE(switch_status_t) switch_threadattr_detach_set(switch_threadattr_t
 SWITCH_DECLARE(switch_status_t) switch_thread_create(switch_thread_t ** new_thread, switch_threadattr_t *attr,
 													 switch_thread_start_t func, void *data, switch_memory_pool_t *cont);
 
+/** Opaque thread private data key. */
+	 typedef struct apr_threadkey_t switch_threadkey_t;
+
+/**
+ * Create and initialize a new thread private address space
+ * @param key The thread private handle.
+ * @param dest The destructor to use when freeing the private memory.
+ * @param pool The pool to use
+ */
+SWITCH_DECLARE(switch_status_t) switch_threadkey_private_create(switch_threadkey_t ** key, void (*dest) (void *), switch_memory_pool_t *pool);
+
+/**
+ * Get a pointer to the thread private memory
+ * @param data The data stored in private memory
+ * @param key The handle for the desired thread private memory
+ */
+SWITCH_DECLARE(switch_status_t) switch_threadkey_private_get(void **data, switch_threadkey_t *key);
+
+/**
+ * Set the data to be stored in thread private memory
+ * @param data The data to be stored in private memory
+ * @param key The handle for the desired thread private memory
+ */
+SWITCH_DECLARE(switch_status_t) switch_threadkey_private_set(void *data, switch_threadkey_t *key);
+
 /** @} */
 
 /**
@@ -1186,6 +1211,40 @@ SWITCH_DECLARE(switch_status_t) switch_socket_send_nonblock(switch_socket_t *soc
  */
 SWITCH_DECLARE(switch_status_t) switch_socket_recvfrom(switch_sockaddr_t *from, switch_socket_t *sock, int32_t flags, char *buf, size_t *len);
 
+/** The most datagrams moved by a single switch_socket_recvmmsg / switch_socket_sendmmsg call */
+#define SWITCH_SOCKMSG_MAX 64
+
+/** One datagram for the batched socket calls */
+typedef struct switch_sockmsg_s {
+	/** The data buffer */
+	char *buf;
+	/** recv: the size of buf on entry, the datagram length on exit.  send: the length to send */
+	switch_size_t len;
+	/** recv: filled in with the sender address when not NULL */
+	switch_sockaddr_t *from;
+	/** recv: set when the datagram did not fit into buf */
+	switch_bool_t truncated;
+} switch_sockmsg_t;
+
+/**
+ * Receive up to *count datagrams with one system call (recvmmsg) where the platform supports it.
+ * Blocks (subject to the socket mode) for the first datagram only and returns whatever else is already queued.
+ * @param sock The socket to use
+ * @param msgs The datagram descriptors to fill in
+ * @param count On entry, the number of descriptors available; on exit, the number of datagrams received
+ * @return SWITCH_STATUS_SUCCESS, SWITCH_STATUS_BREAK if nothing was queued on a non-blocking socket, or an error
+ */
+SWITCH_DECLARE(switch_status_t) switch_socket_recvmmsg(switch_socket_t *sock, switch_sockmsg_t *msgs, int *count);
+
+/**
+ * Send *count datagrams to the same destination with as few system calls as possible (sendmmsg) where the platform supports it.
+ * @param sock The socket to send from
+ * @param where The destination address
+ * @param msgs The datagrams to send
+ * @param count On entry, the number of datagrams to send; on exit, the number actually sent
+ */
+SWITCH_DECLARE(switch_status_t) switch_socket_sendmmsg(switch_socket_t *sock, switch_sockaddr_t *where, switch_sockmsg_t *msgs, int *count);
+
 SWITCH_DECLARE(switch_status_t) switch_socket_atmark(switch_socket_t *sock, int *atmark);
 
 /**
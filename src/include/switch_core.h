@@ -639,6 +639,41 @@ SWITCH_DECLARE(switch_status_t) switch_core_perform_destroy_memory_pool(_Inout_
 */
 #define switch_core_destroy_memory_pool(p) switch_core_perform_destroy_memory_pool(p, __FILE__, __SWITCH_FUNC__, __LINE__)
 
+typedef struct switch_memory_pool_stats_s {
+	uint32_t depth;
+	uint32_t max_idle;
+	uint32_t cached;
+	uint32_t cached_class[3];
+	uint64_t cached_bytes;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t reused_bytes;
+	uint64_t reclaimed;
+	uint64_t trimmed;
+	uint64_t reclaim_usec_avg;
+	uint64_t reclaim_usec_max;
+	uint64_t session_chunks;
+} switch_memory_pool_stats_t;
+
+/*!
+  \brief Configure the pool cache used to recycle destroyed memory pools
+  \param depth the maximum number of idle pools kept per size class (0 disables the cache)
+  \param max_idle seconds an idle pool may stay cached before it is trimmed (0 keeps them forever)
+*/
+SWITCH_DECLARE(void) switch_core_memory_pool_cache_set(uint32_t depth, uint32_t max_idle);
+
+/*!
+  \brief Pre-allocate pools into the pool cache so the first calls do not pay for them
+  \param count the number of pools to create
+*/
+SWITCH_DECLARE(void) switch_core_memory_pool_cache_prewarm(uint32_t count);
+
+/*!
+  \brief Collect the pool cache counters
+  \param stats the structure to fill in
+*/
+SWITCH_DECLARE(void) switch_core_memory_pool_stats(switch_memory_pool_stats_t *stats);
+
 
 SWITCH_DECLARE(void) switch_core_memory_pool_set_data(switch_memory_pool_t *pool, const char *key, void *data);
 SWITCH_DECLARE(void *) switch_core_memory_pool_get_data(switch_memory_pool_t *pool, const char *key);
@@ -2408,6 +2443,28 @@ SWITCH_DECLARE(void) switch_time_set_nanosleep(switch_bool_t enable);
 SWITCH_DECLARE(void) switch_time_set_matrix(switch_bool_t enable);
 SWITCH_DECLARE(void) switch_time_set_cond_yield(switch_bool_t enable);
 SWITCH_DECLARE(void) switch_time_set_use_system_time(switch_bool_t enable);
+
+#define SWITCH_TIMER_JITTER_BUCKETS 16
+/*! upper bound in usec of soft timer jitter histogram bucket b, the last bucket holds everything above */
+#define SWITCH_TIMER_JITTER_USEC(b) (16ULL << (b))
+
+typedef struct switch_timer_jitter_stats_s {
+	uint32_t interval;
+	uint32_t timers;
+	uint32_t phases;
+	uint32_t shards;
+	uint64_t samples;
+	uint64_t max_usec;
+	uint64_t hist[SWITCH_TIMER_JITTER_BUCKETS];
+} switch_timer_jitter_stats_t;
+
+/*!
+  \brief Collect the wake-up jitter of the soft timer intervals in use
+  \param stats array to fill in, one entry per interval
+  \param max number of entries in stats
+  \return the number of entries filled in
+*/
+SWITCH_DECLARE(uint32_t) switch_time_get_jitter_stats(switch_timer_jitter_stats_t *stats, uint32_t max);
 SWITCH_DECLARE(uint32_t) switch_core_min_dtmf_duration(uint32_t duration);
 SWITCH_DECLARE(uint32_t) switch_core_max_dtmf_duration(uint32_t duration);
 SWITCH_DECLARE(double) switch_core_min_idle_cpu(double new_limit);
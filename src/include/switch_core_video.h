@@ -341,6 +341,31 @@ SWITCH_DECLARE(void) switch_png_free(switch_png_t **pngP);
 SWITCH_DECLARE(void) switch_img_overlay(switch_image_t *IMG, switch_image_t *img, int x, int y, uint8_t percent);
 
 SWITCH_DECLARE(switch_status_t) switch_img_scale(switch_image_t *src, switch_image_t **destP, int width, int height);
+
+/*!\brief Scale an image through the shared scale cache
+*
+* Scaling the same source to the same size again returns the image from the first call.
+* The returned image is shared, it must not be modified and must be given back with switch_img_scale_release
+*
+* \param[in]    src         The image descriptor
+* \param[in]    generation  Version of the src content from switch_img_scale_generation, take a new one whenever src is written to
+* \param[in]    width       The target width
+* \param[in]    height      The target height
+*/
+SWITCH_DECLARE(switch_image_t *) switch_img_scale_cached(switch_image_t *src, uint64_t generation, int width, int height);
+
+/*!rief Get a generation for switch_img_scale_cached, unique across the whole process
+*
+* An image freed and reallocated at the same address never matches a cache entry under a new generation.
+*/
+SWITCH_DECLARE(uint64_t) switch_img_scale_generation(void);
+
+/*!\brief Give back an image returned by switch_img_scale_cached
+*
+* \param[in]    imgP       The image descriptor, set to NULL on return
+*/
+SWITCH_DECLARE(void) switch_img_scale_release(switch_image_t **imgP);
+SWITCH_DECLARE(void) switch_img_scale_cache_stats(uint64_t *hits, uint64_t *misses);
 SWITCH_DECLARE(switch_status_t) switch_img_fit(switch_image_t **srcP, int width, int height, switch_img_fit_t fit);
 SWITCH_DECLARE(switch_img_position_t) parse_img_position(const char *name);
 SWITCH_DECLARE(switch_img_fit_t) parse_img_fit(const char *name);
@@ -374,6 +399,8 @@ SWITCH_DECLARE(switch_image_t *) switch_img_write_text_img(int w, int h, switch_
 SWITCH_DECLARE(switch_image_t *) switch_img_read_file(const char* file_name);
 SWITCH_DECLARE(switch_status_t) switch_img_letterbox(switch_image_t *img, switch_image_t **imgP, int width, int height, const char *color);
 SWITCH_DECLARE(switch_bool_t) switch_core_has_video(void);
+SWITCH_DECLARE(void) switch_core_video_init(switch_memory_pool_t *pool);
+SWITCH_DECLARE(void) switch_core_video_deinit(void);
 
 /*!\brief I420 to I420 Copy*/
 
@@ -100,6 +100,10 @@ struct switch_event {
 	unsigned long key;
 	struct switch_event *next;
 	int flags;
+	/*! number of entries in the header list */
+	int header_count;
+	/*! header name lookup index, only built once the event has many headers */
+	struct switch_event_hindex *hindex;
 };
 
 typedef struct switch_serial_event_s {
@@ -427,6 +431,35 @@ SWITCH_DECLARE(void) switch_json_add_presence_data_cols(switch_event_t *event, c
 
 SWITCH_DECLARE(void) switch_event_launch_dispatch_threads(uint32_t max);
 
+/*! \brief A snapshot of the event dispatch queue counters */
+typedef struct {
+	/*! number of slots in the ring */
+	uint32_t size;
+	/*! events currently waiting for a dispatch thread */
+	uint32_t depth;
+	/*! deepest the queue has been since startup */
+	uint32_t high_water;
+	/*! running dispatch threads */
+	uint32_t threads;
+	/*! events accepted onto the queue */
+	uint64_t enqueued;
+	/*! events discarded because the queue stayed full */
+	uint64_t drops;
+	/*! producers that found the queue full and had to wait */
+	uint64_t full_waits;
+	/*! enqueue latency percentiles in microseconds (bucket upper bound) */
+	uint32_t p50_usec;
+	uint32_t p90_usec;
+	uint32_t p99_usec;
+	uint32_t p999_usec;
+} switch_event_queue_stats_t;
+
+/*!
+  \brief Collect the event dispatch queue counters
+  \param stats the structure to fill in
+*/
+SWITCH_DECLARE(void) switch_event_get_queue_stats(switch_event_queue_stats_t *stats);
+
 SWITCH_DECLARE(switch_status_t) switch_event_channel_broadcast(const char *event_channel, cJSON **json, const char *key, switch_event_channel_id_t id);
 SWITCH_DECLARE(uint32_t) switch_event_channel_unbind(const char *event_channel, switch_event_channel_func_t func);
 SWITCH_DECLARE(switch_status_t) switch_event_channel_bind(const char *event_channel, switch_event_channel_func_t func, switch_event_channel_id_t *id);
@@ -56,8 +56,11 @@ SWITCH_DECLARE(int) switch_jb_frame_count(switch_jb_t *jb);
 SWITCH_DECLARE(int) switch_jb_poll(switch_jb_t *jb);
 SWITCH_DECLARE(switch_status_t) switch_jb_put_packet(switch_jb_t *jb, switch_rtp_packet_t *packet, switch_size_t len);
 SWITCH_DECLARE(switch_size_t) switch_jb_get_last_read_len(switch_jb_t *jb);
+SWITCH_DECLARE(void) switch_jb_get_copy_stats(switch_jb_t *jb, uint64_t *copied, uint64_t *avoided);
 SWITCH_DECLARE(switch_status_t) switch_jb_get_packet(switch_jb_t *jb, switch_rtp_packet_t *packet, switch_size_t *len);
 SWITCH_DECLARE(uint32_t) switch_jb_pop_nack(switch_jb_t *jb);
+SWITCH_DECLARE(int) switch_jb_pop_nacks(switch_jb_t *jb, uint32_t *nacks, int max);
+SWITCH_DECLARE(void) switch_jb_get_nack_stats(switch_jb_t *jb, uint32_t *requested, uint32_t *recovered, uint32_t *late);
 SWITCH_DECLARE(switch_status_t) switch_jb_get_packet_by_seq(switch_jb_t *jb, uint16_t seq, switch_rtp_packet_t *packet, switch_size_t *len);
 SWITCH_DECLARE(void) switch_jb_set_session(switch_jb_t *jb, switch_core_session_t *session);
 SWITCH_DECLARE(void) switch_jb_ts_mode(switch_jb_t *jb, uint32_t samples_per_frame, uint32_t samples_per_second);
@@ -175,6 +175,31 @@ SWITCH_DECLARE(uint32_t) switch_merge_sln(int16_t *data, uint32_t samples, int16
 SWITCH_DECLARE(uint32_t) switch_unmerge_sln(int16_t *data, uint32_t samples, int16_t *other_data, uint32_t other_samples, int channels);
 SWITCH_DECLARE(void) switch_mux_channels(int16_t *data, switch_size_t samples, uint32_t orig_channels, uint32_t channels);
 
+/*!
+  \brief Add a signed linear frame to a 32 bit mix buffer
+  \param mix the mix buffer
+  \param data the audio data
+  \param samples the number of 2 byte samples
+ */
+SWITCH_DECLARE(void) switch_mix_sln_accumulate(int32_t *mix, const int16_t *data, uint32_t samples);
+
+/*!
+  \brief Render a 32 bit mix buffer to signed linear, optionally taking one contribution back out
+  \param out the output audio
+  \param mix the mix buffer
+  \param own the contribution to remove or NULL
+  \param own_samples the number of samples in own
+  \param samples the number of 2 byte samples to render
+ */
+SWITCH_DECLARE(void) switch_mix_sln_unmix(int16_t *out, const int32_t *mix, const int16_t *own, uint32_t own_samples, uint32_t samples);
+
+/*!
+  \brief Select the mixing kernel (avx2, sse2 or scalar)
+  \param name the kernel to use or NULL for the best one this cpu supports
+  \return the name of the kernel selected or NULL if it is not available, the current kernel is kept in that case
+ */
+SWITCH_DECLARE(const char *) switch_mix_sln_kernel(const char *name);
+
 #define switch_resample_calc_buffer_size(_to, _from, _srclen) ((uint32_t)(((float)_to / (float)_from) * (float)_srclen) * 2)
 
 						 
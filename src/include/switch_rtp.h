@@ -187,6 +187,14 @@ SWITCH_DECLARE(void) switch_rtp_get_random(void *buf, uint32_t len);
 SWITCH_DECLARE(void) switch_rtp_init(switch_memory_pool_t *pool);
 SWITCH_DECLARE(void) switch_rtp_shutdown(void);
 
+/*!
+  \brief Set the number of shared RTP reactor threads
+  \param threads number of epoll threads that own the audio RTP sockets, 0 keeps the classic blocking read per session
+  \return the effective number of reactor threads
+  \note only honoured before the reactor has started
+*/
+SWITCH_DECLARE(uint32_t) switch_rtp_set_reactor_threads(uint32_t threads);
+
 /*!
   \brief Set/Get RTP start port
   \param port new value (if > 0)
@@ -196,6 +204,16 @@ SWITCH_DECLARE(switch_port_t) switch_rtp_set_start_port(switch_port_t port);
 
 SWITCH_DECLARE(switch_status_t) switch_rtp_set_ssrc(switch_rtp_t *rtp_session, uint32_t ssrc);
 SWITCH_DECLARE(switch_status_t) switch_rtp_set_remote_ssrc(switch_rtp_t *rtp_session, uint32_t ssrc);
+/*!
+  \brief Enable RFC 4588 retransmission for NACKed packets, pass 0 to resend on the media payload
+  \param rtp_session the RTP session
+  \param rtx_pt the negotiated rtx payload type
+  \param apt the payload type the rtx stream is associated with
+*/
+SWITCH_DECLARE(void) switch_rtp_set_rtx(switch_rtp_t *rtp_session, switch_payload_t rtx_pt, switch_payload_t apt);
+
+/*! the ssrc of the rtx stream paired with a media ssrc, signalled with a=ssrc-group:FID */
+#define SWITCH_RTP_RTX_SSRC(_ssrc) ((uint32_t) (_ssrc) ^ 0x5a5a5a5a)
 
 /*!
   \brief Set/Get RTP end port
@@ -332,6 +350,13 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_activate_rtcp(switch_rtp_t *rtp_sessi
 SWITCH_DECLARE(switch_timer_t *) switch_rtp_get_media_timer(switch_rtp_t *rtp_session);
 
 SWITCH_DECLARE(switch_status_t) switch_rtp_set_video_buffer_size(switch_rtp_t *rtp_session, uint32_t frames, uint32_t max_frames);
+/*!
+  \brief Spread outgoing video packets over time instead of sending each frame as one burst
+  \param rtp_session the RTP session
+  \param kbps the negotiated video bitrate, 0 for the default
+  \return SWITCH_STATUS_SUCCESS once the pacer is running
+*/
+SWITCH_DECLARE(switch_status_t) switch_rtp_set_video_pacing(switch_rtp_t *rtp_session, uint32_t kbps);
 SWITCH_DECLARE(switch_status_t) switch_rtp_get_video_buffer_size(switch_rtp_t *rtp_session, uint32_t *min_frame_len, uint32_t *max_frame_len, uint32_t *cur_frame_len, uint32_t *highest_frame_len);
 
 /*! 
@@ -541,6 +566,7 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_write_raw(switch_rtp_t *rtp_session,
   \return the SSRC
 */
 SWITCH_DECLARE(uint32_t) switch_rtp_get_ssrc(switch_rtp_t *rtp_session);
+SWITCH_DECLARE(uint32_t) switch_rtp_get_rtx_ssrc(switch_rtp_t *rtp_session);
 
 /*! 
   \brief Associate an arbitrary data pointer with and RTP session
@@ -585,6 +611,12 @@ SWITCH_DECLARE(int) switch_rtp_has_dtls(void);
 
 SWITCH_DECLARE(switch_status_t) switch_rtp_req_bitrate(switch_rtp_t *rtp_session, uint32_t bps);
 SWITCH_DECLARE(switch_status_t) switch_rtp_ack_bitrate(switch_rtp_t *rtp_session, uint32_t bps);
+/*!
+  \brief Get the last bitrate in bps the remote end asked us to send at with TMMBR or REMB
+  \param rtp_session the RTP session
+  \return the bitrate or 0 when no feedback was received
+*/
+SWITCH_DECLARE(uint32_t) switch_rtp_get_remote_bitrate(switch_rtp_t *rtp_session);
 SWITCH_DECLARE(void) switch_rtp_video_refresh(switch_rtp_t *rtp_session);
 SWITCH_DECLARE(void) switch_rtp_video_loss(switch_rtp_t *rtp_session);
 
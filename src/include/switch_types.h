@@ -637,6 +637,17 @@ typedef struct {
 	switch_size_t cng_packet_count;
 	switch_size_t flush_packet_count;
 	switch_size_t largest_jb_size;
+	switch_size_t syscall_count;	/* socket calls used to move packet_count packets */
+	switch_size_t nack_count;	/* sequence numbers NACKed */
+	switch_size_t nack_recovered_count;	/* NACKed packets that arrived in time */
+	switch_size_t nack_late_count;	/* NACKed packets that arrived after their frame was gone */
+	switch_size_t rtx_packet_count;	/* retransmissions sent or received */
+	switch_size_t rtx_miss_count;	/* NACKed packets no longer in the retransmission cache */
+	switch_size_t paced_packet_count;	/* packets released by the video pacer */
+	switch_size_t pacing_queue_depth;	/* packets waiting in the video pacer right now */
+	switch_size_t pacing_queue_max;
+	switch_size_t pacing_delay_total;	/* usec spent waiting in the video pacer */
+	switch_size_t pacing_delay_max;
 	/* Jitter */
 	int64_t last_proc_time;		
 	int64_t jitter_n;
@@ -720,6 +731,7 @@ typedef enum {
 	SWITCH_RTP_FLAG_BUGGY_2833    - Emulate the bug in cisco equipment to allow interop
 	SWITCH_RTP_FLAG_PASS_RFC2833  - Pass 2833 (ignore it)
 	SWITCH_RTP_FLAG_AUTO_CNG      - Generate outbound CNG frames when idle    
+	SWITCH_RTP_FLAG_BATCH_IO      - Move packets with recvmmsg/sendmmsg where available
 </pre>
  */
 typedef enum {
@@ -767,6 +779,7 @@ typedef enum {
 	SWITCH_RTP_FLAG_TMMBR,
 	SWITCH_RTP_FLAG_GEN_TS_DELTA,
 	SWITCH_RTP_FLAG_DETECT_SSRC,
+	SWITCH_RTP_FLAG_BATCH_IO,
 	SWITCH_RTP_FLAG_INVALID
 } switch_rtp_flag_t;
 
@@ -1512,6 +1525,7 @@ typedef enum {
 	CF_3P_NOMEDIA_REQUESTED_BLEG,
 	CF_IMAGE_SDP,
 	CF_VIDEO_SDP_RECVD,
+	CF_VIDEO_DECODE_PAUSE,
 	/* WARNING: DO NOT ADD ANY FLAGS BELOW THIS LINE */
 	/* IF YOU ADD NEW ONES CHECK IF THEY SHOULD PERSIST OR ZERO THEM IN switch_core_session.c switch_core_session_request_xml() */
 	CF_FLAG_MAX
@@ -2266,6 +2280,7 @@ typedef enum {
 	SCC_VIDEO_RESET,
 	SCC_AUDIO_PACKET_LOSS,
 	SCC_DEBUG,
+	SCC_VIDEO_ENCODE_TIME,
 	SCC_CODEC_SPECIFIC
 } switch_codec_control_command_t;
 
@@ -2201,6 +2201,7 @@ SWITCH_STANDARD_API(status_function)
 	char * nl = "\n";					/* shortcut to format.nl	*/
 	stream_format format = { 0 };
 	switch_size_t cur = 0, max = 0;
+	switch_memory_pool_stats_t pool_stats = { 0 };
 
 	set_format(&format, stream);
 
@@ -2251,6 +2252,16 @@ SWITCH_STANDARD_API(status_function)
 	stream->write_function(stream, "%d session(s) max%s", switch_core_session_limit(0), nl);
 	stream->write_function(stream, "min idle cpu %0.2f/%0.2f%s", switch_core_min_idle_cpu(-1.0), switch_core_idle_cpu(), nl);
 
+	switch_core_memory_pool_stats(&pool_stats);
+	if (pool_stats.depth) {
+		stream->write_function(stream, "%u pool(s) cached (%u/%u/%u) %" SWITCH_UINT64_T_FMT "K, hits %" SWITCH_UINT64_T_FMT
+							   " misses %" SWITCH_UINT64_T_FMT " reused %" SWITCH_UINT64_T_FMT "K, reclaim avg %" SWITCH_UINT64_T_FMT
+							   "us max %" SWITCH_UINT64_T_FMT "us, trimmed %" SWITCH_UINT64_T_FMT "%s",
+							   pool_stats.cached, pool_stats.cached_class[0], pool_stats.cached_class[1], pool_stats.cached_class[2],
+							   pool_stats.cached_bytes / 1024, pool_stats.hits, pool_stats.misses, pool_stats.reused_bytes / 1024,
+							   pool_stats.reclaim_usec_avg, pool_stats.reclaim_usec_max, pool_stats.trimmed, nl);
+	}
+
 	if (switch_core_get_stacksizes(&cur, &max) == SWITCH_STATUS_SUCCESS) {		stream->write_function(stream, "Current Stack Size/Max %ldK/%ldK\n", cur / 1024, max / 1024);
 	}
 	return SWITCH_STATUS_SUCCESS;
@@ -5287,7 +5298,7 @@ SWITCH_STANDARD_API(coalesce_function)
 	return status;
 }
 
-#define SHOW_SYNTAX "codec|endpoint|application|api|dialplan|file|timer|calls [count]|channels [count|like <match string>]|calls|detailed_calls|bridged_calls|detailed_bridged_calls|aliases|complete|chat|management|modules|nat_map|say|interfaces|interface_types|tasks|limits|status"
+#define SHOW_SYNTAX "codec|endpoint|application|api|dialplan|file|timer [jitter]|calls [count]|channels [count|like <match string>]|calls|detailed_calls|bridged_calls|detailed_bridged_calls|aliases|complete|chat|management|modules|nat_map|say|interfaces|interface_types|tasks|limits|status|event_queue"
 SWITCH_STANDARD_API(show_function)
 {
 	char sql[1024];
@@ -5339,6 +5350,50 @@ SWITCH_STANDARD_API(show_function)
 		}
 		switch_api_execute(command, as, NULL, stream);
 		goto end;
+	} else if (!strcasecmp(command, "event_queue")) {
+		switch_event_queue_stats_t stats = { 0 };
+
+		switch_event_get_queue_stats(&stats);
+		stream->write_function(stream, "size: %u\n", stats.size);
+		stream->write_function(stream, "depth: %u\n", stats.depth);
+		stream->write_function(stream, "high-water: %u\n", stats.high_water);
+		stream->write_function(stream, "dispatch-threads: %u\n", stats.threads);
+		stream->write_function(stream, "enqueued: %" SWITCH_UINT64_T_FMT "\n", stats.enqueued);
+		stream->write_function(stream, "full-waits: %" SWITCH_UINT64_T_FMT "\n", stats.full_waits);
+		stream->write_function(stream, "drops: %" SWITCH_UINT64_T_FMT "\n", stats.drops);
+		stream->write_function(stream, "enqueue-usec: p50<=%u p90<=%u p99<=%u p99.9<=%u\n",
+							   stats.p50_usec, stats.p90_usec, stats.p99_usec, stats.p999_usec);
+		goto end;
+	} else if (!strncasecmp(command, "timer", 5) && argv[1] && !strcasecmp(argv[1], "jitter")) {
+		switch_timer_jitter_stats_t stats[64];
+		uint32_t n, i, b;
+
+		n = switch_time_get_jitter_stats(stats, sizeof(stats) / sizeof(stats[0]));
+
+		if (!n) {
+			stream->write_function(stream, "No soft timer intervals in use (per-timer timerfd mode does not share a tick)\n");
+		}
+
+		for (i = 0; i < n; i++) {
+			stream->write_function(stream, "interval %ums: %u timer(s) on %u phase(s), %u shard(s), %" SWITCH_UINT64_T_FMT
+								   " wakeup(s), max %" SWITCH_UINT64_T_FMT "us\n",
+								   stats[i].interval, stats[i].timers, stats[i].phases, stats[i].shards, stats[i].samples, stats[i].max_usec);
+
+			for (b = 0; b < SWITCH_TIMER_JITTER_BUCKETS; b++) {
+				if (!stats[i].hist[b]) {
+					continue;
+				}
+
+				if (b == SWITCH_TIMER_JITTER_BUCKETS - 1) {
+					stream->write_function(stream, "  >%" SWITCH_UINT64_T_FMT "us: %" SWITCH_UINT64_T_FMT "\n",
+										   (uint64_t) SWITCH_TIMER_JITTER_USEC(b - 1), stats[i].hist[b]);
+				} else {
+					stream->write_function(stream, "  <=%" SWITCH_UINT64_T_FMT "us: %" SWITCH_UINT64_T_FMT "\n",
+										   (uint64_t) SWITCH_TIMER_JITTER_USEC(b), stats[i].hist[b]);
+				}
+			}
+		}
+		goto end;
 	/* If you change the field qty or order of any of these select          */
 	/* statements, you must also change show_callback and friends to match! */
 	} else if (!strncasecmp(command, "codec", 5) ||
@@ -7347,7 +7402,9 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_commands_load)
 	switch_console_set_complete("add show registrations");
 	switch_console_set_complete("add show say");
 	switch_console_set_complete("add show status");
+	switch_console_set_complete("add show event_queue");
 	switch_console_set_complete("add show timer");
+	switch_console_set_complete("add show timer jitter");
 	switch_console_set_complete("add shutdown");
 	switch_console_set_complete("add sql_escape");
 	switch_console_set_complete("add unload ::console::list_loaded_modules");
@@ -106,7 +106,8 @@ api_command_t conference_api_sub_commands[] = {
 	{"vid-fps", (void_fn_t) & conference_api_sub_vid_fps, CONF_API_SUB_ARGS_SPLIT, "vid-fps", "<fps>"},
 	{"vid-bgimg", (void_fn_t) & conference_api_sub_canvas_bgimg, CONF_API_SUB_ARGS_SPLIT, "vid-bgimg", "<file> | clear [<canvas-id>]"},
 	{"vid-bandwidth", (void_fn_t) & conference_api_sub_vid_bandwidth, CONF_API_SUB_ARGS_SPLIT, "vid-bandwidth", "<BW>"},
-	{"vid-personal", (void_fn_t) & conference_api_sub_vid_personal, CONF_API_SUB_ARGS_SPLIT, "vid-personal", "[on|off]"}
+	{"vid-personal", (void_fn_t) & conference_api_sub_vid_personal, CONF_API_SUB_ARGS_SPLIT, "vid-personal", "[on|off]"},
+	{"json_list", (void_fn_t) & conference_api_sub_json_list, CONF_API_SUB_ARGS_SPLIT, "json_list", "[compact]"}
 };
 
 switch_status_t conference_api_sub_pause_play(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv)
@@ -214,6 +215,8 @@ switch_status_t conference_api_main_real(const char *cmd, switch_core_session_t
 				conference_api_sub_list(NULL, stream, argc, argv);
 			} else if (strcasecmp(argv[0], "xml_list") == 0) {
 				conference_api_sub_xml_list(NULL, stream, argc, argv);
+			} else if (strcasecmp(argv[0], "json_list") == 0) {
+				conference_api_sub_json_list(NULL, stream, argc, argv);
 			} else if (strcasecmp(argv[0], "help") == 0 || strcasecmp(argv[0], "commands") == 0) {
 				stream->write_function(stream, "%s\n", api_syntax);
 			} else if (argv[1] && strcasecmp(argv[1], "dial") == 0) {
@@ -2864,6 +2867,37 @@ switch_status_t conference_api_sub_xml_list(conference_obj_t *conference, switch
 	return SWITCH_STATUS_SUCCESS;
 }
 
+switch_status_t conference_api_sub_json_list(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv)
+{
+	switch_hash_index_t *hi;
+	void *val;
+	cJSON *json_conferences = cJSON_CreateArray();
+	char *ebuf;
+	int compact = (argc > 0 && !strcasecmp(argv[argc - 1], "compact"));
+
+	switch_assert(json_conferences);
+
+	if (conference == NULL) {
+		switch_mutex_lock(conference_globals.hash_mutex);
+		for (hi = switch_core_hash_first(conference_globals.conference_hash); hi; hi = switch_core_hash_next(&hi)) {
+			switch_core_hash_this(hi, NULL, NULL, &val);
+			conference_jlist((conference_obj_t *) val, json_conferences);
+		}
+		switch_mutex_unlock(conference_globals.hash_mutex);
+	} else {
+		conference_jlist(conference, json_conferences);
+	}
+
+	ebuf = compact ? cJSON_PrintUnformatted(json_conferences) : cJSON_Print(json_conferences);
+
+	stream->write_function(stream, "%s\n", ebuf);
+
+	cJSON_Delete(json_conferences);
+	free(ebuf);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 
 
 
@@ -1209,6 +1209,8 @@ void conference_loop_output(conference_member_t *member)
 		int use_timer = 0;
 		switch_buffer_t *use_buffer = NULL;
 		uint32_t mux_used = 0;
+		audio_codec_set_t *codec_set = NULL;
+		int codec_index;
 
 
 		//if (member->reset_media || switch_channel_test_flag(member->channel, CF_CONFERENCE_RESET_MEDIA)) {
@@ -1279,8 +1281,48 @@ void conference_loop_output(conference_member_t *member)
 			}
 		}
 
+		/* a bug attached since the last mix tick must not see the shared encoder, it rejoins the mux path next tick */
+		if ((codec_index = member->audio_codec_index) > -1 && !switch_core_media_bug_count(member->session, NULL)) {
+			codec_set = member->conference->audio_codecs[codec_index];
+		}
+
 		if (switch_channel_test_app_flag(channel, CF_APP_TAGGED)) {
 			conference_utils_member_set_flag_locked(member, MFLAG_FLUSH_BUFFER);
+		} else if (codec_set) {
+			/* a listener in an active speaker mix, the frame was already encoded once for everyone on this codec */
+			switch_frame_t enc_frame = { 0 };
+
+			if (mux_used) {
+				conference_utils_member_set_flag_locked(member, MFLAG_FLUSH_BUFFER);
+			}
+
+			enc_frame.data = data;
+
+			switch_mutex_lock(codec_set->mutex);
+			if (codec_set->seq - member->audio_codec_seq > CONF_AUDIO_CODEC_FRAMES / 2) {
+				/* getting behind, skip to the newest frame */
+				member->audio_codec_seq = codec_set->seq - 1;
+			}
+
+			if (member->audio_codec_seq != codec_set->seq) {
+				uint32_t slot = ++member->audio_codec_seq % CONF_AUDIO_CODEC_FRAMES;
+
+				enc_frame.datalen = codec_set->datalen[slot];
+				memcpy(enc_frame.data, codec_set->frames[slot], enc_frame.datalen);
+			}
+			switch_mutex_unlock(codec_set->mutex);
+
+			if (enc_frame.datalen) {
+				enc_frame.codec = &codec_set->codec;
+				enc_frame.samples = codec_set->impl->samples_per_packet;
+				enc_frame.rate = codec_set->impl->actual_samples_per_second;
+				enc_frame.timestamp = timer.samplecount;
+
+				if (switch_core_session_write_frame(member->session, &enc_frame, SWITCH_IO_FLAG_NONE, 0) != SWITCH_STATUS_SUCCESS) {
+					switch_mutex_unlock(member->write_mutex);
+					break;
+				}
+			}
 		} else if (mux_used >= bytes) {
 			/* Flush the output buffer and write all the data (presumably muxed) back to the channel */
 			switch_mutex_lock(member->audio_out_mutex);
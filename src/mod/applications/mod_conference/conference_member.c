@@ -704,6 +704,7 @@ switch_status_t conference_member_add(conference_obj_t *conference, conference_m
 	member->score_iir = 0;
 	member->verbose_events = conference->verbose_events;
 	member->video_layer_id = -1;
+	member->audio_codec_index = -1;
 	member->layer_timeout = DEFAULT_LAYER_TIMEOUT;
 
 	switch_queue_create(&member->dtmf_queue, 100, member->pool);
@@ -336,20 +336,54 @@ void conference_video_clear_layer(mcu_layer_t *layer)
 
 	layer->banner_patched = 0;
 	layer->refresh = 1;
+	layer->dirty = 1;
 	
 }
 
+/* everything under the layers was repainted, put them all back on the next pass */
+static void conference_video_dirty_layers(mcu_canvas_t *canvas)
+{
+	int i;
+
+	for (i = 0; i < MCU_MAX_LAYERS; i++) {
+		canvas->layers[i].dirty = 1;
+	}
+}
+
+/* an overlapping layer has to go back on top of anything patched under it this tick */
+static int conference_video_layer_covered(mcu_layer_t *layer)
+{
+	mcu_canvas_t *canvas = layer->canvas;
+	int i;
+
+	for (i = 0; i < canvas->total_layers; i++) {
+		mcu_layer_t *xlayer = &canvas->layers[i];
+
+		if (xlayer == layer || !xlayer->patched) {
+			continue;
+		}
+
+		if (xlayer->x_pos < layer->x_pos + (int)layer->screen_w && layer->x_pos < xlayer->x_pos + (int)xlayer->screen_w &&
+			xlayer->y_pos < layer->y_pos + (int)layer->screen_h && layer->y_pos < xlayer->y_pos + (int)xlayer->screen_h) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
 void conference_video_reset_layer(mcu_layer_t *layer)
 {
 	switch_img_free(&layer->banner_img);
 	switch_img_free(&layer->logo_img);
 	switch_img_free(&layer->logo_text_img);
+	switch_img_free(&layer->mute_banner_img);
 
+	layer->patched_img = NULL;
 	layer->bugged = 0;
 	layer->mute_patched = 0;
 	layer->banner_patched = 0;
 	layer->is_avatar = 0;
-	layer->need_patch = 0;
 
 	if (layer->geometry.overlap) {
 		layer->canvas->refresh = 1;
@@ -363,11 +397,11 @@ void conference_video_reset_layer(mcu_layer_t *layer)
 	switch_img_free(&layer->cur_img);
 }
 
-void conference_video_scale_and_patch(mcu_layer_t *layer, switch_image_t *ximg, switch_bool_t freeze)
+/* caller holds the canvas mutex, layers that do not overlap only touch their own part of the canvas so they can be patched in parallel */
+static void conference_video_scale_and_patch_locked(mcu_layer_t *layer, switch_image_t *ximg, switch_bool_t freeze)
 {
 	switch_image_t *IMG, *img;
-
-	switch_mutex_lock(layer->canvas->mutex);
+	switch_time_t start = switch_time_now(), scale_time;
 
 	IMG = layer->canvas->img;
 	img = ximg ? ximg : layer->cur_img;
@@ -375,7 +409,13 @@ void conference_video_scale_and_patch(mcu_layer_t *layer, switch_image_t *ximg,
 	switch_assert(IMG);
 
 	if (!img) {
-		switch_mutex_unlock(layer->canvas->mutex);
+		return;
+	}
+
+	/* the same image with nothing changed around it is already on the canvas */
+	if (!freeze && !layer->dirty && !layer->clear && !layer->refresh && !layer->bugged && img == layer->patched_img &&
+		!(layer->geometry.overlap && conference_video_layer_covered(layer))) {
+		layer->skipped++;
 		return;
 	}
 
@@ -477,7 +517,11 @@ void conference_video_scale_and_patch(mcu_layer_t *layer, switch_image_t *ximg,
 		img_w -= (layer->geometry.border * 2);
 		img_h -= (layer->geometry.border * 2);
 
+		scale_time = switch_time_now();
 		switch_img_scale(img, &layer->img, img_w, img_h);
+		scale_time = switch_time_now() - scale_time;
+		layer->scale_time += scale_time;
+		start += scale_time;
 
 		if (layer->img) {
 			if (layer->bugged) {
@@ -523,13 +567,160 @@ void conference_video_scale_and_patch(mcu_layer_t *layer, switch_image_t *ximg,
 		switch_img_patch(IMG, img, 0, 0);
 	}
 
+	layer->patched_img = img;
+	layer->dirty = 0;
+	layer->patched = 1;
+	layer->patch_time += switch_time_now() - start;
+}
+
+void conference_video_scale_and_patch(mcu_layer_t *layer, switch_image_t *ximg, switch_bool_t freeze)
+{
+	switch_mutex_lock(layer->canvas->mutex);
+	conference_video_scale_and_patch_locked(layer, ximg, freeze);
 	switch_mutex_unlock(layer->canvas->mutex);
 }
 
+static void conference_video_patch_layer(mcu_layer_t *layer)
+{
+	mcu_canvas_t *canvas = layer->canvas;
+
+	conference_video_scale_and_patch_locked(layer, NULL, SWITCH_FALSE);
+
+	switch_mutex_lock(canvas->patch_mutex);
+	if (!--canvas->patch_pending) {
+		switch_thread_cond_signal(canvas->patch_cond);
+	}
+	switch_mutex_unlock(canvas->patch_mutex);
+}
+
+static void *SWITCH_THREAD_FUNC conference_video_patch_thread_run(switch_thread_t *thread, void *obj)
+{
+	mcu_canvas_t *canvas = (mcu_canvas_t *) obj;
+	void *pop;
+
+	while (switch_queue_pop(canvas->patch_queue, &pop) == SWITCH_STATUS_SUCCESS && pop) {
+		conference_video_patch_layer((mcu_layer_t *) pop);
+	}
+
+	return NULL;
+}
+
+static void conference_video_start_patch_threads(mcu_canvas_t *canvas)
+{
+	switch_threadattr_t *thd_attr = NULL;
+	int count = switch_core_cpu_count() - 1;
+
+	if (count < 2) {
+		return;
+	}
+
+	if (count > MCU_MAX_PATCH_THREADS) {
+		count = MCU_MAX_PATCH_THREADS;
+	}
+
+	if (!canvas->patch_queue) {
+		switch_queue_create(&canvas->patch_queue, MCU_MAX_LAYERS + MCU_MAX_PATCH_THREADS, canvas->pool);
+		switch_mutex_init(&canvas->patch_mutex, SWITCH_MUTEX_NESTED, canvas->pool);
+		switch_thread_cond_create(&canvas->patch_cond, canvas->pool);
+	}
+
+	switch_threadattr_create(&thd_attr, canvas->pool);
+	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+
+	for (canvas->patch_thread_count = 0; canvas->patch_thread_count < count; canvas->patch_thread_count++) {
+		if (switch_thread_create(&canvas->patch_threads[canvas->patch_thread_count], thd_attr,
+								 conference_video_patch_thread_run, canvas, canvas->pool) != SWITCH_STATUS_SUCCESS) {
+			break;
+		}
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Canvas %d compositing with %d patch threads\n",
+					  canvas->canvas_id + 1, canvas->patch_thread_count);
+}
+
+static void conference_video_stop_patch_threads(mcu_canvas_t *canvas)
+{
+	switch_status_t st;
+	int i;
+
+	for (i = 0; i < canvas->patch_thread_count; i++) {
+		switch_queue_push(canvas->patch_queue, NULL);
+	}
+
+	for (i = 0; i < canvas->patch_thread_count; i++) {
+		switch_thread_join(&st, canvas->patch_threads[i]);
+		canvas->patch_threads[i] = NULL;
+	}
+
+	canvas->patch_thread_count = 0;
+}
+
+/* caller holds the canvas mutex until the layers are done */
+static void conference_video_queue_patch(mcu_canvas_t *canvas, mcu_layer_t *layer)
+{
+	if (!canvas->patch_thread_count) {
+		conference_video_scale_and_patch_locked(layer, NULL, SWITCH_FALSE);
+		return;
+	}
+
+	switch_mutex_lock(canvas->patch_mutex);
+	canvas->patch_pending++;
+	switch_mutex_unlock(canvas->patch_mutex);
+
+	switch_queue_push(canvas->patch_queue, layer);
+}
+
+static void conference_video_wait_for_patches(mcu_canvas_t *canvas)
+{
+	void *pop;
+
+	if (!canvas->patch_thread_count) {
+		return;
+	}
+
+	/* lend a hand with whatever is still queued, then wait for the layers in flight */
+	while (switch_queue_trypop(canvas->patch_queue, &pop) == SWITCH_STATUS_SUCCESS && pop) {
+		conference_video_patch_layer((mcu_layer_t *) pop);
+	}
+
+	switch_mutex_lock(canvas->patch_mutex);
+	while (canvas->patch_pending) {
+		switch_thread_cond_wait(canvas->patch_cond, canvas->patch_mutex);
+	}
+	switch_mutex_unlock(canvas->patch_mutex);
+}
+
+/* fold the per layer timings of this tick into the canvas counters */
+static void conference_video_canvas_timing(mcu_canvas_t *canvas, switch_time_t encode_time)
+{
+	switch_time_t scale_time = 0, patch_time = 0;
+	int i;
+
+	for (i = 0; i < MCU_MAX_LAYERS; i++) {
+		mcu_layer_t *layer = &canvas->layers[i];
+
+		scale_time += layer->scale_time;
+		patch_time += layer->patch_time;
+		canvas->stat_patched += layer->patched;
+		canvas->stat_skipped += layer->skipped;
+		layer->scale_time = layer->patch_time = 0;
+		layer->patched = layer->skipped = 0;
+	}
+
+	canvas->last_scale_time = scale_time;
+	canvas->last_patch_time = patch_time;
+	canvas->last_encode_time = encode_time;
+	canvas->stat_scale_time += scale_time;
+	canvas->stat_patch_time += patch_time;
+	canvas->stat_encode_time += encode_time;
+	canvas->stat_frames++;
+}
+
 void conference_video_set_canvas_bgcolor(mcu_canvas_t *canvas, char *color)
 {
 	switch_color_set_rgb(&canvas->bgcolor, color);
 	conference_video_reset_image(canvas->img, &canvas->bgcolor);
+	conference_video_dirty_layers(canvas);
 }
 
 void conference_video_set_canvas_letterbox_bgcolor(mcu_canvas_t *canvas, char *color)
@@ -710,6 +901,7 @@ void conference_video_layer_set_logo(conference_member_t *member, mcu_layer_t *l
 	if (path) {
 		switch_img_free(&layer->logo_img);
 		switch_img_free(&layer->logo_text_img);
+		layer->dirty = 1;
 	}
 
 	if (*path == '{') {
@@ -734,6 +926,7 @@ void conference_video_layer_set_logo(conference_member_t *member, mcu_layer_t *l
 		member->video_logo = NULL;
 		switch_img_fill(layer->canvas->img, layer->x_pos, layer->y_pos, layer->screen_w, layer->screen_h,
 						&layer->canvas->letterbox_bgcolor);
+		layer->dirty = 1;
 
 		goto end;
 	}
@@ -789,6 +982,7 @@ void conference_video_layer_set_banner(conference_member_t *member, mcu_layer_t
 	const char *font_face = NULL;
 	const char *var, *tmp = NULL;
 	char *dup = NULL;
+	char key[512] = "";
 
 	switch_mutex_lock(layer->canvas->mutex);
 
@@ -818,9 +1012,11 @@ void conference_video_layer_set_banner(conference_member_t *member, mcu_layer_t
 	if (zstr(text) || !strcasecmp(text, "clear") || !strcasecmp(text, "allclear")) {
 		switch_img_free(&layer->banner_img);
 		layer->banner_patched = 0;
+		layer->banner_key[0] = '\0';
 
 		switch_img_fill(layer->canvas->img, layer->x_pos, layer->y_pos, layer->screen_w, layer->screen_h,
 						&layer->canvas->letterbox_bgcolor);
+		layer->dirty = 1;
 
 		if (zstr(text) || !strcasecmp(text, "allclear")) {
 			switch_channel_set_variable(member->channel, "video_banner_text", NULL);
@@ -861,6 +1057,13 @@ void conference_video_layer_set_banner(conference_member_t *member, mcu_layer_t
 		font_size = (uint16_t)((double)(font_scale / 100.0f) * layer->screen_w);
 	}
 
+	switch_snprintf(key, sizeof(key), "%s:%s:%s:%u:%u:%s", fg, bg, switch_str_nil(font_face), font_size, layer->screen_w, text);
+
+	/* same text, colors, font and size as the banner we already have, nothing to render */
+	if (layer->banner_img && !strcmp(layer->banner_key, key)) {
+		goto end;
+	}
+
 	switch_color_set_rgb(&fgcolor, fg);
 	switch_color_set_rgb(&bgcolor, bg);
 
@@ -873,9 +1076,11 @@ void conference_video_layer_set_banner(conference_member_t *member, mcu_layer_t
 	if (!layer->txthandle) {
 		switch_img_free(&layer->banner_img);
 		layer->banner_patched = 0;
+		layer->banner_key[0] = '\0';
 
 		switch_img_fill(layer->canvas->img, layer->x_pos, layer->y_pos, layer->screen_w, layer->screen_h,
 						&layer->canvas->letterbox_bgcolor);
+		layer->dirty = 1;
 
 		goto end;
 	}
@@ -887,6 +1092,8 @@ void conference_video_layer_set_banner(conference_member_t *member, mcu_layer_t
 
 	conference_video_reset_image(layer->banner_img, &bgcolor);
 	switch_img_txt_handle_render(layer->txthandle, layer->banner_img, font_size / 2, font_size / 2, text, NULL, fg, bg, 0, 0);
+	switch_set_string(layer->banner_key, key);
+	layer->dirty = 1;
 
  end:
 
@@ -999,6 +1206,7 @@ switch_status_t conference_video_attach_video_layer(conference_member_t *member,
 	}
 
 	switch_img_fill(canvas->img, layer->x_pos, layer->y_pos, layer->screen_w, layer->screen_h, &canvas->letterbox_bgcolor);
+	layer->dirty = 1;
 	conference_video_reset_video_bitrate_counters(member);
 	conference_video_clear_managed_kps(member);
 
@@ -1134,6 +1342,7 @@ switch_status_t conference_video_set_canvas_bgimg(mcu_canvas_t *canvas, const ch
 	}
 	switch_img_find_position(POS_CENTER_MID, canvas->img->d_w, canvas->img->d_h, canvas->bgimg->d_w, canvas->bgimg->d_h, &x, &y);
 	switch_img_patch(canvas->img, canvas->bgimg, x, y);
+	conference_video_dirty_layers(canvas);
 
 	return SWITCH_STATUS_SUCCESS;
 }
@@ -1226,6 +1435,7 @@ void conference_video_destroy_canvas(mcu_canvas_t **canvasP) {
 
 	for (i = 0; i < MCU_MAX_LAYERS; i++) {
 		switch_img_free(&canvas->layers[i].img);
+		switch_img_free(&canvas->layers[i].mute_banner_img);
 	}
 
 	*canvasP = NULL;
@@ -1239,7 +1449,7 @@ void conference_video_write_canvas_image_to_codec_group(conference_obj_t *confer
 	conference_member_t *imember;
 	switch_frame_t write_frame = { 0 }, *frame = NULL;
 	switch_status_t encode_status = SWITCH_STATUS_FALSE;
-	switch_image_t *scaled_img = codec_set->scaled_img;
+	switch_image_t *scaled_img = NULL;
 
 	write_frame = codec_set->frame;
 	frame = &write_frame;
@@ -1261,14 +1471,16 @@ void conference_video_write_canvas_image_to_codec_group(conference_obj_t *confer
 		switch_core_codec_control(&codec_set->codec, SCC_VIDEO_GEN_KEYFRAME, SCCT_NONE, NULL, SCCT_NONE, NULL, NULL, NULL);
 	}
 
-	if (scaled_img) {
+	if (codec_set->scaled_img) {
 		if (!send_keyframe && codec_set->fps_divisor > 1 && (codec_set->frame_count++) % codec_set->fps_divisor) {
 			// switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Skip one frame, total: %d\n", codec_set->frame_count);
 			return;
 		}
 
-		switch_img_scale(frame->img, &scaled_img, scaled_img->d_w, scaled_img->d_h);
-		frame->img = scaled_img;
+		/* groups scaling to the same size share one scale of this canvas frame */
+		if ((scaled_img = switch_img_scale_cached(frame->img, codec_set->generation, codec_set->scaled_img->d_w, codec_set->scaled_img->d_h))) {
+			frame->img = scaled_img;
+		}
 	}
 
 	do {
@@ -1340,6 +1552,240 @@ void conference_video_write_canvas_image_to_codec_group(conference_obj_t *confer
 		}
 
 	} while(encode_status == SWITCH_STATUS_MORE_DATA);
+
+	switch_img_scale_release(&scaled_img);
+}
+
+void conference_video_parse_encode_tiers(conference_obj_t *conference, const char *tiers)
+{
+	char *dup, *argv[CONF_MAX_ENCODE_TIERS] = { 0 };
+	int argc, i, j;
+
+	dup = switch_core_strdup(conference->pool, tiers);
+	argc = switch_separate_string(dup, ',', argv, (sizeof(argv) / sizeof(argv[0])));
+
+	conference->encode_tier_count = 0;
+
+	for (i = 0; i < argc; i++) {
+		conference_encode_tier_t tier = { 0 };
+		char *p;
+
+		if ((p = strchr(argv[i], '@'))) {
+			*p++ = '\0';
+			tier.width = atoi(p);
+
+			if ((p = strchr(p, 'x'))) {
+				tier.height = atoi(p + 1);
+			}
+
+			if (tier.width < 2 || tier.height < 2) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Invalid size for video encode tier %s, using the canvas size\n", argv[i]);
+				tier.width = tier.height = 0;
+			}
+		}
+
+		if ((tier.bandwidth = switch_parse_bandwidth_string(argv[i])) <= 0) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Invalid bandwidth for video encode tier %s\n", argv[i]);
+			continue;
+		}
+
+		/* keep them sorted from the highest bandwidth down */
+		for (j = conference->encode_tier_count; j > 0 && conference->encode_tiers[j - 1].bandwidth < tier.bandwidth; j--) {
+			conference->encode_tiers[j] = conference->encode_tiers[j - 1];
+		}
+
+		conference->encode_tiers[j] = tier;
+		conference->encode_tier_count++;
+	}
+}
+
+/* pick the first tier the downlink of the member can take, REMB/TMMBR feedback first and the configured max out bandwidth as a cap */
+static int conference_video_member_encode_tier(conference_member_t *member)
+{
+	conference_obj_t *conference = member->conference;
+	int kbps, bw, tier;
+
+	if (conference->encode_tier_count < 2) {
+		return 0;
+	}
+
+	kbps = (int)(switch_core_media_get_remote_bitrate(member->session, SWITCH_MEDIA_TYPE_VIDEO) / 1000);
+
+	if (member->max_bw_out > 0 && (!kbps || member->max_bw_out < kbps)) {
+		kbps = member->max_bw_out;
+	}
+
+	if (!kbps) {
+		return 0;
+	}
+
+	for (tier = 0; tier < conference->encode_tier_count - 1; tier++) {
+		bw = conference->encode_tiers[tier].bandwidth;
+
+		/* moving back up takes a little headroom so members do not bounce between two tiers */
+		if (tier < member->video_encode_tier) {
+			bw += bw / 10;
+		}
+
+		if (kbps >= bw) {
+			break;
+		}
+	}
+
+	return tier;
+}
+
+static conference_encode_frame_t *conference_video_encode_frame_create(mcu_canvas_t *canvas, switch_image_t *img, uint64_t generation, uint32_t timestamp,
+																		  switch_bool_t need_refresh, switch_bool_t send_keyframe, switch_bool_t need_reset)
+{
+	conference_encode_frame_t *ef;
+
+	switch_zmalloc(ef, sizeof(*ef));
+
+	switch_img_copy(img, &ef->img);
+	ef->generation = generation;
+	ef->timestamp = timestamp;
+	ef->need_refresh = need_refresh;
+	ef->send_keyframe = send_keyframe;
+	ef->need_reset = need_reset;
+	ef->bandwidth = canvas->video_write_bandwidth;
+	ef->refs = 1;
+
+	return ef;
+}
+
+static void conference_video_encode_frame_release(mcu_canvas_t *canvas, conference_encode_frame_t **efP)
+{
+	conference_encode_frame_t *ef = *efP;
+	int refs;
+
+	*efP = NULL;
+
+	if (!ef) {
+		return;
+	}
+
+	switch_mutex_lock(canvas->encode_mutex);
+	refs = --ef->refs;
+	switch_mutex_unlock(canvas->encode_mutex);
+
+	if (!refs) {
+		switch_img_free(&ef->img);
+		free(ef);
+	}
+}
+
+/* hand the frame to the encoder thread of the group, a frame it has not started on yet is dropped for the newer one */
+static void conference_video_queue_encode(codec_set_t *codec_set, conference_encode_frame_t *ef)
+{
+	conference_encode_frame_t *old;
+
+	switch_mutex_lock(codec_set->canvas->encode_mutex);
+	ef->refs++;
+	switch_mutex_unlock(codec_set->canvas->encode_mutex);
+
+	switch_mutex_lock(codec_set->mutex);
+	if ((old = codec_set->pending)) {
+		codec_set->dropped++;
+
+		if (old->send_keyframe || old->need_reset) {
+			codec_set->missed_keyframe = SWITCH_TRUE;
+		}
+	}
+	codec_set->pending = ef;
+	switch_thread_cond_signal(codec_set->cond);
+	switch_mutex_unlock(codec_set->mutex);
+
+	conference_video_encode_frame_release(codec_set->canvas, &old);
+}
+
+static void *SWITCH_THREAD_FUNC conference_video_encode_thread_run(switch_thread_t *thread, void *obj)
+{
+	codec_set_t *codec_set = (codec_set_t *) obj;
+	mcu_canvas_t *canvas = codec_set->canvas;
+	conference_encode_frame_t *ef = NULL;
+	switch_bool_t send_keyframe;
+	switch_time_t start;
+
+	switch_mutex_lock(codec_set->mutex);
+
+	while (codec_set->running) {
+		if (!(ef = codec_set->pending)) {
+			switch_thread_cond_wait(codec_set->cond, codec_set->mutex);
+			continue;
+		}
+
+		codec_set->pending = NULL;
+		send_keyframe = ef->send_keyframe || codec_set->missed_keyframe;
+		codec_set->missed_keyframe = SWITCH_FALSE;
+		switch_mutex_unlock(codec_set->mutex);
+
+		start = switch_time_now();
+
+		if (ef->bandwidth) {
+			switch_core_codec_control(&codec_set->codec, SCC_VIDEO_BANDWIDTH, SCCT_INT, &ef->bandwidth, SCCT_NONE, NULL, NULL, NULL);
+		}
+
+		codec_set->frame.img = ef->img;
+		codec_set->generation = ef->generation;
+		conference_video_write_canvas_image_to_codec_group(canvas->conference, canvas, codec_set, codec_set->codec_index,
+														   ef->timestamp, ef->need_refresh, send_keyframe, ef->need_reset);
+		codec_set->frame.img = NULL;
+		codec_set->encode_time = switch_time_now() - start;
+
+		conference_video_encode_frame_release(canvas, &ef);
+
+		switch_mutex_lock(codec_set->mutex);
+	}
+
+	ef = codec_set->pending;
+	codec_set->pending = NULL;
+	switch_mutex_unlock(codec_set->mutex);
+
+	conference_video_encode_frame_release(canvas, &ef);
+
+	return NULL;
+}
+
+static void conference_video_start_encode_thread(mcu_canvas_t *canvas, codec_set_t *codec_set, int codec_index)
+{
+	switch_threadattr_t *thd_attr = NULL;
+
+	if (!canvas->encode_mutex) {
+		switch_mutex_init(&canvas->encode_mutex, SWITCH_MUTEX_NESTED, canvas->pool);
+	}
+
+	codec_set->canvas = canvas;
+	codec_set->codec_index = codec_index;
+	switch_mutex_init(&codec_set->mutex, SWITCH_MUTEX_NESTED, canvas->pool);
+	switch_thread_cond_create(&codec_set->cond, canvas->pool);
+	codec_set->running = 1;
+
+	switch_threadattr_create(&thd_attr, canvas->pool);
+	switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+
+	if (switch_thread_create(&codec_set->thread, thd_attr, conference_video_encode_thread_run, codec_set, canvas->pool) != SWITCH_STATUS_SUCCESS) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Cannot start encoder thread for slot %d, encoding on the canvas thread\n", codec_index);
+		codec_set->thread = NULL;
+		codec_set->running = 0;
+	}
+}
+
+static void conference_video_stop_encode_thread(codec_set_t *codec_set)
+{
+	switch_status_t st;
+
+	if (!codec_set->thread) {
+		return;
+	}
+
+	switch_mutex_lock(codec_set->mutex);
+	codec_set->running = 0;
+	switch_thread_cond_signal(codec_set->cond);
+	switch_mutex_unlock(codec_set->mutex);
+
+	switch_thread_join(&st, codec_set->thread);
+	codec_set->thread = NULL;
 }
 
 video_layout_t *conference_video_find_best_layout(conference_obj_t *conference, layout_group_t *lg, uint32_t count)
@@ -1527,9 +1973,6 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_write_thread_run(switch_thread_
 
 	while(conference_utils_member_test_flag(member, MFLAG_RUNNING)) {
 		if (switch_queue_pop(member->mux_out_queue, &pop) == SWITCH_STATUS_SUCCESS) {
-			mcu_layer_t *layer = NULL;
-			mcu_canvas_t *canvas = NULL;
-
 			if (!pop) {
 				break;
 			}
@@ -1541,60 +1984,36 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_write_thread_run(switch_thread_
 
 			loops++;
 			
-			if ((switch_size_t)pop != 1) {
-				frame = (switch_frame_t *) pop;
-				if (switch_test_flag(frame, SFF_ENCODED)) {
-					switch_core_session_write_encoded_video_frame(member->session, frame, 0, 0);
-				} else {
-					switch_core_session_write_video_frame(member->session, frame, SWITCH_IO_FLAG_NONE, 0);
-				}
+			frame = (switch_frame_t *) pop;
+			if (switch_test_flag(frame, SFF_ENCODED)) {
+				switch_core_session_write_encoded_video_frame(member->session, frame, 0, 0);
+			} else {
+				switch_core_session_write_video_frame(member->session, frame, SWITCH_IO_FLAG_NONE, 0);
+			}
 
-				if (!switch_test_flag(frame, SFF_ENCODED) || frame->m) {
-					switch_time_t now = switch_time_now();
-					
-					if (last) {
-						int delta = (int)(now - last);
-						if (delta > member->conference->video_fps.ms * 5000) {
-							switch_core_session_request_video_refresh(member->session);							
-						}
+			if (!switch_test_flag(frame, SFF_ENCODED) || frame->m) {
+				switch_time_t now = switch_time_now();
+				
+				if (last) {
+					int delta = (int)(now - last);
+					if (delta > member->conference->video_fps.ms * 5000) {
+						switch_core_session_request_video_refresh(member->session);							
 					}
-
-					last = now;
-
-					
 				}
 
-				switch_frame_buffer_free(member->fb, &frame);
-			}
+				last = now;
 
-			canvas = NULL;                                                                                                                              
-			layer = NULL;
-			
-			switch_mutex_lock(member->conference->canvas_mutex);
-			if (member->video_layer_id > -1 && member->canvas_id > -1) {
-				canvas = member->conference->canvases[member->canvas_id];
-				layer = &canvas->layers[member->video_layer_id];
-
-				if (layer->need_patch && switch_thread_rwlock_tryrdlock(canvas->video_rwlock) == SWITCH_STATUS_SUCCESS) {
-					if (layer->need_patch) {
-						conference_video_scale_and_patch(layer, NULL, SWITCH_FALSE);
-						layer->need_patch = 0;
-					}
-					switch_thread_rwlock_unlock(canvas->video_rwlock);
-				}
+				
 			}
-			switch_mutex_unlock(member->conference->canvas_mutex);
-			
-			
+
+			switch_frame_buffer_free(member->fb, &frame);
 		}
 	}
 
 	while (switch_queue_trypop(member->mux_out_queue, &pop) == SWITCH_STATUS_SUCCESS) {
 		if (pop) {
-			if ((switch_size_t)pop != 1) {
-				frame = (switch_frame_t *) pop;
-				switch_frame_buffer_free(member->fb, &frame);
-			}
+			frame = (switch_frame_t *) pop;
+			switch_frame_buffer_free(member->fb, &frame);
 		}
 	}
 
@@ -1615,8 +2034,8 @@ void conference_video_member_video_mute_banner(mcu_canvas_t *canvas, mcu_layer_t
 	const char *font_scale_percentage = "";
 	char *parsed = NULL;
 	switch_event_t *params = NULL;
-	switch_image_t *text_img;
 	char text_str[256] = "";
+	char key[512] = "";
 
 	if ((var = switch_channel_get_variable_dup(member->channel, "video_mute_banner", SWITCH_FALSE, -1))) {
 		text = var;
@@ -1659,9 +2078,20 @@ void conference_video_member_video_mute_banner(mcu_canvas_t *canvas, mcu_layer_t
 	}
 
 	switch_snprintf(text_str, sizeof(text_str), "%s:%s:%s:%s%s:%s", fg, bg, font_face, font_scale, font_scale_percentage, text);
-	text_img = switch_img_write_text_img(layer->screen_w, layer->screen_h, SWITCH_TRUE, text_str);
-	switch_img_patch(canvas->img, text_img, layer->x_pos, layer->y_pos);
-	switch_img_free(&text_img);
+	switch_snprintf(key, sizeof(key), "%ux%u:%s", layer->screen_w, layer->screen_h, text_str);
+
+	/* the banner only changes with its text or the layer size so keep the last render around */
+	if (!layer->mute_banner_img || strcmp(layer->mute_banner_key, key)) {
+		switch_img_free(&layer->mute_banner_img);
+		layer->mute_banner_img = switch_img_write_text_img(layer->screen_w, layer->screen_h, SWITCH_TRUE, text_str);
+		switch_set_string(layer->mute_banner_key, key);
+	}
+
+	if (layer->mute_banner_img) {
+		switch_img_patch(canvas->img, layer->mute_banner_img, layer->x_pos, layer->y_pos);
+	}
+
+	layer->dirty = 1;
 
 	if (params) switch_event_destroy(&params);
 
@@ -1792,6 +2222,7 @@ void conference_video_patch_fnode(mcu_canvas_t *canvas, conference_file_node_t *
 		if (status == SWITCH_STATUS_SUCCESS) {
 			switch_img_free(&layer->cur_img);
 			layer->cur_img = file_frame.img;
+			layer->dirty = 1;
 			layer->tagged = 1;
 		} else if (status == SWITCH_STATUS_IGNORE) {
 			if (canvas && fnode->layer_id > -1 ) {
@@ -2163,32 +2594,6 @@ void conference_video_check_auto_bitrate(conference_member_t *member, mcu_layer_
 	}
 }
 
-static void wait_for_canvas(mcu_canvas_t *canvas)
-{
-	for (;;) {
-		int x = 0;
-		int i = 0;
-
-		for (i = 0; i < canvas->total_layers; i++) {
-			mcu_layer_t *layer = &canvas->layers[i];
-					
-			if (layer->need_patch) {
-				if (layer->member) {
-					switch_queue_trypush(layer->member->mux_out_queue, (void *) 1);
-					x++;
-				} else {
-					layer->need_patch = 0;
-				}
-			}
-		}
-
-		if (!x) break;
-		switch_cond_next();
-		switch_thread_rwlock_wrlock(canvas->video_rwlock);
-		switch_thread_rwlock_unlock(canvas->video_rwlock);
-	}
-}
-
 static void personal_attach(mcu_layer_t *layer, conference_member_t *member)
 {
 	layer->tagged = 1;
@@ -2198,6 +2603,7 @@ static void personal_attach(mcu_layer_t *layer, conference_member_t *member)
 
 		layer->mute_patched = 0;
 		layer->avatar_patched = 0;
+		layer->dirty = 1;
 		switch_img_free(&layer->banner_img);
 		switch_img_free(&layer->logo_img);
 		
@@ -2253,10 +2659,12 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 	canvas->video_layout_group = conference->video_layout_group;
 
 	packet = switch_core_alloc(conference->pool, SWITCH_RTP_MAX_BUF_LEN);
+
+	conference_video_start_patch_threads(canvas);
 	
 	while (conference_globals.running && !conference_utils_test_flag(conference, CFLAG_DESTRUCT) && conference_utils_test_flag(conference, CFLAG_VIDEO_MUXING)) {
 		switch_bool_t need_refresh = SWITCH_FALSE, send_keyframe = SWITCH_FALSE, need_reset = SWITCH_FALSE;
-		switch_time_t now;
+		switch_time_t now, encode_time;
 		int min_members = 0;
 		int count_changed = 0;
 		int file_count = 0, check_async_file = 0, check_file = 0;
@@ -2428,9 +2836,19 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 				min_members++;
 
 				if (switch_channel_test_flag(imember->channel, CF_VIDEO_READY)) {
+					int tier = conference_video_member_encode_tier(imember);
+
+					if (tier != imember->video_encode_tier) {
+						switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(imember->session), SWITCH_LOG_DEBUG, "%s moving from encode tier %d to %d\n",
+										  switch_channel_get_name(imember->channel), imember->video_encode_tier, tier);
+						imember->video_encode_tier = tier;
+						imember->video_codec_index = -1;
+					}
+
 					if (imember->video_codec_index < 0 && (check_codec = switch_core_session_get_video_write_codec(imember->session))) {
 						for (i = 0; write_codecs[i] && switch_core_codec_ready(&write_codecs[i]->codec) && i < MAX_MUX_CODECS; i++) {
-							if (check_codec->implementation->codec_id == write_codecs[i]->codec.implementation->codec_id) {
+							if (check_codec->implementation->codec_id == write_codecs[i]->codec.implementation->codec_id &&
+								write_codecs[i]->tier == imember->video_encode_tier) {
 								imember->video_codec_index = i;
 								imember->video_codec_id = check_codec->implementation->codec_id;
 								need_refresh = SWITCH_TRUE;
@@ -2453,7 +2871,17 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 								write_codecs[i]->frame.data = ((uint8_t *)write_codecs[i]->frame.packet) + 12;
 								write_codecs[i]->frame.packetlen = buflen;
 								write_codecs[i]->frame.buflen = buflen - 12;
-								if (conference->scale_h264_canvas_width > 0 && conference->scale_h264_canvas_height > 0 && !strcmp(check_codec->implementation->iananame, "H264")) {
+								write_codecs[i]->tier = imember->video_encode_tier;
+
+								if (conference->encode_tier_count) {
+									conference_encode_tier_t *etier = &conference->encode_tiers[write_codecs[i]->tier];
+
+									if (etier->width && etier->height) {
+										write_codecs[i]->scaled_img = switch_img_alloc(NULL, SWITCH_IMG_FMT_I420, etier->width, etier->height, 16);
+									}
+
+									switch_core_codec_control(&write_codecs[i]->codec, SCC_VIDEO_BANDWIDTH, SCCT_INT, &etier->bandwidth, SCCT_NONE, NULL, NULL, NULL);
+								} else if (conference->scale_h264_canvas_width > 0 && conference->scale_h264_canvas_height > 0 && !strcmp(check_codec->implementation->iananame, "H264")) {
 									int32_t bw = -1;
 
 									write_codecs[i]->fps_divisor = conference->scale_h264_canvas_fps_divisor;
@@ -2476,6 +2904,7 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 									switch_core_codec_control(&write_codecs[i]->codec, SCC_VIDEO_BANDWIDTH, SCCT_INT, &bw, SCCT_NONE, NULL, NULL, NULL);
 								}
 								switch_set_flag((&write_codecs[i]->frame), SFF_RAW_RTP);
+								conference_video_start_encode_thread(canvas, write_codecs[i], i);
 
 							}
 						}
@@ -2546,6 +2975,8 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 						//layer->is_avatar = 1;
 						switch_img_free(&layer->cur_img);
 						switch_img_copy(imember->avatar_png_img, &layer->cur_img);
+						/* the copy can land where the old image was, don't let the unchanged check skip it */
+						layer->dirty = 1;
 						imember->avatar_patched = 1;
 					}
 				}
@@ -2615,6 +3046,7 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 					if (img != layer->cur_img) {
 						switch_img_free(&layer->cur_img);
 						layer->cur_img = img;
+						layer->dirty = 1;
 					}
 
 
@@ -2774,6 +3206,7 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 					while (i < imember->canvas->total_layers) {
 						layer = &imember->canvas->layers[i++];
 						switch_img_fill(layer->canvas->img, layer->x_pos, layer->y_pos, layer->screen_w, layer->screen_h, &layer->canvas->bgcolor);
+						layer->dirty = 1;
 					}
 					i = 0;
 				}
@@ -2955,6 +3388,9 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 			}
 
 			if (!conference->playing_video_file) {
+				/* the canvas stays locked until every layer is on it, the patch threads work on their own layer rectangles */
+				switch_mutex_lock(canvas->mutex);
+
 				for (i = 0; i < canvas->total_layers; i++) {
 					mcu_layer_t *layer = &canvas->layers[i];
 
@@ -2964,20 +3400,16 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 							canvas->refresh++;
 						}
 
-						if (layer->cur_img) {
-							if (layer->member && switch_core_cpu_count() > 2) {
-								layer->need_patch = 1;
-							} else {
-								conference_video_scale_and_patch(layer, NULL, SWITCH_FALSE);
-							}
-						}
+						layer->dirty = 1;
+						conference_video_queue_patch(canvas, layer);
 
 						layer->tagged = 0;
 					}
 				}
 
-				wait_for_canvas(canvas);
+				conference_video_wait_for_patches(canvas);
 
+				/* overlapping layers go on top in order */
 				for (i = 0; i < canvas->total_layers; i++) {
 					mcu_layer_t *layer = &canvas->layers[i];
 
@@ -2987,15 +3419,16 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 							canvas->refresh++;
 						}
 
-						if (layer->cur_img) {
-							if (layer->member) {
-								layer->need_patch = 1;
-							} else {
-								conference_video_scale_and_patch(layer, NULL, SWITCH_FALSE);
-							}
+						if (layer->tagged) {
+							layer->dirty = 1;
+							layer->tagged = 0;
 						}
+
+						conference_video_scale_and_patch_locked(layer, NULL, SWITCH_FALSE);
 					}
 				}
+
+				switch_mutex_unlock(canvas->mutex);
 			}
 
 			if (canvas->refresh > 1) {
@@ -3044,8 +3477,6 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 			
 			write_frame.img = write_img;
 
-			wait_for_canvas(canvas);
-			
 			if (canvas->recording) {
 				conference_video_check_recording(conference, canvas, &write_frame);
 			}
@@ -3060,9 +3491,27 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 				}
 			}
 
+			encode_time = switch_time_now();
+
 			if (min_members && conference_utils_test_flag(conference, CFLAG_MINIMIZE_VIDEO_ENCODING)) {
+				conference_encode_frame_t *ef = NULL;
+				switch_time_t thread_encode_time = 0;
+				uint64_t generation = switch_img_scale_generation();
+
 				for (i = 0; write_codecs[i] && switch_core_codec_ready(&write_codecs[i]->codec) && i < MAX_MUX_CODECS; i++) {
+					/* groups with their own encoder thread get a copy of the canvas so compositing can go on */
+					if (write_codecs[i]->thread) {
+						if (!ef) {
+							ef = conference_video_encode_frame_create(canvas, write_img, generation, timestamp, need_refresh, send_keyframe, need_reset);
+						}
+
+						conference_video_queue_encode(write_codecs[i], ef);
+						thread_encode_time += write_codecs[i]->encode_time;
+						continue;
+					}
+
 					write_codecs[i]->frame.img = write_img;
+					write_codecs[i]->generation = generation;
 					conference_video_write_canvas_image_to_codec_group(conference, canvas, write_codecs[i], i,
 																	   timestamp, need_refresh, send_keyframe, need_reset);
 
@@ -3073,7 +3522,16 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 					}
 
 				}
+
+				if (ef) {
+					canvas->video_write_bandwidth = 0;
+					conference_video_encode_frame_release(canvas, &ef);
+				}
+
+				encode_time -= thread_encode_time;
 			}
+
+			conference_video_canvas_timing(canvas, switch_time_now() - encode_time);
 			
 			switch_mutex_lock(conference->member_mutex);
 			for (imember = conference->members; imember; imember = imember->next) {
@@ -3130,6 +3588,8 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 		} // NOT PERSONAL
 	}
 
+	conference_video_stop_patch_threads(canvas);
+
 	switch_img_free(&file_img);
 
 	for (i = 0; i < MCU_MAX_LAYERS; i++) {
@@ -3151,6 +3611,10 @@ void *SWITCH_THREAD_FUNC conference_video_muxing_thread_run(switch_thread_t *thr
 	}
 
 	for (i = 0; i < MAX_MUX_CODECS; i++) {
+		if (write_codecs[i]) {
+			conference_video_stop_encode_thread(write_codecs[i]);
+		}
+
 		if (write_codecs[i] && switch_core_codec_ready(&write_codecs[i]->codec)) {
 			switch_core_codec_destroy(&write_codecs[i]->codec);
 			switch_img_free(&(write_codecs[i]->scaled_img));
@@ -3386,6 +3850,7 @@ void *SWITCH_THREAD_FUNC conference_video_super_muxing_thread_run(switch_thread_
 
 					switch_img_free(&layer->cur_img);
 					layer->cur_img = img;
+					layer->dirty = 1;
 					img = NULL;
 				}
 
@@ -3805,6 +4270,22 @@ void conference_video_write_frame(conference_obj_t *conference, conference_membe
 	switch_img_free(&tmp_frame.img);
 }
 
+/* Members that are not on any layer don't need their video decoded, pick it back up with a key frame once they are shown */
+static void conference_video_check_decode_pause(conference_member_t *member)
+{
+	int visible = (member->video_layer_id > -1 || member->canvas) &&
+		conference_utils_member_test_flag(member, MFLAG_CAN_BE_SEEN) && !member->conference->playing_video_file;
+
+	if (visible) {
+		if (switch_channel_test_flag(member->channel, CF_VIDEO_DECODE_PAUSE)) {
+			switch_channel_clear_flag(member->channel, CF_VIDEO_DECODE_PAUSE);
+			switch_core_session_request_video_refresh(member->session);
+		}
+	} else if (!switch_channel_test_flag(member->channel, CF_VIDEO_DECODE_PAUSE)) {
+		switch_channel_set_flag(member->channel, CF_VIDEO_DECODE_PAUSE);
+	}
+}
+
 switch_status_t conference_video_thread_callback(switch_core_session_t *session, switch_frame_t *frame, void *user_data)
 {
 	//switch_channel_t *channel = switch_core_session_get_channel(session);
@@ -3840,6 +4321,8 @@ switch_status_t conference_video_thread_callback(switch_core_session_t *session,
 	if (conference_utils_test_flag(member->conference, CFLAG_VIDEO_MUXING)) {
 		switch_image_t *img_copy = NULL;
 
+		conference_video_check_decode_pause(member);
+
 		if (frame->img && (member->video_layer_id > -1 || member->canvas) && 
 			conference_utils_member_test_flag(member, MFLAG_CAN_BE_SEEN) &&
 			switch_queue_size(member->video_queue) < member->conference->video_fps.fps * 2 &&
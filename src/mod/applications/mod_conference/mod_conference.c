@@ -190,6 +190,157 @@ void conference_send_notify(conference_obj_t *conference, const char *status, co
 }
 
 
+/* Rank the members producing audio by score_iir and flag the loudest few, only they are summed into the mix */
+static void conference_set_active_speakers(conference_obj_t *conference)
+{
+	conference_member_t *speakers[CONF_MAX_ACTIVE_SPEAKERS] = { 0 };
+	conference_member_t *imember;
+	int count = 0, max = conference->max_active_speakers, i;
+
+	for (imember = conference->members; imember; imember = imember->next) {
+		conference_utils_member_clear_flag(imember, MFLAG_ACTIVE_SPEAKER);
+
+		if (!(conference_utils_member_test_flag(imember, MFLAG_RUNNING) && conference_utils_member_test_flag(imember, MFLAG_HAS_AUDIO))) {
+			continue;
+		}
+
+		for (i = count; i > 0 && speakers[i - 1]->score_iir < imember->score_iir; i--) {
+			if (i < max) {
+				speakers[i] = speakers[i - 1];
+			}
+		}
+
+		if (i < max) {
+			speakers[i] = imember;
+			if (count < max) {
+				count++;
+			}
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		conference_utils_member_set_flag(speakers[i], MFLAG_ACTIVE_SPEAKER);
+	}
+}
+
+/* Attach a listener to the shared encoder for its write codec, returns SWITCH_FALSE when it has to be fed through its own mux buffer */
+static switch_bool_t conference_audio_codec_join(conference_obj_t *conference, conference_member_t *member)
+{
+	switch_codec_t *check_codec;
+	const switch_codec_implementation_t *impl;
+	audio_codec_set_t *codec_set = NULL;
+	int i;
+
+	if (!member->session || member->volume_out_level || member->fnode || member->read_impl.number_of_channels != conference->channels ||
+		conference_utils_member_test_flag(member, MFLAG_NOCHANNEL) || conference_utils_member_test_flag(member, MFLAG_POSITIONAL) ||
+		!(check_codec = switch_core_session_get_write_codec(member->session)) || !switch_core_codec_ready(check_codec)) {
+		goto nogroup;
+	}
+
+	/* the core decodes written frames for media bugs on the frame codec, that must not be the shared encoder */
+	if (switch_core_media_bug_count(member->session, NULL)) {
+		goto nogroup;
+	}
+
+	impl = check_codec->implementation;
+
+	/* the output loop sends one encoded frame per conference tick, anything else needs the per member path */
+	if (impl->microseconds_per_packet != (int) conference->interval * 1000 ||
+		member->read_impl.microseconds_per_packet != impl->microseconds_per_packet || impl->number_of_channels != conference->channels) {
+		goto nogroup;
+	}
+
+	for (i = 0; i < MAX_MUX_CODECS && conference->audio_codecs[i]; i++) {
+		if (conference->audio_codecs[i]->impl == impl && !strcmp(switch_str_nil(conference->audio_codecs[i]->fmtp), switch_str_nil(check_codec->fmtp_in))) {
+			codec_set = conference->audio_codecs[i];
+			break;
+		}
+	}
+
+	if (!codec_set) {
+		if (i == MAX_MUX_CODECS) {
+			goto nogroup;
+		}
+
+		codec_set = switch_core_alloc(conference->pool, sizeof(*codec_set));
+		codec_set->impl = impl;
+		codec_set->fmtp = check_codec->fmtp_in ? switch_core_strdup(conference->pool, check_codec->fmtp_in) : NULL;
+		switch_mutex_init(&codec_set->mutex, SWITCH_MUTEX_NESTED, conference->pool);
+		conference->audio_codecs[i] = codec_set;
+
+		if (switch_core_codec_copy(check_codec, &codec_set->codec, NULL, conference->pool) != SWITCH_STATUS_SUCCESS) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Unable to set up audio write codec %s at slot %d\n", impl->iananame, i);
+		} else if ((uint32_t) impl->actual_samples_per_second != conference->rate &&
+				   switch_resample_create(&codec_set->resampler, conference->rate, impl->actual_samples_per_second,
+										  SWITCH_RECOMMENDED_BUFFER_SIZE, SWITCH_RESAMPLE_QUALITY, conference->channels) != SWITCH_STATUS_SUCCESS) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Unable to create resampler for audio write codec %s\n", impl->iananame);
+			switch_core_codec_destroy(&codec_set->codec);
+		} else {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Setting up audio write codec %s@%dh at slot %d\n",
+							  impl->iananame, impl->actual_samples_per_second, i);
+		}
+	}
+
+	if (!switch_core_codec_ready(&codec_set->codec)) {
+		goto nogroup;
+	}
+
+	if (member->audio_codec_index != i) {
+		/* start with the next frame encoded for this group */
+		member->audio_codec_seq = codec_set->seq;
+		member->audio_codec_index = i;
+	}
+
+	codec_set->listeners++;
+
+	return SWITCH_TRUE;
+
+ nogroup:
+
+	member->audio_codec_index = -1;
+
+	return SWITCH_FALSE;
+}
+
+/* Encode the shared listener frame once per codec that has listeners this tick */
+static void conference_audio_codec_write(conference_obj_t *conference, int16_t *data, uint32_t samples)
+{
+	audio_codec_set_t *codec_set;
+	int i;
+
+	for (i = 0; i < MAX_MUX_CODECS && (codec_set = conference->audio_codecs[i]); i++) {
+		int16_t *in = data;
+		uint32_t in_samples = samples, slot, encoded_len, encoded_rate, flag = 0;
+
+		if (!codec_set->listeners || !switch_core_codec_ready(&codec_set->codec)) {
+			continue;
+		}
+
+		codec_set->listeners = 0;
+
+		if (codec_set->resampler) {
+			switch_resample_process(codec_set->resampler, data, samples);
+			in = codec_set->resampler->to;
+			in_samples = codec_set->resampler->to_len;
+		}
+
+		/* readers never lag by more than half the ring so the next slot is free to fill without the lock */
+		slot = (codec_set->seq + 1) % CONF_AUDIO_CODEC_FRAMES;
+		encoded_len = sizeof(codec_set->frames[slot]);
+		encoded_rate = codec_set->impl->actual_samples_per_second;
+
+		if (switch_core_codec_encode(&codec_set->codec, NULL, in, in_samples * 2 * conference->channels, codec_set->impl->actual_samples_per_second,
+									 codec_set->frames[slot], &encoded_len, &encoded_rate, &flag) != SWITCH_STATUS_SUCCESS || !encoded_len) {
+			continue;
+		}
+
+		switch_mutex_lock(codec_set->mutex);
+		codec_set->datalen[slot] = encoded_len;
+		codec_set->seq++;
+		switch_mutex_unlock(codec_set->mutex);
+	}
+}
+
 /* Main monitor thread (1 per distinct conference room) */
 void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *obj)
 {
@@ -207,6 +358,7 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 	int32_t z = 0;
 	int member_score_sum = 0;
 	int divisor = 0;
+	int active_speakers = 0;
 	conference_cdr_node_t *np;
 
 	if (!(divisor = conference->rate / 8000)) {
@@ -460,10 +612,19 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 			}
 		}
 
+		/* In large conferences only the loudest few members are mixed and everyone else shares one frame */
+		active_speakers = conference->max_active_speakers && !conference->relationship_total;
+
+		if (active_speakers) {
+			conference_set_active_speakers(conference);
+		}
+
 		if (ready || has_file_data) {
 			/* Use more bits in the main_frame to preserve the exact sum of the audio samples. */
-			int main_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
+			int32_t main_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
 			int16_t write_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
+			int16_t listen_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
+			int has_listen_frame = 0;
 
 
 			/* Init the main frame with file data if there is any. */
@@ -492,6 +653,10 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 					continue;
 				}
 
+				if (active_speakers && !conference_utils_member_test_flag(omember, MFLAG_ACTIVE_SPEAKER)) {
+					continue;
+				}
+
 				if (conference->agc_level) {
 					if (conference_utils_member_test_flag(omember, MFLAG_TALKING) && conference_utils_member_test_flag(omember, MFLAG_CAN_SPEAK)) {
 						member_score_sum += omember->score;
@@ -499,10 +664,7 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 					}
 				}
 
-				bptr = (int16_t *) omember->frame;
-				for (x = 0; x < omember->read / 2; x++) {
-					main_frame[x] += (int32_t) bptr[x];
-				}
+				switch_mix_sln_accumulate(main_frame, (int16_t *) omember->frame, omember->read / 2);
 			}
 
 			if (conference->agc_level && conference->member_loop_count) {
@@ -527,12 +689,14 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 			*/
 			for (omember = conference->members; omember; omember = omember->next) {
 				switch_size_t ok = 1;
+				int16_t *out_frame = write_frame;
 
 				if (!conference_utils_member_test_flag(omember, MFLAG_RUNNING)) {
 					continue;
 				}
 
 				if (!conference_utils_member_test_flag(omember, MFLAG_CAN_HEAR)) {
+					omember->audio_codec_index = -1;
 					switch_mutex_lock(omember->audio_out_mutex);
 					memset(write_frame, 255, bytes);
 					ok = switch_buffer_write(omember->mux_buffer, write_frame, bytes);
@@ -542,18 +706,38 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 
 				bptr = (int16_t *) omember->frame;
 
-				for (x = 0; x < bytes / 2 ; x++) {
-					z = main_frame[x];
+				if (active_speakers && !conference_utils_member_test_flag(omember, MFLAG_ACTIVE_SPEAKER)) {
+					/* not part of the mix, so this member hears exactly what every other listener hears */
+					if (!has_listen_frame) {
+						switch_mix_sln_unmix(listen_frame, main_frame, NULL, 0, bytes / 2);
+						has_listen_frame = 1;
+					}
 
-					/* bptr[x] represents my own contribution to this audio sample */
-					if (conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO) && x <= omember->read / 2) {
-						z -= (int32_t) bptr[x];
+					if (conference_audio_codec_join(conference, omember)) {
+						continue;
 					}
 
-					/* when there are relationships, we have to do more work by scouring all the members to see if there are any
-					   reasons why we should not be hearing a paticular member, and if not, delete their samples as well.
-					*/
-					if (conference->relationship_total) {
+					out_frame = listen_frame;
+				} else if (!conference->relationship_total) {
+					omember->audio_codec_index = -1;
+
+					/* the common case, everyone hears everyone but themselves */
+					switch_mix_sln_unmix(write_frame, main_frame,
+										 conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO) ? bptr : NULL, omember->read / 2, bytes / 2);
+				} else {
+					omember->audio_codec_index = -1;
+
+					for (x = 0; x < bytes / 2 ; x++) {
+						z = main_frame[x];
+
+						/* bptr[x] represents my own contribution to this audio sample */
+						if (conference_utils_member_test_flag(omember, MFLAG_HAS_AUDIO) && x <= omember->read / 2) {
+							z -= (int32_t) bptr[x];
+						}
+
+						/* when there are relationships, we have to do more work by scouring all the members to see if there are any
+						   reasons why we should not be hearing a paticular member, and if not, delete their samples as well.
+						*/
 						for (imember = conference->members; imember; imember = imember->next) {
 							if (imember != omember && conference_utils_member_test_flag(imember, MFLAG_HAS_AUDIO)) {
 								conference_relationship_t *rel;
@@ -577,15 +761,15 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 
 							}
 						}
-					}
 
-					/* Now we can convert to 16 bit. */
-					switch_normalize_to_16bit(z);
-					write_frame[x] = (int16_t) z;
+						/* Now we can convert to 16 bit. */
+						switch_normalize_to_16bit(z);
+						write_frame[x] = (int16_t) z;
+					}
 				}
 
 				switch_mutex_lock(omember->audio_out_mutex);
-				ok = switch_buffer_write(omember->mux_buffer, write_frame, bytes);
+				ok = switch_buffer_write(omember->mux_buffer, out_frame, bytes);
 				switch_mutex_unlock(omember->audio_out_mutex);
 
 				if (!ok) {
@@ -593,6 +777,10 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 					goto end;
 				}
 			}
+
+			if (has_listen_frame) {
+				conference_audio_codec_write(conference, listen_frame, samples);
+			}
 		} else { /* There is no source audio.  Push silence into all of the buffers */
 			int16_t write_frame[SWITCH_RECOMMENDED_BUFFER_SIZE] = { 0 };
 
@@ -609,6 +797,12 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 					continue;
 				}
 
+				if (active_speakers && conference_utils_member_test_flag(omember, MFLAG_CAN_HEAR) && conference_audio_codec_join(conference, omember)) {
+					continue;
+				}
+
+				omember->audio_codec_index = -1;
+
 				switch_mutex_lock(omember->audio_out_mutex);
 				ok = switch_buffer_write(omember->mux_buffer, write_frame, bytes);
 				switch_mutex_unlock(omember->audio_out_mutex);
@@ -618,6 +812,10 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 					goto end;
 				}
 			}
+
+			if (active_speakers) {
+				conference_audio_codec_write(conference, write_frame, samples);
+			}
 		}
 
 		if (conference->async_fnode && conference->async_fnode->done) {
@@ -784,6 +982,13 @@ void *SWITCH_THREAD_FUNC conference_thread_run(switch_thread_t *thread, void *ob
 	switch_thread_rwlock_unlock(conference->rwlock);
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Write Lock OFF\n");
 
+	for (x = 0; x < MAX_MUX_CODECS && conference->audio_codecs[x]; x++) {
+		if (switch_core_codec_ready(&conference->audio_codecs[x]->codec)) {
+			switch_core_codec_destroy(&conference->audio_codecs[x]->codec);
+		}
+		switch_resample_destroy(&conference->audio_codecs[x]->resampler);
+	}
+
 	if (conference->la) {
 		switch_live_array_destroy(&conference->la);
 	}
@@ -1257,6 +1462,125 @@ void conference_xlist(conference_obj_t *conference, switch_xml_t x_conference, i
 	switch_mutex_unlock(conference->member_mutex);
 }
 
+void conference_jlist(conference_obj_t *conference, cJSON *json_conferences)
+{
+	conference_member_t *member = NULL;
+	cJSON *json_conference, *json_members, *json_canvases;
+	int i;
+
+	switch_assert(conference != NULL);
+
+	json_conference = cJSON_CreateObject();
+	cJSON_AddItemToArray(json_conferences, json_conference);
+
+	cJSON_AddStringToObject(json_conference, "conference_name", conference->name);
+	cJSON_AddNumberToObject(json_conference, "member_count", conference->count);
+	cJSON_AddNumberToObject(json_conference, "ghost_count", conference->count_ghosts);
+	cJSON_AddNumberToObject(json_conference, "rate", conference->rate);
+	cJSON_AddNumberToObject(json_conference, "run_time", switch_epoch_time_now(NULL) - conference->run_time);
+	cJSON_AddStringToObject(json_conference, "conference_uuid", conference->uuid_str);
+	cJSON_AddItemToObject(json_conference, "locked", cJSON_CreateBool(conference_utils_test_flag(conference, CFLAG_LOCKED)));
+	cJSON_AddItemToObject(json_conference, "running", cJSON_CreateBool(conference_utils_test_flag(conference, CFLAG_RUNNING)));
+	cJSON_AddItemToObject(json_conference, "recording", cJSON_CreateBool(conference->record_count > 0));
+
+	if (conference->max_members > 0) {
+		cJSON_AddNumberToObject(json_conference, "max_members", conference->max_members);
+	}
+
+	if (conference->max_active_speakers) {
+		cJSON_AddNumberToObject(json_conference, "max_active_speakers", conference->max_active_speakers);
+	}
+
+	json_canvases = cJSON_CreateArray();
+	cJSON_AddItemToObject(json_conference, "canvases", json_canvases);
+
+	switch_mutex_lock(conference->canvas_mutex);
+
+	for (i = 0; i <= conference->canvas_count; i++) {
+		mcu_canvas_t *canvas = conference->canvases[i];
+		cJSON *json_canvas;
+		uint64_t frames;
+
+		if (!canvas) continue;
+
+		json_canvas = cJSON_CreateObject();
+		cJSON_AddItemToArray(json_canvases, json_canvas);
+
+		frames = canvas->stat_frames ? canvas->stat_frames : 1;
+
+		cJSON_AddNumberToObject(json_canvas, "canvas_id", canvas->canvas_id + 1);
+		cJSON_AddNumberToObject(json_canvas, "width", canvas->width);
+		cJSON_AddNumberToObject(json_canvas, "height", canvas->height);
+		cJSON_AddNumberToObject(json_canvas, "layers_used", canvas->layers_used);
+		cJSON_AddNumberToObject(json_canvas, "total_layers", canvas->total_layers);
+		cJSON_AddNumberToObject(json_canvas, "patch_threads", canvas->patch_thread_count);
+		cJSON_AddNumberToObject(json_canvas, "frames", (double) canvas->stat_frames);
+		cJSON_AddNumberToObject(json_canvas, "layers_patched", (double) canvas->stat_patched);
+		cJSON_AddNumberToObject(json_canvas, "layers_skipped", (double) canvas->stat_skipped);
+		cJSON_AddNumberToObject(json_canvas, "scale_usec", (double) canvas->last_scale_time);
+		cJSON_AddNumberToObject(json_canvas, "patch_usec", (double) canvas->last_patch_time);
+		cJSON_AddNumberToObject(json_canvas, "encode_usec", (double) canvas->last_encode_time);
+		cJSON_AddNumberToObject(json_canvas, "avg_scale_usec", (double) (canvas->stat_scale_time / frames));
+		cJSON_AddNumberToObject(json_canvas, "avg_patch_usec", (double) (canvas->stat_patch_time / frames));
+		cJSON_AddNumberToObject(json_canvas, "avg_encode_usec", (double) (canvas->stat_encode_time / frames));
+	}
+
+	switch_mutex_unlock(conference->canvas_mutex);
+
+	json_members = cJSON_CreateArray();
+	cJSON_AddItemToObject(json_conference, "members", json_members);
+
+	switch_mutex_lock(conference->member_mutex);
+
+	for (member = conference->members; member; member = member->next) {
+		switch_caller_profile_t *profile;
+		cJSON *json_member, *json_flags;
+
+		if (conference_utils_member_test_flag(member, MFLAG_NOCHANNEL)) {
+			if (member->rec_path) {
+				json_member = cJSON_CreateObject();
+				cJSON_AddItemToArray(json_members, json_member);
+				cJSON_AddStringToObject(json_member, "type", "recording_node");
+				cJSON_AddStringToObject(json_member, "record_path", member->rec_path);
+				cJSON_AddNumberToObject(json_member, "join_time", member->rec_time);
+			}
+			continue;
+		}
+
+		profile = switch_channel_get_caller_profile(switch_core_session_get_channel(member->session));
+
+		json_member = cJSON_CreateObject();
+		cJSON_AddItemToArray(json_members, json_member);
+
+		cJSON_AddStringToObject(json_member, "type", "caller");
+		cJSON_AddNumberToObject(json_member, "id", member->id);
+		cJSON_AddStringToObject(json_member, "uuid", switch_core_session_get_uuid(member->session));
+		cJSON_AddStringToObject(json_member, "caller_id_name", switch_str_nil(profile->caller_id_name));
+		cJSON_AddStringToObject(json_member, "caller_id_number", switch_str_nil(profile->caller_id_number));
+		cJSON_AddNumberToObject(json_member, "join_time", switch_epoch_time_now(NULL) - member->join_time);
+		cJSON_AddNumberToObject(json_member, "last_talking", member->last_talking ? switch_epoch_time_now(NULL) - member->last_talking : 0);
+		cJSON_AddNumberToObject(json_member, "energy", member->energy_level);
+		cJSON_AddNumberToObject(json_member, "volume_in", member->volume_in_level);
+		cJSON_AddNumberToObject(json_member, "volume_out", member->volume_out_level);
+		cJSON_AddNumberToObject(json_member, "canvas_id", member->canvas_id + 1);
+		cJSON_AddNumberToObject(json_member, "layer_id", member->video_layer_id);
+		cJSON_AddNumberToObject(json_member, "encode_tier", member->video_encode_tier);
+
+		json_flags = cJSON_CreateObject();
+		cJSON_AddItemToObject(json_member, "flags", json_flags);
+
+		cJSON_AddItemToObject(json_flags, "can_hear", cJSON_CreateBool(conference_utils_member_test_flag(member, MFLAG_CAN_HEAR)));
+		cJSON_AddItemToObject(json_flags, "can_speak", cJSON_CreateBool(conference_utils_member_test_flag(member, MFLAG_CAN_SPEAK)));
+		cJSON_AddItemToObject(json_flags, "talking", cJSON_CreateBool(conference_utils_member_test_flag(member, MFLAG_TALKING)));
+		cJSON_AddItemToObject(json_flags, "has_video", cJSON_CreateBool(switch_channel_test_flag(member->channel, CF_VIDEO)));
+		cJSON_AddItemToObject(json_flags, "has_floor", cJSON_CreateBool(member == conference->floor_holder));
+		cJSON_AddItemToObject(json_flags, "is_moderator", cJSON_CreateBool(conference_utils_member_test_flag(member, MFLAG_MOD)));
+		cJSON_AddItemToObject(json_flags, "is_ghost", cJSON_CreateBool(conference_utils_member_test_flag(member, MFLAG_GHOST)));
+	}
+
+	switch_mutex_unlock(conference->member_mutex);
+}
+
 void conference_fnode_toggle_pause(conference_file_node_t *fnode, switch_stream_handle_t *stream)
 {
 	if (fnode) {
@@ -2207,6 +2531,7 @@ SWITCH_STANDARD_APP(conference_function)
 	}
 
 	switch_core_session_set_video_read_callback(session, NULL, NULL);
+	switch_channel_clear_flag(channel, CF_VIDEO_DECODE_PAUSE);
 
 	switch_channel_set_private(channel, "_conference_autocall_list_", NULL);
 
@@ -2411,6 +2736,7 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 	uint32_t channels = 1;
 	int broadcast_chat_messages = 1;
 	int comfort_noise_level = 0;
+	int max_active_speakers = 0;
 	int pin_retries = 3;
 	int ivr_dtmf_timeout = 500;
 	int ivr_input_timeout = 0;
@@ -2438,6 +2764,7 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 	int scale_h264_canvas_height = 0;
 	int scale_h264_canvas_fps_divisor = 0;
 	char *scale_h264_canvas_bandwidth = NULL;
+	char *video_encode_tiers = NULL;
 
 	/* Validate the conference name */
 	if (zstr(name)) {
@@ -2720,6 +3047,14 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 				}
 			} else if (!strcasecmp(var, "terminate-on-silence") && !zstr(val)) {
 				terminate_on_silence = val;
+			} else if (!strcasecmp(var, "max-active-speakers") && !zstr(val)) {
+				int tmp = atoi(val);
+
+				if (tmp >= 0 && tmp <= CONF_MAX_ACTIVE_SPEAKERS) {
+					max_active_speakers = tmp;
+				} else {
+					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "max-active-speakers must be between 0 and %d\n", CONF_MAX_ACTIVE_SPEAKERS);
+				}
 			} else if (!strcasecmp(var, "endconf-grace-time") && !zstr(val)) {
 				endconference_grace_time = val;
 			} else if (!strcasecmp(var, "video-quality") && !zstr(val)) {
@@ -2771,6 +3106,8 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 				if (scale_h264_canvas_fps_divisor < 0) scale_h264_canvas_fps_divisor = 0;
 			} else if (!strcasecmp(var, "scale-h264-canvas-bandwidth") && !zstr(val)) {
 				scale_h264_canvas_bandwidth = val;
+			} else if (!strcasecmp(var, "video-encode-tiers") && !zstr(val)) {
+				video_encode_tiers = val;
 			}
 		}
 
@@ -2823,6 +3160,7 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 	}
 
 	conference->comfort_noise_level = comfort_noise_level;
+	conference->max_active_speakers = max_active_speakers;
 	conference->pin_retries = pin_retries;
 	conference->caller_id_name = switch_core_strdup(conference->pool, caller_id_name);
 	conference->caller_id_number = switch_core_strdup(conference->pool, caller_id_number);
@@ -2839,6 +3177,10 @@ conference_obj_t *conference_new(char *name, conference_xml_cfg_t cfg, switch_co
 	conference->scale_h264_canvas_fps_divisor = scale_h264_canvas_fps_divisor;
 	conference->scale_h264_canvas_bandwidth = switch_core_strdup(conference->pool, scale_h264_canvas_bandwidth);
 
+	if (video_encode_tiers) {
+		conference_video_parse_encode_tiers(conference, video_encode_tiers);
+	}
+
 	if (!switch_core_has_video() && (conference->conference_video_mode == CONF_VIDEO_MODE_MUX || conference->conference_video_mode == CONF_VIDEO_MODE_TRANSCODE)) {
 		conference->conference_video_mode = CONF_VIDEO_MODE_PASSTHROUGH;
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "video-mode invalid, only valid setting is 'passthrough' due to no video capabilities\n");
@@ -85,6 +85,9 @@
 #define FPS 30
 /* max supported layers in one mcu */
 #define MCU_MAX_LAYERS 64
+#define MCU_MAX_PATCH_THREADS 8
+/* max bitrate tiers the shared canvas is encoded at */
+#define CONF_MAX_ENCODE_TIERS 4
 
 /* video layout scale factor */
 #define VIDEO_LAYOUT_SCALE 360.0f
@@ -106,6 +109,8 @@
 #define CONFFUNCAPISIZE (sizeof(conference_api_sub_commands)/sizeof(conference_api_sub_commands[0]))
 
 #define MAX_MUX_CODECS 10
+#define CONF_MAX_ACTIVE_SPEAKERS 32
+#define CONF_AUDIO_CODEC_FRAMES 8
 
 #define ALC_HRTF_SOFT  0x1992
 
@@ -210,6 +215,7 @@ typedef enum {
 	MFLAG_SILENT,
 	MFLAG_FLIP_VIDEO,
 	MFLAG_ROTATE_VIDEO,
+	MFLAG_ACTIVE_SPEAKER,
 	///////////////////////////
 	MFLAG_MAX
 } member_flag_t;
@@ -455,7 +461,15 @@ typedef struct mcu_layer_s {
 	conference_file_node_t *fnode;
 	switch_img_fit_t logo_fit;
 	struct mcu_canvas_s *canvas;
-	int need_patch;
+	switch_time_t scale_time;
+	switch_time_t patch_time;
+	switch_image_t *patched_img;
+	int dirty;
+	int patched;
+	int skipped;
+	char banner_key[512];
+	switch_image_t *mute_banner_img;
+	char mute_banner_key[512];
 	conference_member_t *member;
 } mcu_layer_t;
 
@@ -506,6 +520,22 @@ typedef struct mcu_canvas_s {
 	int recording;
 	switch_image_t *bgimg;
 	switch_thread_rwlock_t *video_rwlock;
+	switch_thread_t *patch_threads[MCU_MAX_PATCH_THREADS];
+	int patch_thread_count;
+	switch_queue_t *patch_queue;
+	switch_mutex_t *patch_mutex;
+	switch_thread_cond_t *patch_cond;
+	int patch_pending;
+	uint64_t stat_frames;
+	uint64_t stat_patched;
+	uint64_t stat_skipped;
+	switch_time_t stat_scale_time;
+	switch_time_t stat_patch_time;
+	switch_time_t stat_encode_time;
+	switch_time_t last_scale_time;
+	switch_time_t last_patch_time;
+	switch_time_t last_encode_time;
+	switch_mutex_t *encode_mutex;
 } mcu_canvas_t;
 
 /* Record Node */
@@ -525,6 +555,26 @@ typedef enum {
 	CONF_VIDEO_MODE_MUX
 } conference_video_mode_t;
 
+/* one shared encoder per audio write codec, listeners of an active speaker mix read the encoded frames from a small ring */
+typedef struct audio_codec_set_s {
+	switch_codec_t codec;
+	const switch_codec_implementation_t *impl;
+	char *fmtp;
+	switch_audio_resampler_t *resampler;
+	switch_mutex_t *mutex;
+	uint8_t frames[CONF_AUDIO_CODEC_FRAMES][SWITCH_RECOMMENDED_BUFFER_SIZE];
+	uint32_t datalen[CONF_AUDIO_CODEC_FRAMES];
+	uint32_t seq;
+	uint32_t listeners;
+} audio_codec_set_t;
+
+/* one rung of the canvas encode ladder, members are steered to the first tier their downlink can take */
+typedef struct conference_encode_tier_s {
+	int bandwidth;
+	int width;
+	int height;
+} conference_encode_tier_t;
+
 /* Conference Object */
 typedef struct conference_obj {
 	char *name;
@@ -632,6 +682,8 @@ typedef struct conference_obj {
 	int endconference_grace_time;
 
 	uint32_t relationship_total;
+	int max_active_speakers;
+	audio_codec_set_t *audio_codecs[MAX_MUX_CODECS];
 	uint32_t score;
 	int mux_loop_count;
 	int member_loop_count;
@@ -675,6 +727,9 @@ typedef struct conference_obj {
 	int scale_h264_canvas_height;
 	int scale_h264_canvas_fps_divisor;
 	char *scale_h264_canvas_bandwidth;
+
+	conference_encode_tier_t encode_tiers[CONF_MAX_ENCODE_TIERS];
+	int encode_tier_count;
 } conference_obj_t;
 
 /* Relationship with another member */
@@ -758,6 +813,9 @@ struct conference_member {
 	int layer_timeout;
 	int video_codec_index;
 	int video_codec_id;
+	int video_encode_tier;
+	int audio_codec_index;
+	uint32_t audio_codec_seq;
 	char *video_banner_text;
 	char *video_logo;
 	char *video_mute_png;
@@ -804,6 +862,18 @@ typedef struct api_command {
 	char *psyntax;
 } api_command_t;
 
+/* a canvas frame handed to the encoder threads, the last thread done with it frees it */
+typedef struct conference_encode_frame_s {
+	switch_image_t *img;
+	uint64_t generation;
+	uint32_t timestamp;
+	switch_bool_t need_refresh;
+	switch_bool_t send_keyframe;
+	switch_bool_t need_reset;
+	int32_t bandwidth;
+	int refs;
+} conference_encode_frame_t;
+
 typedef struct codec_set_s {
 	switch_codec_t codec;
 	switch_frame_t frame;
@@ -811,6 +881,18 @@ typedef struct codec_set_s {
 	switch_image_t *scaled_img;
 	uint8_t fps_divisor;
 	uint32_t frame_count;
+	uint64_t generation;
+	int tier;
+	int codec_index;
+	mcu_canvas_t *canvas;
+	switch_thread_t *thread;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	conference_encode_frame_t *pending;
+	int running;
+	uint64_t dropped;
+	switch_bool_t missed_keyframe;
+	switch_time_t encode_time;
 } codec_set_t;
 
 typedef void (*conference_key_callback_t) (conference_member_t *, struct caller_control_actions *);
@@ -935,6 +1017,7 @@ void conference_list_pretty(conference_obj_t *conference, switch_stream_handle_t
 switch_status_t conference_record_stop(conference_obj_t *conference, switch_stream_handle_t *stream, char *path);
 switch_status_t conference_record_action(conference_obj_t *conference, char *path, recording_action_type_t action);
 void conference_xlist(conference_obj_t *conference, switch_xml_t x_conference, int off);
+void conference_jlist(conference_obj_t *conference, cJSON *json_conferences);
 void conference_event_send_json(conference_obj_t *conference);
 void conference_event_send_rfc(conference_obj_t *conference);
 void conference_member_update_status_field(conference_member_t *member);
@@ -952,6 +1035,7 @@ void conference_video_check_used_layers(mcu_canvas_t *canvas);
 void conference_video_check_flush(conference_member_t *member);
 void conference_video_set_canvas_letterbox_bgcolor(mcu_canvas_t *canvas, char *color);
 void conference_video_set_canvas_bgcolor(mcu_canvas_t *canvas, char *color);
+void conference_video_parse_encode_tiers(conference_obj_t *conference, const char *tiers);
 void conference_video_scale_and_patch(mcu_layer_t *layer, switch_image_t *ximg, switch_bool_t freeze);
 void conference_video_reset_layer(mcu_layer_t *layer);
 void conference_video_clear_layer(mcu_layer_t *layer);
@@ -1106,6 +1190,7 @@ switch_status_t conference_api_sub_recording(conference_obj_t *conference, switc
 switch_status_t conference_api_sub_vid_layout(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv);
 switch_status_t conference_api_sub_list(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv);
 switch_status_t conference_api_sub_xml_list(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv);
+switch_status_t conference_api_sub_json_list(conference_obj_t *conference, switch_stream_handle_t *stream, int argc, char **argv);
 switch_status_t conference_api_sub_energy(conference_member_t *member, switch_stream_handle_t *stream, void *data);
 switch_status_t conference_api_sub_watching_canvas(conference_member_t *member, switch_stream_handle_t *stream, void *data);
 switch_status_t conference_api_sub_canvas(conference_member_t *member, switch_stream_handle_t *stream, void *data);
@@ -2562,6 +2562,11 @@ static uint32_t sofia_profile_reg_count(sofia_profile_t *profile)
 	struct cb_helper_sql2str cb;
 	char reg_count[80] = "";
 	char *sql;
+
+	if (profile->reg_store) {
+		return sofia_reg_store_count(profile);
+	}
+
 	cb.buf = reg_count;
 	cb.len = sizeof(reg_count);
 	sql = switch_mprintf("select count(*) from sip_registrations where profile_name = '%q'", profile->name);
@@ -2759,6 +2764,11 @@ static switch_status_t cmd_status(char **argv, int argc, switch_stream_handle_t
 					stream->write_function(stream, "CALLS-OUT        \t%u\n", profile->ob_calls);
 					stream->write_function(stream, "FAILED-CALLS-OUT \t%u\n", profile->ob_failed_calls);
 					stream->write_function(stream, "REGISTRATIONS    \t%lu\n", sofia_profile_reg_count(profile));
+					if (profile->pres_type == PRES_TYPE_FULL) {
+						stream->write_function(stream, "PRES-WATCHERS    \t%u\n", profile->pres_watch_count);
+						stream->write_function(stream, "PRES-NOTIFY-SENT \t%u\n", profile->pres_notify_sent);
+						stream->write_function(stream, "PRES-NOTIFY-SUPPR\t%u\n", profile->pres_notify_suppressed);
+					}
 				}
 
 				cb.profile = profile;
@@ -2882,6 +2892,17 @@ static switch_status_t cmd_status(char **argv, int argc, switch_stream_handle_t
 	switch_mutex_unlock(mod_sofia_globals.hash_mutex);
 	stream->write_function(stream, "%s\n", line);
 	stream->write_function(stream, "%d profile%s %d alias%s\n", c, c == 1 ? "" : "s", ac, ac == 1 ? "" : "es");
+
+	stream->write_function(stream, "%s\n", line);
+	stream->write_function(stream, "%25s\t%s\t%s\t%s\t%s\n", "Message-Queue", "Depth", "Processed", "Avg-Wait(ms)", "Max-Wait(ms)");
+	for (c = 0; c < mod_sofia_globals.msg_queue_len; c++) {
+		sofia_msg_shard_t *shard = &mod_sofia_globals.msg_shard[c];
+
+		stream->write_function(stream, "%25d\t%u\t%u\t%.2f\t%.2f\n", c, switch_queue_size(shard->queue), shard->processed,
+							   shard->processed ? (double) shard->latency_total / shard->processed / 1000 : 0.0, (double) shard->latency_max / 1000);
+	}
+	stream->write_function(stream, "%s\n", line);
+
 	return SWITCH_STATUS_SUCCESS;
 }
 
@@ -3064,6 +3085,11 @@ static switch_status_t cmd_xml_status(char **argv, int argc, switch_stream_handl
 					stream->write_function(stream, "    <failed-calls-in>%u</failed-calls-in>\n", profile->ib_failed_calls);
 					stream->write_function(stream, "    <failed-calls-out>%u</failed-calls-out>\n", profile->ob_failed_calls);
 					stream->write_function(stream, "    <registrations>%lu</registrations>\n", sofia_profile_reg_count(profile));
+					if (profile->pres_type == PRES_TYPE_FULL) {
+						stream->write_function(stream, "    <presence-watchers>%u</presence-watchers>\n", profile->pres_watch_count);
+						stream->write_function(stream, "    <presence-notify-sent>%u</presence-notify-sent>\n", profile->pres_notify_sent);
+						stream->write_function(stream, "    <presence-notify-suppressed>%u</presence-notify-suppressed>\n", profile->pres_notify_suppressed);
+					}
 					stream->write_function(stream, "  </profile-info>\n");
 				}
 
@@ -3272,6 +3298,11 @@ static switch_status_t cmd_profile(char **argv, int argc, switch_stream_handle_t
 		goto done;
 	}
 
+	if (!strcasecmp(argv[1], "flood")) {
+		sofia_flood_list(profile, stream);
+		goto done;
+	}
+
 	if (!strcasecmp(argv[1], "check_sync")) {
 		if (argc > 2) {
 			sofia_reg_check_call_id(profile, argv[2]);
@@ -4088,6 +4119,7 @@ SWITCH_STANDARD_API(sofia_function)
 		"sofia profile <name> [start | stop | restart | rescan] [wait]\n"
 		"                     flush_inbound_reg [<call_id> | <[user]@domain>] [reboot]\n"
 		"                     check_sync [<call_id> | <[user]@domain>]\n"
+		"                     flood\n"
 		"                     [register | unregister] [<gateway name> | all]\n"
 		"                     killgw <gateway name>\n"
 		"                     [stun-auto-disable | stun-enabled] [true | false]]\n"
@@ -5755,6 +5787,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_sofia_load)
 	switch_application_interface_t *app_interface;
 	struct in_addr in;
 	switch_status_t status;
+	int i;
 
 	memset(&mod_sofia_globals, 0, sizeof(mod_sofia_globals));
 	mod_sofia_globals.destroy_private.destroy_nh = 1;
@@ -5886,10 +5919,12 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_sofia_load)
 		mod_sofia_globals.max_msg_queues = SOFIA_MAX_MSG_QUEUE;
 	}
 
-	switch_queue_create(&mod_sofia_globals.msg_queue, SOFIA_MSG_QUEUE_SIZE * mod_sofia_globals.max_msg_queues, mod_sofia_globals.pool);
+	for (i = 0; i < mod_sofia_globals.max_msg_queues; i++) {
+		switch_queue_create(&mod_sofia_globals.msg_shard[i].queue, SOFIA_MSG_QUEUE_SIZE, mod_sofia_globals.pool);
+	}
+	mod_sofia_globals.msg_queue_len = mod_sofia_globals.max_msg_queues;
 
-	/* start one message thread */
-	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Starting initial message thread.\n");
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Starting %d message threads.\n", mod_sofia_globals.msg_queue_len);
 
 
 	if (sofia_init() != SWITCH_STATUS_SUCCESS) {
@@ -5903,7 +5938,9 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_sofia_load)
 		return SWITCH_STATUS_GENERR;
 	}
 
-	sofia_msg_thread_start(0);
+	for (i = 0; i < mod_sofia_globals.msg_queue_len; i++) {
+		sofia_msg_thread_start(i);
+	}
 
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Waiting for profiles to start\n");
 	switch_yield(1500000);
@@ -6011,7 +6048,7 @@ SWITCH_MODULE_LOAD_FUNCTION(mod_sofia_load)
 	switch_console_set_complete("add sofia global debug ::[presence:sla:none");
 
 	switch_console_set_complete("add sofia profile restart all");
-	switch_console_set_complete("add sofia profile ::sofia::list_profiles ::[start:rescan:restart:check_sync");
+	switch_console_set_complete("add sofia profile ::sofia::list_profiles ::[start:rescan:restart:check_sync:flood");
 	switch_console_set_complete("add sofia profile ::sofia::list_profiles stop wait");
 	switch_console_set_complete("add sofia profile ::sofia::list_profiles flush_inbound_reg reboot");
 	switch_console_set_complete("add sofia profile ::sofia::list_profiles ::[register:unregister all");
@@ -6099,13 +6136,17 @@ void mod_sofia_shutdown_cleanup() {
 		}
 	}
 
-	for (i = 0; mod_sofia_globals.msg_queue_thread[i]; i++) {
-		switch_queue_push(mod_sofia_globals.msg_queue, NULL);
-		switch_queue_interrupt_all(mod_sofia_globals.msg_queue);
+	for (i = 0; i < mod_sofia_globals.msg_queue_len; i++) {
+		if (mod_sofia_globals.msg_shard[i].thread) {
+			switch_queue_push(mod_sofia_globals.msg_shard[i].queue, NULL);
+			switch_queue_interrupt_all(mod_sofia_globals.msg_shard[i].queue);
+		}
 	}
 
-	for (i = 0; mod_sofia_globals.msg_queue_thread[i]; i++) {
-		switch_thread_join(&st, mod_sofia_globals.msg_queue_thread[i]);
+	for (i = 0; i < mod_sofia_globals.msg_queue_len; i++) {
+		if (mod_sofia_globals.msg_shard[i].thread) {
+			switch_thread_join(&st, mod_sofia_globals.msg_shard[i].thread);
+		}
 	}
 
 	if (mod_sofia_globals.presence_thread) {
@@ -72,6 +72,12 @@ struct sofia_profile;
 typedef struct sofia_profile sofia_profile_t;
 #define NUA_MAGIC_T sofia_profile_t
 
+struct sofia_reg_store_s;
+typedef struct sofia_reg_store_s sofia_reg_store_t;
+
+struct sofia_flood_s;
+typedef struct sofia_flood_s sofia_flood_t;
+
 typedef struct sofia_private sofia_private_t;
 
 struct private_object;
@@ -165,6 +171,7 @@ typedef struct sofia_dispatch_event_s {
 	switch_core_session_t *session;
 	switch_core_session_t *init_session;
 	switch_memory_pool_t *pool;
+	switch_time_t queued;
 	struct sofia_dispatch_event_s *next;
 } sofia_dispatch_event_t;
 
@@ -294,6 +301,7 @@ typedef enum {
 	PFLAG_FIRE_TRANFER_EVENTS,
 	PFLAG_BLIND_AUTH_ENFORCE_RESULT,
 	PFLAG_PROXY_HOLD,
+	PFLAG_REG_MEMORY_STORE,
 
 	/* No new flags below this line */
 	PFLAG_MAX
@@ -353,6 +361,15 @@ typedef enum {
 #define SOFIA_MAX_MSG_QUEUE 64
 #define SOFIA_MSG_QUEUE_SIZE 1000
 
+/* one dispatch queue and worker; a dialog always lands on the same shard, hashed by nua handle */
+typedef struct {
+	switch_queue_t *queue;
+	switch_thread_t *thread;
+	uint32_t processed;
+	switch_time_t latency_total;
+	switch_time_t latency_max;
+} sofia_msg_shard_t;
+
 struct mod_sofia_globals {
 	switch_memory_pool_t *pool;
 	switch_hash_t *profile_hash;
@@ -367,9 +384,8 @@ struct mod_sofia_globals {
 	char guess_ip[80];
 	char hostname[512];
 	switch_queue_t *presence_queue;
-	switch_queue_t *msg_queue;
 	switch_queue_t *general_event_queue;
-	switch_thread_t *msg_queue_thread[SOFIA_MAX_MSG_QUEUE];
+	sofia_msg_shard_t msg_shard[SOFIA_MAX_MSG_QUEUE];
 	int msg_queue_len;
 	struct sofia_private destroy_private;
 	struct sofia_private keep_private;
@@ -766,6 +782,22 @@ struct sofia_profile {
 	int bind_attempt_interval;
 	char *proxy_notify_events;
 	char *proxy_info_content_types;
+	sofia_reg_store_t *reg_store;
+	uint32_t pres_notify_coalesce_ms;
+	uint32_t pres_notify_sent;
+	uint32_t pres_notify_suppressed;
+	switch_mutex_t *pres_watch_mutex;
+	switch_hash_t *pres_watch_hash;
+	switch_hash_t *pres_watch_call_hash;
+	uint32_t pres_watch_count;
+	uint32_t flood_ip_rate;
+	uint32_t flood_ip_burst;
+	uint32_t flood_realm_rate;
+	uint32_t flood_realm_burst;
+	uint32_t flood_block_seconds;
+	uint32_t flood_block_strikes;
+	char *flood_exempt_acl;
+	sofia_flood_t *flood;
 };
 
 
@@ -1122,6 +1154,20 @@ void sofia_presence_event_thread_start(void);
 void sofia_reg_expire_call_id(sofia_profile_t *profile, const char *call_id, int reboot);
 void sofia_reg_check_call_id(sofia_profile_t *profile, const char *call_id);
 void sofia_reg_check_sync(sofia_profile_t *profile);
+void sofia_reg_store_create(sofia_profile_t *profile);
+void sofia_reg_store_destroy(sofia_profile_t *profile);
+uint32_t sofia_reg_store_count(sofia_profile_t *profile);
+void sofia_reg_store_add(sofia_profile_t *profile, const char *call_id, const char *sip_user, const char *sip_host, const char *presence_hosts,
+						 const char *contact, const char *status, const char *rpid, long expires, const char *user_agent,
+						 const char *server_user, const char *server_host, const char *network_ip, const char *network_port,
+						 const char *sip_username, const char *sip_realm);
+void sofia_reg_store_del(sofia_profile_t *profile, const char *call_id, const char *sip_user, const char *sip_host,
+						 const char *network_ip, const char *network_port);
+void sofia_reg_store_set_expires(sofia_profile_t *profile, const char *call_id, const char *sip_user, const char *sip_host, long expires);
+void sofia_flood_create(sofia_profile_t *profile);
+void sofia_flood_destroy(sofia_profile_t *profile);
+void sofia_flood_check_expire(sofia_profile_t *profile, time_t now);
+void sofia_flood_list(sofia_profile_t *profile, switch_stream_handle_t *stream);
 
 
 char *sofia_glue_get_register_host(const char *uri);
@@ -1197,6 +1243,10 @@ void sofia_process_dispatch_event(sofia_dispatch_event_t **dep);
 void sofia_process_dispatch_event_in_thread(sofia_dispatch_event_t **dep);
 char *sofia_glue_get_host(const char *str, switch_memory_pool_t *pool);
 void sofia_presence_check_subscriptions(sofia_profile_t *profile, time_t now);
+void sofia_presence_watch_init(sofia_profile_t *profile);
+void sofia_presence_watch_destroy(sofia_profile_t *profile);
+void sofia_presence_watch_add(sofia_profile_t *profile, const char *call_id, const char *sub_to_user);
+void sofia_presence_watch_del(sofia_profile_t *profile, const char *call_id);
 void sofia_msg_thread_start(int idx);
 void crtp_init(switch_loadable_module_interface_t *module_interface);
 int sofia_recover_callback(switch_core_session_t *session);
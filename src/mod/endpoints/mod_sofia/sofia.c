@@ -114,6 +114,7 @@ void sofia_handle_sip_r_notify(switch_core_session_t *session, int status,
 		sql = switch_mprintf("delete from sip_subscriptions where call_id='%q'", sip->sip_call_id->i_id);
 		switch_assert(sql != NULL);
 		sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+		sofia_presence_watch_del(profile, sip->sip_call_id->i_id);
 		nua_handle_destroy(nh);
 	}
 
@@ -1889,6 +1890,7 @@ static void our_sofia_event_callback(nua_event_t event,
 
 
 				sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+				sofia_presence_watch_add(profile, call_id, to_user);
 
 				sip_to_tag(nh->nh_home, sip->sip_to, to_tag);
 			}
@@ -1917,6 +1919,7 @@ static void our_sofia_event_callback(nua_event_t event,
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG1, "SOCKET DISCONNECT: %s %s:%s\n",
 								  sofia_private->call_id, sofia_private->network_ip, sofia_private->network_port);
 				sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+				sofia_reg_store_del(profile, sofia_private->call_id, NULL, NULL, sofia_private->network_ip, sofia_private->network_port);
 
 				switch_core_del_registration(sofia_private->user, sofia_private->realm, sofia_private->call_id);
 
@@ -2125,116 +2128,348 @@ void sofia_process_dispatch_event(sofia_dispatch_event_t **dep)
 
 
 
-static int msg_queue_threads = 0;
 //static int count = 0;
 
-void *SWITCH_THREAD_FUNC sofia_msg_thread_run(switch_thread_t *thread, void *obj)
+/*
+ * Every event of a dialog, with or without a sip message (nua_i_terminated, nua_i_state, nua_r_*),
+ * comes in on the same handle, so the handle picks the shard and one worker sees the dialog in order.
+ */
+static sofia_msg_shard_t *sofia_msg_shard(nua_handle_t *nh)
 {
-	void *pop;
-	switch_queue_t *q = (switch_queue_t *) obj;
-	int my_id;
-
+	uint32_t hash = (uint32_t) ((uintptr_t) nh >> 4) * 2654435761U;
 
-	for (my_id = 0; my_id < mod_sofia_globals.msg_queue_len; my_id++) {
-		if (mod_sofia_globals.msg_queue_thread[my_id] == thread) {
-			break;
-		}
-	}
+	return &mod_sofia_globals.msg_shard[hash % mod_sofia_globals.msg_queue_len];
+}
 
-	switch_mutex_lock(mod_sofia_globals.mutex);
-	msg_queue_threads++;
-	switch_mutex_unlock(mod_sofia_globals.mutex);
+void *SWITCH_THREAD_FUNC sofia_msg_thread_run(switch_thread_t *thread, void *obj)
+{
+	void *pop;
+	sofia_msg_shard_t *shard = (sofia_msg_shard_t *) obj;
+	int my_id = (int) (shard - mod_sofia_globals.msg_shard);
 
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "MSG Thread %d Started\n", my_id);
 
 
 	for(;;) {
 
-		if (switch_queue_pop(q, &pop) != SWITCH_STATUS_SUCCESS) {
+		if (switch_queue_pop(shard->queue, &pop) != SWITCH_STATUS_SUCCESS) {
 			switch_cond_next();
 			continue;
 		}
 
 		if (pop) {
 			sofia_dispatch_event_t *de = (sofia_dispatch_event_t *) pop;
+			switch_time_t wait = switch_micro_time_now() - de->queued;
+
+			shard->processed++;
+			shard->latency_total += wait;
+			if (wait > shard->latency_max) {
+				shard->latency_max = wait;
+			}
+
 			sofia_process_dispatch_event(&de);
 		} else {
 			break;
 		}
 	}
 
-	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "MSG Thread Ended\n");
-
-	switch_mutex_lock(mod_sofia_globals.mutex);
-	msg_queue_threads--;
-	switch_mutex_unlock(mod_sofia_globals.mutex);
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "MSG Thread %d Ended\n", my_id);
 
 	return NULL;
 }
 
+/* the shard count is fixed once events flow, growing it later would move dialogs between workers */
 void sofia_msg_thread_start(int idx)
 {
+	sofia_msg_shard_t *shard;
+	switch_threadattr_t *thd_attr = NULL;
 
-	if (idx >= mod_sofia_globals.max_msg_queues ||
-		idx >= SOFIA_MAX_MSG_QUEUE || (idx < mod_sofia_globals.msg_queue_len && mod_sofia_globals.msg_queue_thread[idx])) {
+	if (idx >= mod_sofia_globals.max_msg_queues || idx >= SOFIA_MAX_MSG_QUEUE) {
 		return;
 	}
 
 	switch_mutex_lock(mod_sofia_globals.mutex);
 
-	if (idx >= mod_sofia_globals.msg_queue_len) {
-		int i;
-		mod_sofia_globals.msg_queue_len = idx + 1;
-
-		for (i = 0; i < mod_sofia_globals.msg_queue_len; i++) {
-			if (!mod_sofia_globals.msg_queue_thread[i]) {
-				switch_threadattr_t *thd_attr = NULL;
+	shard = &mod_sofia_globals.msg_shard[idx];
 
-				switch_threadattr_create(&thd_attr, mod_sofia_globals.pool);
-				switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
-				//switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
-				switch_thread_create(&mod_sofia_globals.msg_queue_thread[i],
-									 thd_attr,
-									 sofia_msg_thread_run,
-									 mod_sofia_globals.msg_queue,
-									 mod_sofia_globals.pool);
-			}
-		}
+	if (shard->queue && !shard->thread) {
+		switch_threadattr_create(&thd_attr, mod_sofia_globals.pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		//switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
+		switch_thread_create(&shard->thread, thd_attr, sofia_msg_thread_run, shard, mod_sofia_globals.pool);
 	}
 
 	switch_mutex_unlock(mod_sofia_globals.mutex);
 }
 
-//static int foo = 0;
-void sofia_queue_message(sofia_dispatch_event_t *de)
+static int sofia_msg_queue_critical(nua_handle_t *nh)
 {
-	int launch = 0;
+	if (!mod_sofia_globals.msg_queue_len) {
+		return 0;
+	}
 
-	if (mod_sofia_globals.running == 0 || !mod_sofia_globals.msg_queue) {
-		sofia_process_dispatch_event(&de);
+	return switch_queue_size(sofia_msg_shard(nh)->queue) > (SOFIA_MSG_QUEUE_SIZE * 900) / 1000;
+}
+
+#define SOFIA_FLOOD_MAX_ENTRIES 65536
+
+typedef enum {
+	SOFIA_FLOOD_PASS,
+	SOFIA_FLOOD_LIMIT,
+	SOFIA_FLOOD_BLOCKED
+} sofia_flood_result_t;
+
+typedef struct sofia_flood_entry_s {
+	char *key;
+	double tokens;
+	switch_time_t last;
+	switch_time_t strike_start;
+	switch_time_t blocked_until;
+	uint32_t strikes;
+	uint32_t hits;
+	uint32_t dropped;
+	struct sofia_flood_entry_s *next;
+} sofia_flood_entry_t;
+
+struct sofia_flood_s {
+	switch_mutex_t *mutex;
+	switch_hash_t *hash;
+	sofia_flood_entry_t *entries;
+	uint32_t count;
+	uint32_t limited;
+	uint32_t blocked;
+	uint32_t dropped;
+	char retry_after[16];
+};
+
+void sofia_flood_create(sofia_profile_t *profile)
+{
+	sofia_flood_t *flood = switch_core_alloc(profile->pool, sizeof(*flood));
+
+	switch_mutex_init(&flood->mutex, SWITCH_MUTEX_NESTED, profile->pool);
+	switch_core_hash_init(&flood->hash);
+	switch_snprintf(flood->retry_after, sizeof(flood->retry_after), "%u", profile->flood_block_seconds ? profile->flood_block_seconds : 5);
+
+	if (profile->flood_ip_rate && profile->flood_ip_burst < profile->flood_ip_rate) {
+		profile->flood_ip_burst = profile->flood_ip_rate;
+	}
+
+	if (profile->flood_realm_rate && profile->flood_realm_burst < profile->flood_realm_rate) {
+		profile->flood_realm_burst = profile->flood_realm_rate;
+	}
+
+	profile->flood = flood;
+}
+
+void sofia_flood_destroy(sofia_profile_t *profile)
+{
+	sofia_flood_t *flood = profile->flood;
+	sofia_flood_entry_t *fe;
+
+	if (!flood) {
 		return;
 	}
 
+	switch_mutex_lock(flood->mutex);
+	profile->flood = NULL;
+	while ((fe = flood->entries)) {
+		flood->entries = fe->next;
+		free(fe->key);
+		free(fe);
+	}
+	switch_core_hash_destroy(&flood->hash);
+	switch_mutex_unlock(flood->mutex);
+}
 
-	if (de->profile && sofia_test_pflag(de->profile, PFLAG_THREAD_PER_REG) &&
-		de->data->e_event == nua_i_register && DE_THREAD_CNT < mod_sofia_globals.max_reg_threads) {
-		sofia_process_dispatch_event_in_thread(&de);
+/* token bucket per key, only ip buckets may land in the offender table */
+static sofia_flood_result_t sofia_flood_take(sofia_profile_t *profile, const char *key, uint32_t rate, uint32_t burst,
+											 switch_bool_t block, switch_time_t now)
+{
+	sofia_flood_t *flood = profile->flood;
+	sofia_flood_entry_t *fe;
+
+	if (!(fe = switch_core_hash_find(flood->hash, key))) {
+		if (flood->count >= SOFIA_FLOOD_MAX_ENTRIES) {
+			/* don't let spoofed sources grow the table without bound */
+			return SOFIA_FLOOD_PASS;
+		}
+
+		switch_zmalloc(fe, sizeof(*fe));
+		fe->key = strdup(key);
+		fe->tokens = burst;
+		fe->last = now;
+		switch_core_hash_insert(flood->hash, fe->key, fe);
+		fe->next = flood->entries;
+		flood->entries = fe;
+		flood->count++;
+	}
+
+	fe->hits++;
+
+	if (fe->blocked_until) {
+		if (fe->blocked_until > now) {
+			fe->dropped++;
+			flood->dropped++;
+			return SOFIA_FLOOD_BLOCKED;
+		}
+
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Profile %s: releasing %s from the offender table\n", profile->name, key);
+		fe->blocked_until = 0;
+		fe->strikes = 0;
+		fe->tokens = burst;
+		fe->last = now;
+	}
+
+	fe->tokens += (double) (now - fe->last) * rate / 1000000;
+	if (fe->tokens > burst) {
+		fe->tokens = burst;
+	}
+	fe->last = now;
+
+	if (fe->tokens >= 1) {
+		fe->tokens -= 1;
+		return SOFIA_FLOOD_PASS;
+	}
+
+	fe->dropped++;
+	flood->limited++;
+
+	if (block && profile->flood_block_seconds) {
+		if (now - fe->strike_start > (switch_time_t) profile->flood_block_seconds * 1000000) {
+			fe->strike_start = now;
+			fe->strikes = 0;
+		}
+
+		if (++fe->strikes >= profile->flood_block_strikes) {
+			fe->blocked_until = now + (switch_time_t) profile->flood_block_seconds * 1000000;
+			flood->blocked++;
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Profile %s: %s exceeded %u req/s, blocked for %u seconds\n",
+							  profile->name, key, rate, profile->flood_block_seconds);
+			return SOFIA_FLOOD_BLOCKED;
+		}
+	}
+
+	return SOFIA_FLOOD_LIMIT;
+}
+
+static sofia_flood_result_t sofia_flood_check(sofia_profile_t *profile, nua_t *nua, sip_t const *sip)
+{
+	sofia_flood_result_t r = SOFIA_FLOOD_PASS;
+	char ip[80] = "";
+	char key[256] = "";
+	switch_time_t now = switch_micro_time_now();
+	msg_t *msg;
+
+	if (profile->flood_ip_rate && (msg = nua_current_request(nua))) {
+		sofia_glue_get_addr(msg, ip, sizeof(ip), NULL);
+	}
+
+	if (!zstr(ip) && profile->flood_exempt_acl && switch_check_network_list_ip(ip, profile->flood_exempt_acl)) {
+		return SOFIA_FLOOD_PASS;
+	}
+
+	switch_mutex_lock(profile->flood->mutex);
+
+	if (!zstr(ip)) {
+		switch_snprintf(key, sizeof(key), "ip:%s", ip);
+		r = sofia_flood_take(profile, key, profile->flood_ip_rate, profile->flood_ip_burst, SWITCH_TRUE, now);
+	}
+
+	if (r == SOFIA_FLOOD_PASS && profile->flood_realm_rate && sip && sip->sip_to && !zstr(sip->sip_to->a_url->url_host)) {
+		switch_snprintf(key, sizeof(key), "realm:%s", sip->sip_to->a_url->url_host);
+		r = sofia_flood_take(profile, key, profile->flood_realm_rate, profile->flood_realm_burst, SWITCH_FALSE, now);
+	}
+
+	switch_mutex_unlock(profile->flood->mutex);
+
+	return r;
+}
+
+void sofia_flood_check_expire(sofia_profile_t *profile, time_t now)
+{
+	sofia_flood_t *flood = profile->flood;
+	sofia_flood_entry_t *fe, *last = NULL, *next;
+	switch_time_t unow = (switch_time_t) now * 1000000;
+	switch_time_t idle = (switch_time_t) (profile->flood_block_seconds > 60 ? profile->flood_block_seconds : 60) * 1000000;
+
+	if (!flood) {
 		return;
 	}
 
+	switch_mutex_lock(flood->mutex);
+	for (fe = flood->entries; fe; fe = next) {
+		next = fe->next;
+
+		if (fe->blocked_until > unow || unow - fe->last < idle) {
+			last = fe;
+			continue;
+		}
+
+		if (last) {
+			last->next = next;
+		} else {
+			flood->entries = next;
+		}
+
+		switch_core_hash_delete(flood->hash, fe->key);
+		flood->count--;
+		free(fe->key);
+		free(fe);
+	}
+	switch_mutex_unlock(flood->mutex);
+}
+
+void sofia_flood_list(sofia_profile_t *profile, switch_stream_handle_t *stream)
+{
+	sofia_flood_t *flood = profile->flood;
+	sofia_flood_entry_t *fe;
+	switch_time_t now = switch_micro_time_now();
+	int x = 0;
 
-	if ((switch_queue_size(mod_sofia_globals.msg_queue) > (SOFIA_MSG_QUEUE_SIZE * (unsigned int)msg_queue_threads))) {
-		launch++;
+	if (!flood) {
+		stream->write_function(stream, "-ERR flood control is not enabled on profile %s\n", profile->name);
+		return;
 	}
 
+	switch_mutex_lock(flood->mutex);
+	stream->write_function(stream, "ip %u/s burst %u, realm %u/s burst %u, block %us after %u strikes\n",
+						   profile->flood_ip_rate, profile->flood_ip_burst, profile->flood_realm_rate, profile->flood_realm_burst,
+						   profile->flood_block_seconds, profile->flood_block_strikes);
+	stream->write_function(stream, "tracked %u, limited %u, blocked %u, rejected while blocked %u\n\n",
+						   flood->count, flood->limited, flood->blocked, flood->dropped);
+	stream->write_function(stream, "%-50s %10s %10s %8s %8s\n", "Source", "Hits", "Dropped", "Tokens", "Blocked");
 
-	if (launch) {
-		if (mod_sofia_globals.msg_queue_len < mod_sofia_globals.max_msg_queues) {
-			sofia_msg_thread_start(mod_sofia_globals.msg_queue_len + 1);
+	for (fe = flood->entries; fe; fe = fe->next) {
+		if (!fe->dropped && fe->blocked_until <= now) {
+			continue;
 		}
+
+		stream->write_function(stream, "%-50s %10u %10u %8.1f %7ds\n", fe->key, fe->hits, fe->dropped, fe->tokens,
+							   fe->blocked_until > now ? (int) ((fe->blocked_until - now) / 1000000) : 0);
+		x++;
+	}
+	switch_mutex_unlock(flood->mutex);
+
+	stream->write_function(stream, "\n%d offender%s\n", x, x == 1 ? "" : "s");
+}
+
+//static int foo = 0;
+void sofia_queue_message(sofia_dispatch_event_t *de)
+{
+	if (mod_sofia_globals.running == 0 || !mod_sofia_globals.msg_queue_len) {
+		sofia_process_dispatch_event(&de);
+		return;
+	}
+
+
+	if (de->profile && sofia_test_pflag(de->profile, PFLAG_THREAD_PER_REG) &&
+		de->data->e_event == nua_i_register && DE_THREAD_CNT < mod_sofia_globals.max_reg_threads) {
+		sofia_process_dispatch_event_in_thread(&de);
+		return;
 	}
 
-	switch_queue_push(mod_sofia_globals.msg_queue, de);
+	de->queued = switch_micro_time_now();
+	switch_queue_push(sofia_msg_shard(de->nh)->queue, de);
 }
 
 static void set_call_id(private_object_t *tech_pvt, sip_t const *sip)
@@ -2253,7 +2488,6 @@ void sofia_event_callback(nua_event_t event,
 						  tagi_t tags[])
 {
 	sofia_dispatch_event_t *de;
-	int critical = (((SOFIA_MSG_QUEUE_SIZE * mod_sofia_globals.max_msg_queues) * 900) / 1000);
 	uint32_t sess_count = switch_core_session_count();
 	uint32_t sess_max = switch_core_session_limit(0);
 
@@ -2323,7 +2557,19 @@ void sofia_event_callback(nua_event_t event,
 			}
 
 
-			if (switch_queue_size(mod_sofia_globals.msg_queue) > (unsigned int)critical) {
+			if (profile->flood) {
+				switch (sofia_flood_check(profile, nua, sip)) {
+				case SOFIA_FLOOD_BLOCKED:
+				case SOFIA_FLOOD_LIMIT:
+					nua_respond(nh, 503, "Rate Limited", SIPTAG_RETRY_AFTER_STR(profile->flood->retry_after),
+								NUTAG_WITH_THIS(nua), TAG_END());
+					goto end;
+				default:
+					break;
+				}
+			}
+
+			if (sofia_msg_queue_critical(nh)) {
 				nua_respond(nh, 503, "System Busy", SIPTAG_RETRY_AFTER_STR("300"), NUTAG_WITH_THIS(nua), TAG_END());
 				goto end;
 			}
@@ -2580,6 +2826,13 @@ void event_handler(switch_event_t *event)
 		}
 
 		sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+
+		if (sofia_test_pflag(profile, PFLAG_MULTIREG)) {
+			sofia_reg_store_del(profile, call_id, NULL, NULL, NULL, NULL);
+		} else {
+			sofia_reg_store_del(profile, NULL, from_user, from_host, NULL, NULL);
+		}
+
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Expired propagated registration for %s@%s->%s\n", from_user, from_host, contact_str);
 
 		if (profile) {
@@ -2683,6 +2936,12 @@ void event_handler(switch_event_t *event)
 
 		sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
 
+		if (sofia_test_pflag(profile, PFLAG_MULTIREG)) {
+			sofia_reg_store_del(profile, call_id, NULL, NULL, NULL, NULL);
+		} else {
+			sofia_reg_store_del(profile, NULL, from_user, from_host, NULL, NULL);
+		}
+
 		switch_find_local_ip(guess_ip4, sizeof(guess_ip4), NULL, AF_INET);
 		sql = switch_mprintf("insert into sip_registrations "
 							 "(call_id, sip_user, sip_host, presence_hosts, contact, status, rpid, expires,"
@@ -2695,6 +2954,8 @@ void event_handler(switch_event_t *event)
 
 		if (sql) {
 			sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+			sofia_reg_store_add(profile, call_id, from_user, from_host, presence_hosts, contact_str, "Registered", rpid, expires, user_agent,
+								to_user, guess_ip4, network_ip, network_port, username, realm);
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Propagating registration for %s@%s->%s\n", from_user, from_host, contact_str);
 		}
 
@@ -2830,6 +3091,7 @@ void *SWITCH_THREAD_FUNC sofia_profile_worker_thread_run(switch_thread_t *thread
 				if (++ireg_loops >= (uint32_t)profile->ireg_seconds) {
 					time_t now = switch_epoch_time_now(NULL);
 					sofia_reg_check_expire(profile, now, 0);
+					sofia_flood_check_expire(profile, now);
 					ireg_loops = 0;
 				}
 	
@@ -2994,6 +3256,25 @@ void *SWITCH_THREAD_FUNC sofia_profile_thread_run(switch_thread_t *thread, void
 		goto end;
 	}
 
+	if (sofia_test_pflag(profile, PFLAG_REG_MEMORY_STORE)) {
+		if (profile->odbc_dsn) {
+			/* other nodes may write the same table, only sql sees their rows */
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Profile %s: registration-memory-store ignored with odbc-dsn, "
+							  "registrations are looked up in the database\n", profile->name);
+			sofia_clear_pflag(profile, PFLAG_REG_MEMORY_STORE);
+		} else {
+			sofia_reg_store_create(profile);
+		}
+	}
+
+	if (profile->pres_type == PRES_TYPE_FULL) {
+		sofia_presence_watch_init(profile);
+	}
+
+	if (profile->flood_ip_rate || profile->flood_realm_rate) {
+		sofia_flood_create(profile);
+	}
+
 	supported = switch_core_sprintf(profile->pool, "%s%s%spath, replaces", use_100rel ? "precondition, 100rel, " : "", use_timer ? "timer, " : "", use_rfc_5626 ? "outbound, " : "");
 
 	if (sofia_test_pflag(profile, PFLAG_AUTO_NAT) && switch_nat_get_type()) {
@@ -3346,6 +3627,9 @@ void *SWITCH_THREAD_FUNC sofia_profile_thread_run(switch_thread_t *thread, void
 	switch_core_hash_destroy(&profile->chat_hash);
 	switch_core_hash_destroy(&profile->reg_nh_hash);
 	switch_core_hash_destroy(&profile->mwi_debounce_hash);
+	sofia_reg_store_destroy(profile);
+	sofia_presence_watch_destroy(profile);
+	sofia_flood_destroy(profile);
 
 	switch_thread_rwlock_unlock(profile->rwlock);
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Write unlock %s\n", profile->name);
@@ -4358,6 +4642,8 @@ switch_status_t config_sofia(sofia_config_t reload, char *profile_name)
 					profile->paid_type = PAID_DEFAULT;
 					profile->bind_attempts = 2;
 					profile->bind_attempt_interval = 5;
+					profile->flood_block_seconds = 60;
+					profile->flood_block_strikes = 20;
 					profile->dtmf_type = DTMF_2833;
 					profile->tls_verify_policy = TPTLS_VERIFY_NONE;
 					/* lib default */
@@ -5030,6 +5316,9 @@ switch_status_t config_sofia(sofia_config_t reload, char *profile_name)
 						} else {
 							profile->pres_held_type = 0;
 						}
+					} else if (!strcasecmp(var, "presence-notify-coalesce-ms")) {
+						int v = atoi(val);
+						profile->pres_notify_coalesce_ms = v > 0 ? v : 0;
 					} else if (!strcasecmp(var, "presence-privacy")) {
 						if (switch_true(val)) {
 							sofia_set_pflag(profile, PFLAG_PRESENCE_PRIVACY);
@@ -5636,6 +5925,32 @@ switch_status_t config_sofia(sofia_config_t reload, char *profile_name)
 						}  else {
 							sofia_clear_pflag(profile, PFLAG_PROXY_HOLD);
 						}
+					} else if (!strcasecmp(var, "registration-memory-store")) {
+						if (switch_true(val)) {
+							sofia_set_pflag(profile, PFLAG_REG_MEMORY_STORE);
+						} else {
+							sofia_clear_pflag(profile, PFLAG_REG_MEMORY_STORE);
+						}
+					} else if (!strcasecmp(var, "flood-ip-rate")) {
+						int v = atoi(val);
+						profile->flood_ip_rate = v > 0 ? v : 0;
+					} else if (!strcasecmp(var, "flood-ip-burst")) {
+						int v = atoi(val);
+						profile->flood_ip_burst = v > 0 ? v : 0;
+					} else if (!strcasecmp(var, "flood-realm-rate")) {
+						int v = atoi(val);
+						profile->flood_realm_rate = v > 0 ? v : 0;
+					} else if (!strcasecmp(var, "flood-realm-burst")) {
+						int v = atoi(val);
+						profile->flood_realm_burst = v > 0 ? v : 0;
+					} else if (!strcasecmp(var, "flood-block-seconds")) {
+						int v = atoi(val);
+						profile->flood_block_seconds = v > 0 ? v : 0;
+					} else if (!strcasecmp(var, "flood-block-strikes")) {
+						int v = atoi(val);
+						profile->flood_block_strikes = v > 0 ? v : 1;
+					} else if (!strcasecmp(var, "flood-exempt-acl")) {
+						profile->flood_exempt_acl = switch_core_strdup(profile->pool, val);
 					} else if (!strcasecmp(var, "proxy-notify-events")) {
 						profile->proxy_notify_events = switch_core_strdup(profile->pool, val);
 					} else if (!strcasecmp(var, "proxy-info-content-types")) {
@@ -6073,6 +6388,7 @@ static void sofia_handle_sip_r_options(switch_core_session_t *session, int statu
 											 (long) now, ping_time, sip->sip_to->a_url->url_user, sip->sip_to->a_url->url_host, call_id);
 						sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
 						switch_safe_free(sql);
+						sofia_reg_store_set_expires(profile, call_id, sip->sip_to->a_url->url_user, sip->sip_to->a_url->url_host, (long) now);
 					}
 				}
 			}
@@ -57,6 +57,13 @@ static int broadsoft_sla_notify_callback(void *pArg, int argc, char **argv, char
 static int sync_sla(sofia_profile_t *profile, const char *to_user, const char *to_host, switch_bool_t clear, switch_bool_t unseize, const char *call_id);
 static int sofia_dialog_probe_callback(void *pArg, int argc, char **argv, char **columnNames);
 static int sofia_dialog_probe_notify_callback(void *pArg, int argc, char **argv, char **columnNames);
+static void sofia_presence_coalesce_init(void);
+static void sofia_presence_coalesce_destroy(void);
+static void sofia_presence_coalesce_flush(void);
+static void sofia_presence_coalesce_notify(sofia_profile_t *profile, const char *full_to, const char *full_from, const char *contact,
+										   const char *expires, const char *call_id, const char *event, const char *ip, const char *port,
+										   const char *ct, const char *pl);
+static int sofia_presence_watch_check(sofia_profile_t *profile, const char *user, const char *call_id);
 
 struct pres_sql_cb {
 	sofia_profile_t *profile;
@@ -1418,6 +1425,14 @@ static switch_event_t *actual_sofia_presence_event_handler(switch_event_t *event
 					goto done;
 				}
 
+				if (!sofia_presence_watch_check(profile, euser, call_id)) {
+					if (mod_sofia_globals.debug_presence > 0) {
+						switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "%s: no watchers for %s@%s, skipping\n", profile->name, euser, host);
+					}
+					sofia_glue_release_profile(profile);
+					continue;
+				}
+
 				if (zstr(call_id)) {
 
 					sql = switch_mprintf("update sip_subscriptions set version=version+1 where hostname='%q' and profile_name='%q' and "
@@ -1618,10 +1633,13 @@ void *SWITCH_THREAD_FUNC sofia_presence_event_thread_run(switch_thread_t *thread
 
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Event Thread Started\n");
 
+	sofia_presence_coalesce_init();
+
 	while (mod_sofia_globals.running == 1) {
 		int count = 0;
 
-		if (switch_queue_pop(mod_sofia_globals.presence_queue, &pop) == SWITCH_STATUS_SUCCESS) {
+		/* wake up regularly so coalesced NOTIFYs go out even when no events arrive */
+		if (switch_queue_pop_timeout(mod_sofia_globals.presence_queue, &pop, 50000) == SWITCH_STATUS_SUCCESS) {
 			switch_event_t *event = (switch_event_t *) pop;
 
 			if (!pop) {
@@ -1656,9 +1674,12 @@ void *SWITCH_THREAD_FUNC sofia_presence_event_thread_run(switch_thread_t *thread
 			switch_event_destroy(&event);
 			count++;
 		}
+
+		sofia_presence_coalesce_flush();
 	}
 
 	do_flush();
+	sofia_presence_coalesce_destroy();
 
 	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Event Thread Ended\n");
 
@@ -2363,6 +2384,7 @@ static void _send_presence_notify(sofia_profile_t *profile,
 			   SIPTAG_CSEQ(cseq),
 			   TAG_END());
 
+	profile->pres_notify_sent++;
 
 	switch_safe_free(route_uri);
 	switch_safe_free(dcs);
@@ -2376,6 +2398,453 @@ static void _send_presence_notify(sofia_profile_t *profile,
 	switch_safe_free(path);
 }
 
+/* NOTIFY coalescing: a watcher gets at most one NOTIFY per presence-notify-coalesce-ms, the latest state wins */
+
+typedef struct pres_notify_s {
+	char *key;
+	char *profile_name;
+	char *full_to;
+	char *full_from;
+	char *contact;
+	char *expires;
+	char *call_id;
+	char *event;
+	char *ip;
+	char *port;
+	char *ct;
+	char *pl;
+	switch_time_t last_sent;
+	switch_time_t due;
+	switch_time_t window;
+	int heap_idx;
+	struct pres_notify_s *next;
+} pres_notify_t;
+
+/* idle watchers are forgotten by a table walk at most this often */
+#define PRES_COALESCE_PRUNE_USEC 1000000
+
+static struct {
+	switch_mutex_t *mutex;
+	switch_hash_t *hash;
+	/* held NOTIFYs ordered by due time */
+	pres_notify_t **heap;
+	int heap_count;
+	int heap_size;
+	uint32_t entries;
+	switch_time_t next_prune;
+} pres_coalesce;
+
+static void pres_heap_swap(int a, int b)
+{
+	pres_notify_t *tmp = pres_coalesce.heap[a];
+
+	pres_coalesce.heap[a] = pres_coalesce.heap[b];
+	pres_coalesce.heap[b] = tmp;
+	pres_coalesce.heap[a]->heap_idx = a;
+	pres_coalesce.heap[b]->heap_idx = b;
+}
+
+static void pres_heap_fix(int idx)
+{
+	int parent, child;
+
+	while (idx > 0 && pres_coalesce.heap[(parent = (idx - 1) / 2)]->due > pres_coalesce.heap[idx]->due) {
+		pres_heap_swap(idx, parent);
+		idx = parent;
+	}
+
+	while ((child = idx * 2 + 1) < pres_coalesce.heap_count) {
+		if (child + 1 < pres_coalesce.heap_count && pres_coalesce.heap[child + 1]->due < pres_coalesce.heap[child]->due) {
+			child++;
+		}
+
+		if (pres_coalesce.heap[idx]->due <= pres_coalesce.heap[child]->due) {
+			break;
+		}
+
+		pres_heap_swap(idx, child);
+		idx = child;
+	}
+}
+
+static void pres_heap_push(pres_notify_t *pn)
+{
+	if (pres_coalesce.heap_count == pres_coalesce.heap_size) {
+		pres_coalesce.heap_size = pres_coalesce.heap_size ? pres_coalesce.heap_size * 2 : 256;
+		pres_coalesce.heap = realloc(pres_coalesce.heap, pres_coalesce.heap_size * sizeof(*pres_coalesce.heap));
+		switch_assert(pres_coalesce.heap);
+	}
+
+	pn->heap_idx = pres_coalesce.heap_count;
+	pres_coalesce.heap[pres_coalesce.heap_count++] = pn;
+	pres_heap_fix(pn->heap_idx);
+}
+
+static void pres_heap_del(pres_notify_t *pn)
+{
+	int idx = pn->heap_idx;
+
+	if (idx < 0) {
+		return;
+	}
+
+	pn->heap_idx = -1;
+
+	if (idx != --pres_coalesce.heap_count) {
+		pres_coalesce.heap[idx] = pres_coalesce.heap[pres_coalesce.heap_count];
+		pres_coalesce.heap[idx]->heap_idx = idx;
+		pres_heap_fix(idx);
+	}
+}
+
+static void pres_notify_clear(pres_notify_t *pn)
+{
+	switch_safe_free(pn->full_to);
+	switch_safe_free(pn->full_from);
+	switch_safe_free(pn->contact);
+	switch_safe_free(pn->expires);
+	switch_safe_free(pn->call_id);
+	switch_safe_free(pn->event);
+	switch_safe_free(pn->ip);
+	switch_safe_free(pn->port);
+	switch_safe_free(pn->ct);
+	switch_safe_free(pn->pl);
+	pn->due = 0;
+}
+
+static void pres_notify_free(pres_notify_t *pn)
+{
+	pres_notify_clear(pn);
+	switch_safe_free(pn->key);
+	switch_safe_free(pn->profile_name);
+	free(pn);
+}
+
+#define pres_notify_dup(_s) ((_s) ? strdup(_s) : NULL)
+
+static void pres_notify_send(pres_notify_t *pn)
+{
+	sofia_profile_t *profile;
+
+	if ((profile = sofia_glue_find_profile(pn->profile_name))) {
+		send_presence_notify(profile, pn->full_to, pn->full_from, pn->contact, pn->expires, pn->call_id, pn->event,
+							 pn->ip, pn->port, pn->ct, pn->pl, NULL);
+		sofia_glue_release_profile(profile);
+	}
+}
+
+static void sofia_presence_coalesce_init(void)
+{
+	switch_mutex_init(&pres_coalesce.mutex, SWITCH_MUTEX_NESTED, mod_sofia_globals.pool);
+	switch_core_hash_init(&pres_coalesce.hash);
+}
+
+static void sofia_presence_coalesce_destroy(void)
+{
+	switch_hash_index_t *hi;
+	void *val;
+
+	if (!pres_coalesce.hash) {
+		return;
+	}
+
+	switch_mutex_lock(pres_coalesce.mutex);
+	for (hi = switch_core_hash_first(pres_coalesce.hash); hi; hi = switch_core_hash_next(&hi)) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		pres_notify_free((pres_notify_t *) val);
+	}
+	switch_core_hash_destroy(&pres_coalesce.hash);
+	switch_safe_free(pres_coalesce.heap);
+	pres_coalesce.heap_count = pres_coalesce.heap_size = 0;
+	pres_coalesce.entries = 0;
+	switch_mutex_unlock(pres_coalesce.mutex);
+}
+
+static void sofia_presence_coalesce_notify(sofia_profile_t *profile, const char *full_to, const char *full_from, const char *contact,
+										   const char *expires, const char *call_id, const char *event, const char *ip, const char *port,
+										   const char *ct, const char *pl)
+{
+	switch_time_t now = switch_micro_time_now();
+	switch_time_t window = (switch_time_t) profile->pres_notify_coalesce_ms * 1000;
+	int terminated = !expires || atol(expires) <= (long) switch_epoch_time_now(NULL);
+	pres_notify_t *pn;
+	char key[512];
+
+	if (!window || !pres_coalesce.hash || zstr(call_id)) {
+		send_presence_notify(profile, full_to, full_from, contact, expires, call_id, event, ip, port, ct, pl, NULL);
+		return;
+	}
+
+	switch_snprintf(key, sizeof(key), "%s/%s", profile->name, call_id);
+
+	switch_mutex_lock(pres_coalesce.mutex);
+
+	if (!(pn = switch_core_hash_find(pres_coalesce.hash, key))) {
+		switch_zmalloc(pn, sizeof(*pn));
+		pn->key = strdup(key);
+		pn->profile_name = strdup(profile->name);
+		pn->heap_idx = -1;
+		switch_core_hash_insert(pres_coalesce.hash, pn->key, pn);
+		pres_coalesce.entries++;
+	}
+
+	pn->window = window;
+
+	/* a terminating NOTIFY is never held back and supersedes anything pending */
+	if (terminated || (!pn->due && now - pn->last_sent >= window)) {
+		if (pn->due) {
+			profile->pres_notify_suppressed++;
+			pres_heap_del(pn);
+			pres_notify_clear(pn);
+		}
+		pn->last_sent = now;
+		switch_mutex_unlock(pres_coalesce.mutex);
+
+		send_presence_notify(profile, full_to, full_from, contact, expires, call_id, event, ip, port, ct, pl, NULL);
+		return;
+	}
+
+	if (pn->due) {
+		profile->pres_notify_suppressed++;
+		pres_notify_clear(pn);
+	}
+
+	pn->full_to = pres_notify_dup(full_to);
+	pn->full_from = pres_notify_dup(full_from);
+	pn->contact = pres_notify_dup(contact);
+	pn->expires = pres_notify_dup(expires);
+	pn->call_id = pres_notify_dup(call_id);
+	pn->event = pres_notify_dup(event);
+	pn->ip = pres_notify_dup(ip);
+	pn->port = pres_notify_dup(port);
+	pn->ct = pres_notify_dup(ct);
+	pn->pl = pres_notify_dup(pl);
+	pn->due = pn->last_sent + window;
+
+	if (pn->heap_idx < 0) {
+		pres_heap_push(pn);
+	} else {
+		pres_heap_fix(pn->heap_idx);
+	}
+
+	switch_mutex_unlock(pres_coalesce.mutex);
+}
+
+/* the subscription is gone, a NOTIFY still held for it must not go out */
+static void sofia_presence_coalesce_forget(sofia_profile_t *profile, const char *call_id)
+{
+	pres_notify_t *pn;
+	char key[512];
+
+	if (!pres_coalesce.hash || !pres_coalesce.entries || zstr(call_id)) {
+		return;
+	}
+
+	switch_snprintf(key, sizeof(key), "%s/%s", profile->name, call_id);
+
+	switch_mutex_lock(pres_coalesce.mutex);
+	if ((pn = switch_core_hash_find(pres_coalesce.hash, key))) {
+		pres_heap_del(pn);
+		switch_core_hash_delete(pres_coalesce.hash, pn->key);
+		pres_coalesce.entries--;
+		pres_notify_free(pn);
+	}
+	switch_mutex_unlock(pres_coalesce.mutex);
+}
+
+/* send whatever is due off the heap, forget watchers that have been quiet for a whole window */
+static void sofia_presence_coalesce_flush(void)
+{
+	switch_time_t now;
+	switch_hash_index_t *hi;
+	void *val;
+	pres_notify_t *pn, *send = NULL, *idle = NULL, *np;
+
+	/* nothing was ever held, coalescing is off everywhere */
+	if (!pres_coalesce.hash || !pres_coalesce.entries) {
+		return;
+	}
+
+	now = switch_micro_time_now();
+
+	switch_mutex_lock(pres_coalesce.mutex);
+
+	while (pres_coalesce.heap_count && (pn = pres_coalesce.heap[0])->due <= now) {
+		pres_heap_del(pn);
+
+		/* hand the pending state over to a copy that is sent once the lock is dropped */
+		switch_zmalloc(np, sizeof(*np));
+		*np = *pn;
+		np->key = NULL;
+		np->profile_name = strdup(pn->profile_name);
+		np->next = send;
+		send = np;
+
+		pn->full_to = pn->full_from = pn->contact = pn->expires = pn->call_id = NULL;
+		pn->event = pn->ip = pn->port = pn->ct = pn->pl = NULL;
+		pn->due = 0;
+		pn->last_sent = now;
+	}
+
+	if (now >= pres_coalesce.next_prune) {
+		pres_coalesce.next_prune = now + PRES_COALESCE_PRUNE_USEC;
+
+		for (hi = switch_core_hash_first(pres_coalesce.hash); hi; hi = switch_core_hash_next(&hi)) {
+			switch_core_hash_this(hi, NULL, NULL, &val);
+			pn = (pres_notify_t *) val;
+
+			if (!pn->due && now - pn->last_sent > pn->window) {
+				pn->next = idle;
+				idle = pn;
+			}
+		}
+
+		while ((pn = idle)) {
+			idle = pn->next;
+			switch_core_hash_delete(pres_coalesce.hash, pn->key);
+			pres_coalesce.entries--;
+			pres_notify_free(pn);
+		}
+	}
+
+	switch_mutex_unlock(pres_coalesce.mutex);
+
+	while ((pn = send)) {
+		send = pn->next;
+		pres_notify_send(pn);
+		pres_notify_free(pn);
+	}
+}
+
+/* watcher index: which presentities on a profile have subscriptions, so events nobody watches skip the subscription sql */
+
+typedef struct {
+	uint32_t count;
+} pres_watch_t;
+
+static int sofia_presence_watch_load_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	sofia_profile_t *profile = (sofia_profile_t *) pArg;
+
+	sofia_presence_watch_add(profile, argv[0], argv[1]);
+
+	return 0;
+}
+
+void sofia_presence_watch_init(sofia_profile_t *profile)
+{
+	char *sql;
+
+	switch_mutex_init(&profile->pres_watch_mutex, SWITCH_MUTEX_NESTED, profile->pool);
+	switch_core_hash_init_nocase(&profile->pres_watch_hash);
+	switch_core_hash_init(&profile->pres_watch_call_hash);
+
+	sql = switch_mprintf("select call_id,sub_to_user from sip_subscriptions where profile_name='%q' and hostname='%q'",
+						 profile->name, mod_sofia_globals.hostname);
+	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_watch_load_callback, profile);
+	switch_safe_free(sql);
+}
+
+void sofia_presence_watch_destroy(sofia_profile_t *profile)
+{
+	switch_hash_index_t *hi;
+	void *val;
+
+	if (!profile->pres_watch_hash) {
+		return;
+	}
+
+	switch_mutex_lock(profile->pres_watch_mutex);
+	for (hi = switch_core_hash_first(profile->pres_watch_hash); hi; hi = switch_core_hash_next(&hi)) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		free(val);
+	}
+	for (hi = switch_core_hash_first(profile->pres_watch_call_hash); hi; hi = switch_core_hash_next(&hi)) {
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		free(val);
+	}
+	switch_core_hash_destroy(&profile->pres_watch_hash);
+	switch_core_hash_destroy(&profile->pres_watch_call_hash);
+	switch_mutex_unlock(profile->pres_watch_mutex);
+}
+
+void sofia_presence_watch_del(sofia_profile_t *profile, const char *call_id)
+{
+	pres_watch_t *watch;
+	char *user;
+
+	sofia_presence_coalesce_forget(profile, call_id);
+
+	if (!profile->pres_watch_hash || zstr(call_id)) {
+		return;
+	}
+
+	switch_mutex_lock(profile->pres_watch_mutex);
+	if ((user = switch_core_hash_find(profile->pres_watch_call_hash, call_id))) {
+		switch_core_hash_delete(profile->pres_watch_call_hash, call_id);
+		profile->pres_watch_count--;
+
+		if ((watch = switch_core_hash_find(profile->pres_watch_hash, user)) && !--watch->count) {
+			switch_core_hash_delete(profile->pres_watch_hash, user);
+			free(watch);
+		}
+
+		free(user);
+	}
+	switch_mutex_unlock(profile->pres_watch_mutex);
+}
+
+void sofia_presence_watch_add(sofia_profile_t *profile, const char *call_id, const char *sub_to_user)
+{
+	pres_watch_t *watch;
+	char *user;
+
+	if (!profile->pres_watch_hash || zstr(call_id)) {
+		return;
+	}
+
+	switch_mutex_lock(profile->pres_watch_mutex);
+
+	if ((user = switch_core_hash_find(profile->pres_watch_call_hash, call_id))) {
+		if (!strcasecmp(user, switch_str_nil(sub_to_user))) {
+			switch_mutex_unlock(profile->pres_watch_mutex);
+			return;
+		}
+		sofia_presence_watch_del(profile, call_id);
+	}
+
+	if (!(watch = switch_core_hash_find(profile->pres_watch_hash, switch_str_nil(sub_to_user)))) {
+		switch_zmalloc(watch, sizeof(*watch));
+		switch_core_hash_insert(profile->pres_watch_hash, switch_str_nil(sub_to_user), watch);
+	}
+
+	watch->count++;
+	profile->pres_watch_count++;
+	switch_core_hash_insert(profile->pres_watch_call_hash, call_id, strdup(switch_str_nil(sub_to_user)));
+
+	switch_mutex_unlock(profile->pres_watch_mutex);
+}
+
+/* false only when the index knows nobody is subscribed; deletes it cannot mirror just leave it conservative */
+static int sofia_presence_watch_check(sofia_profile_t *profile, const char *user, const char *call_id)
+{
+	int r = 1;
+
+	if (!profile->pres_watch_hash) {
+		return r;
+	}
+
+	switch_mutex_lock(profile->pres_watch_mutex);
+	if (!zstr(call_id)) {
+		r = switch_core_hash_find(profile->pres_watch_call_hash, call_id) != NULL;
+	} else {
+		r = switch_core_hash_find(profile->pres_watch_hash, switch_str_nil(user)) != NULL;
+	}
+	switch_mutex_unlock(profile->pres_watch_mutex);
+
+	return r;
+}
+
 
 static int sofia_dialog_probe_notify_callback(void *pArg, int argc, char **argv, char **columnNames)
 {
@@ -3225,7 +3694,7 @@ static int sofia_presence_sub_callback(void *pArg, int argc, char **argv, char *
 		}
 	}
 
-	send_presence_notify(profile, full_to, full_from, contact, expires, call_id, event, ip, port, ct, pl, NULL);
+	sofia_presence_coalesce_notify(profile, full_to, full_from, contact, expires, call_id, event, ip, port, ct, pl);
 
 
  end:
@@ -3943,6 +4412,7 @@ void sofia_presence_handle_sip_i_subscribe(int status,
 
 			switch_assert(sql != NULL);
 			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+			sofia_presence_watch_del(profile, call_id);
 			sstr = switch_mprintf("terminated;reason=noresource");
 
 		} else {
@@ -3977,6 +4447,7 @@ void sofia_presence_handle_sip_i_subscribe(int status,
 
 
 			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+			sofia_presence_watch_add(profile, call_id, to_user);
 			sstr = switch_mprintf("active;expires=%ld", exp_delta);
 		}
 
@@ -4535,6 +5006,17 @@ static int sofia_presence_send_sql(void *pArg, int argc, char **argv, char **col
 }
 
 
+/* expired subscriptions get their final NOTIFY and leave the watcher index */
+static int sofia_presence_expire_sql(void *pArg, int argc, char **argv, char **columnNames)
+{
+	struct pres_sql_cb *cb = (struct pres_sql_cb *) pArg;
+
+	sofia_presence_send_sql(pArg, argc, argv, columnNames);
+	sofia_presence_watch_del(cb->profile, argv[4]);
+
+	return 0;
+}
+
 uint32_t sofia_presence_contact_count(sofia_profile_t *profile, const char *contact_str)
 {
 	char buf[32] = "";
@@ -5084,7 +5566,7 @@ void sofia_presence_check_subscriptions(sofia_profile_t *profile, time_t now)
 							 " from sip_subscriptions where ((expires > 0 and expires <= %ld)) and profile_name='%q' and hostname='%q'",
 							 (long) now, profile->name, mod_sofia_globals.hostname);
 
-		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_send_sql, &cb);
+		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_presence_expire_sql, &cb);
 		switch_safe_free(sql);
 
 		if (cb.ttl) {
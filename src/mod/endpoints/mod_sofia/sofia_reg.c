@@ -742,6 +742,757 @@ int sofia_reg_del_callback(void *pArg, int argc, char **argv, char **columnNames
 	return 0;
 }
 
+/* in-memory registration store: the local source of truth, the db is written behind it */
+
+struct sofia_reg_entry_s {
+	char *call_id;
+	char *sip_user;
+	char *sip_host;
+	char *presence_hosts;
+	char *contact;
+	char *status;
+	char *rpid;
+	char *user_agent;
+	char *server_user;
+	char *server_host;
+	char *network_ip;
+	char *network_port;
+	char *sip_username;
+	char *sip_realm;
+	int force_ping;
+	long expires;
+	long ping_expires;
+	int expire_idx;
+	int ping_idx;
+	struct sofia_reg_entry_s *next;
+};
+typedef struct sofia_reg_entry_s sofia_reg_entry_t;
+
+/* min-heap of entries, keyed on either expires or ping_expires */
+typedef struct {
+	sofia_reg_entry_t **entries;
+	int count;
+	int size;
+	int ping;
+} reg_heap_t;
+
+typedef struct {
+	sofia_reg_entry_t **entries;
+	int count;
+	int size;
+} reg_bucket_t;
+
+struct sofia_reg_store_s {
+	switch_mutex_t *mutex;
+	switch_hash_t *by_call_id;
+	switch_hash_t *by_user;
+	switch_hash_t *by_contact;
+	reg_heap_t expire_heap;
+	reg_heap_t ping_heap;
+	uint32_t count;
+	uint32_t rand_state;
+};
+
+/* xorshift32, seeded once per store so entries scheduled in the same microsecond still spread out */
+static long reg_store_rand(sofia_reg_store_t *store, int max)
+{
+	uint32_t x = store->rand_state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	store->rand_state = x;
+
+	return max > 0 ? (long) (x % (uint32_t) (max + 1)) : 0;
+}
+
+static void reg_bucket_add(switch_hash_t *hash, const char *key, sofia_reg_entry_t *entry)
+{
+	reg_bucket_t *bucket;
+
+	if (!(bucket = switch_core_hash_find(hash, key))) {
+		switch_zmalloc(bucket, sizeof(*bucket));
+		switch_core_hash_insert(hash, key, bucket);
+	}
+
+	if (bucket->count == bucket->size) {
+		bucket->size = bucket->size ? bucket->size * 2 : 4;
+		bucket->entries = realloc(bucket->entries, bucket->size * sizeof(*bucket->entries));
+		switch_assert(bucket->entries);
+	}
+
+	bucket->entries[bucket->count++] = entry;
+}
+
+static void reg_bucket_del(switch_hash_t *hash, const char *key, sofia_reg_entry_t *entry)
+{
+	reg_bucket_t *bucket;
+	int i;
+
+	if (!(bucket = switch_core_hash_find(hash, key))) {
+		return;
+	}
+
+	for (i = 0; i < bucket->count; i++) {
+		if (bucket->entries[i] == entry) {
+			bucket->entries[i] = bucket->entries[--bucket->count];
+			break;
+		}
+	}
+
+	if (!bucket->count) {
+		switch_core_hash_delete(hash, key);
+		switch_safe_free(bucket->entries);
+		free(bucket);
+	}
+}
+
+static void reg_bucket_free_all(switch_hash_t **hash)
+{
+	switch_hash_index_t *hi;
+	void *val;
+
+	for (hi = switch_core_hash_first(*hash); hi; hi = switch_core_hash_next(&hi)) {
+		reg_bucket_t *bucket;
+
+		switch_core_hash_this(hi, NULL, NULL, &val);
+		bucket = (reg_bucket_t *) val;
+		switch_safe_free(bucket->entries);
+		free(bucket);
+	}
+
+	switch_core_hash_destroy(hash);
+}
+
+#define reg_heap_key(_heap, _entry) ((_heap)->ping ? (_entry)->ping_expires : (_entry)->expires)
+#define reg_heap_idx(_heap, _entry) (*((_heap)->ping ? &(_entry)->ping_idx : &(_entry)->expire_idx))
+
+static void reg_heap_swap(reg_heap_t *heap, int a, int b)
+{
+	sofia_reg_entry_t *tmp = heap->entries[a];
+
+	heap->entries[a] = heap->entries[b];
+	heap->entries[b] = tmp;
+	reg_heap_idx(heap, heap->entries[a]) = a;
+	reg_heap_idx(heap, heap->entries[b]) = b;
+}
+
+static void reg_heap_fix(reg_heap_t *heap, int idx)
+{
+	int parent, child;
+
+	while (idx > 0 && reg_heap_key(heap, heap->entries[(parent = (idx - 1) / 2)]) > reg_heap_key(heap, heap->entries[idx])) {
+		reg_heap_swap(heap, idx, parent);
+		idx = parent;
+	}
+
+	while ((child = idx * 2 + 1) < heap->count) {
+		if (child + 1 < heap->count && reg_heap_key(heap, heap->entries[child + 1]) < reg_heap_key(heap, heap->entries[child])) {
+			child++;
+		}
+
+		if (reg_heap_key(heap, heap->entries[idx]) <= reg_heap_key(heap, heap->entries[child])) {
+			break;
+		}
+
+		reg_heap_swap(heap, idx, child);
+		idx = child;
+	}
+}
+
+/* entries with no due time (static registrations, nothing to ping) stay out of the heap */
+static void reg_heap_push(reg_heap_t *heap, sofia_reg_entry_t *entry)
+{
+	if (reg_heap_key(heap, entry) <= 0) {
+		reg_heap_idx(heap, entry) = -1;
+		return;
+	}
+
+	if (heap->count == heap->size) {
+		heap->size = heap->size ? heap->size * 2 : 1024;
+		heap->entries = realloc(heap->entries, heap->size * sizeof(*heap->entries));
+		switch_assert(heap->entries);
+	}
+
+	reg_heap_idx(heap, entry) = heap->count;
+	heap->entries[heap->count++] = entry;
+	reg_heap_fix(heap, reg_heap_idx(heap, entry));
+}
+
+static void reg_heap_del(reg_heap_t *heap, sofia_reg_entry_t *entry)
+{
+	int idx = reg_heap_idx(heap, entry);
+
+	if (idx < 0) {
+		return;
+	}
+
+	reg_heap_idx(heap, entry) = -1;
+
+	if (idx != --heap->count) {
+		heap->entries[idx] = heap->entries[heap->count];
+		reg_heap_idx(heap, heap->entries[idx]) = idx;
+		reg_heap_fix(heap, idx);
+	}
+}
+
+/* the same selection the ping_expires queries make, per options-ping mode */
+static int reg_entry_pingable(sofia_profile_t *profile, sofia_reg_entry_t *entry)
+{
+	if (sofia_test_pflag(profile, PFLAG_ALL_REG_OPTIONS_PING)) {
+		return 1;
+	} else if (sofia_test_pflag(profile, PFLAG_UDP_NAT_OPTIONS_PING)) {
+		return entry->force_ping || switch_stristr("UDP-NAT", entry->status);
+	} else if (sofia_test_pflag(profile, PFLAG_NAT_OPTIONS_PING)) {
+		return entry->force_ping || switch_stristr("NAT", entry->status) || switch_stristr("fs_nat=yes", entry->contact);
+	}
+
+	return entry->force_ping;
+}
+
+/* first ping lands anywhere in the interval so a burst of registrations does not ping in lockstep */
+static void reg_entry_schedule_ping(sofia_profile_t *profile, sofia_reg_entry_t *entry, time_t now, int first)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	int interval = profile->iping_seconds;
+
+	reg_heap_del(&store->ping_heap, entry);
+
+	if (interval <= 0 || !reg_entry_pingable(profile, entry)) {
+		entry->ping_expires = 0;
+		return;
+	}
+
+	if (first) {
+		entry->ping_expires = (long) now + 1 + reg_store_rand(store, interval);
+	} else {
+		entry->ping_expires = (long) now + interval / 2 + reg_store_rand(store, interval);
+	}
+
+	reg_heap_push(&store->ping_heap, entry);
+}
+
+static void reg_entry_free(sofia_reg_entry_t *entry)
+{
+	switch_safe_free(entry->call_id);
+	switch_safe_free(entry->sip_user);
+	switch_safe_free(entry->sip_host);
+	switch_safe_free(entry->presence_hosts);
+	switch_safe_free(entry->contact);
+	switch_safe_free(entry->status);
+	switch_safe_free(entry->rpid);
+	switch_safe_free(entry->user_agent);
+	switch_safe_free(entry->server_user);
+	switch_safe_free(entry->server_host);
+	switch_safe_free(entry->network_ip);
+	switch_safe_free(entry->network_port);
+	switch_safe_free(entry->sip_username);
+	switch_safe_free(entry->sip_realm);
+	free(entry);
+}
+
+/* unlink from every index, the caller owns the entry afterwards */
+static void reg_store_unlink(sofia_reg_store_t *store, sofia_reg_entry_t *entry)
+{
+	reg_bucket_del(store->by_call_id, entry->call_id, entry);
+	reg_bucket_del(store->by_user, entry->sip_user, entry);
+	reg_bucket_del(store->by_contact, entry->contact, entry);
+	reg_heap_del(&store->expire_heap, entry);
+	reg_heap_del(&store->ping_heap, entry);
+	store->count--;
+}
+
+static int reg_entry_host_match(sofia_reg_entry_t *entry, const char *host)
+{
+	return !host || !strcmp(entry->sip_host, host) || (entry->presence_hosts && strstr(entry->presence_hosts, host));
+}
+
+static void reg_entry_set(char **field, const char *val)
+{
+	switch_safe_free(*field);
+	*field = strdup(switch_str_nil(val));
+}
+
+static void reg_store_add(sofia_profile_t *profile, const char *call_id, const char *sip_user, const char *sip_host, const char *presence_hosts,
+						  const char *contact, const char *status, const char *rpid, long expires, const char *user_agent,
+						  const char *server_user, const char *server_host, const char *network_ip, const char *network_port,
+						  const char *sip_username, const char *sip_realm, int force_ping)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	sofia_reg_entry_t *entry;
+
+	switch_zmalloc(entry, sizeof(*entry));
+
+	reg_entry_set(&entry->call_id, call_id);
+	reg_entry_set(&entry->sip_user, sip_user);
+	reg_entry_set(&entry->sip_host, sip_host);
+	reg_entry_set(&entry->presence_hosts, presence_hosts);
+	reg_entry_set(&entry->contact, contact);
+	reg_entry_set(&entry->status, status);
+	reg_entry_set(&entry->rpid, rpid);
+	reg_entry_set(&entry->user_agent, user_agent);
+	reg_entry_set(&entry->server_user, server_user);
+	reg_entry_set(&entry->server_host, server_host);
+	reg_entry_set(&entry->network_ip, network_ip);
+	reg_entry_set(&entry->network_port, network_port);
+	reg_entry_set(&entry->sip_username, sip_username);
+	reg_entry_set(&entry->sip_realm, sip_realm);
+	entry->expires = expires;
+	entry->force_ping = force_ping;
+	entry->ping_idx = -1;
+
+	switch_mutex_lock(store->mutex);
+	reg_bucket_add(store->by_call_id, entry->call_id, entry);
+	reg_bucket_add(store->by_user, entry->sip_user, entry);
+	reg_bucket_add(store->by_contact, entry->contact, entry);
+	reg_heap_push(&store->expire_heap, entry);
+	reg_entry_schedule_ping(profile, entry, switch_epoch_time_now(NULL), 1);
+	store->count++;
+	switch_mutex_unlock(store->mutex);
+}
+
+typedef enum {
+	REG_MATCH_CALL_ID = (1 << 0),
+	REG_MATCH_USER = (1 << 1),
+	REG_MATCH_HOST = (1 << 2),
+	REG_MATCH_CONTACT = (1 << 3),
+	REG_MATCH_NOT_EXPIRES = (1 << 4)
+} reg_match_t;
+
+static int reg_entry_match(sofia_reg_entry_t *entry, int match, const char *call_id, const char *user,
+						   const char *host, const char *contact, long expires)
+{
+	return !(((match & REG_MATCH_CALL_ID) && strcmp(entry->call_id, call_id)) ||
+			 ((match & REG_MATCH_USER) && strcmp(entry->sip_user, user)) ||
+			 ((match & REG_MATCH_HOST) && strcmp(entry->sip_host, host)) ||
+			 ((match & REG_MATCH_CONTACT) && strcmp(entry->contact, contact)) ||
+			 ((match & REG_MATCH_NOT_EXPIRES) && entry->expires == expires));
+}
+
+/* mirrors the where clauses of the registration deletes; returns the removed entries chained on ->next */
+static sofia_reg_entry_t *reg_store_take(sofia_reg_store_t *store, int match, const char *call_id, const char *user,
+										 const char *host, const char *contact, long expires)
+{
+	sofia_reg_entry_t *list = NULL, *entry;
+	reg_bucket_t *bucket = NULL;
+	int i;
+
+	switch_mutex_lock(store->mutex);
+
+	if ((match & REG_MATCH_CALL_ID)) {
+		bucket = switch_core_hash_find(store->by_call_id, call_id);
+	} else if ((match & REG_MATCH_USER)) {
+		bucket = switch_core_hash_find(store->by_user, user);
+	} else if ((match & REG_MATCH_CONTACT)) {
+		bucket = switch_core_hash_find(store->by_contact, contact);
+	} else {
+		switch_hash_index_t *hi;
+		void *val;
+
+		for (hi = switch_core_hash_first(store->by_call_id); hi; hi = switch_core_hash_next(&hi)) {
+			switch_core_hash_this(hi, NULL, NULL, &val);
+
+			for (i = 0; i < ((reg_bucket_t *) val)->count; i++) {
+				entry = ((reg_bucket_t *) val)->entries[i];
+
+				if (reg_entry_match(entry, match, call_id, user, host, contact, expires)) {
+					entry->next = list;
+					list = entry;
+				}
+			}
+		}
+	}
+
+	for (i = 0; bucket && i < bucket->count; i++) {
+		entry = bucket->entries[i];
+
+		if (reg_entry_match(entry, match, call_id, user, host, contact, expires)) {
+			entry->next = list;
+			list = entry;
+		}
+	}
+
+	/* unlink only once the walk is done, it may free the bucket we walked */
+	for (entry = list; entry; entry = entry->next) {
+		reg_store_unlink(store, entry);
+	}
+
+	switch_mutex_unlock(store->mutex);
+
+	return list;
+}
+
+static void reg_store_free_list(sofia_reg_entry_t *list)
+{
+	sofia_reg_entry_t *entry;
+
+	while ((entry = list)) {
+		list = list->next;
+		reg_entry_free(entry);
+	}
+}
+
+static void reg_store_drop(sofia_profile_t *profile, int match, const char *call_id, const char *user, const char *host, const char *contact, long expires)
+{
+	reg_store_free_list(reg_store_take(profile->reg_store, match, call_id, user, host, contact, expires));
+}
+
+/* fires the same expire and presence events the sql sweep does, the caller still deletes the rows */
+static void reg_store_expire_list(sofia_profile_t *profile, sofia_reg_entry_t *list, int reboot)
+{
+	sofia_reg_entry_t *entry;
+	char expires[32], reboot_str[8];
+	char *argv[15];
+
+	switch_snprintf(reboot_str, sizeof(reboot_str), "%d", reboot);
+
+	for (entry = list; entry; entry = entry->next) {
+		switch_snprintf(expires, sizeof(expires), "%ld", entry->expires);
+
+		argv[0] = entry->call_id;
+		argv[1] = entry->sip_user;
+		argv[2] = entry->sip_host;
+		argv[3] = entry->contact;
+		argv[4] = entry->status;
+		argv[5] = entry->rpid;
+		argv[6] = expires;
+		argv[7] = entry->user_agent;
+		argv[8] = entry->server_user;
+		argv[9] = entry->server_host;
+		argv[10] = profile->name;
+		argv[11] = entry->network_ip;
+		argv[12] = entry->network_port;
+		argv[13] = reboot_str;
+		argv[14] = entry->sip_realm;
+
+		sofia_reg_del_callback(profile, 15, argv, NULL);
+	}
+
+	reg_store_free_list(list);
+}
+
+static int reg_store_expire(sofia_profile_t *profile, time_t now, int reboot)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	sofia_reg_entry_t *list = NULL, *entry;
+	int expired = 0;
+
+	switch_mutex_lock(store->mutex);
+	while (store->expire_heap.count && (!now || store->expire_heap.entries[0]->expires <= (long) now)) {
+		entry = store->expire_heap.entries[0];
+		reg_store_unlink(store, entry);
+		entry->next = list;
+		list = entry;
+		expired++;
+	}
+	switch_mutex_unlock(store->mutex);
+
+	reg_store_expire_list(profile, list, reboot);
+
+	return expired;
+}
+
+typedef int (*reg_store_callback_t) (void *pArg, int argc, char **argv, char **columnNames);
+
+/* feeds contact[,expires] rows to the same callbacks the sql lookups use */
+static int reg_store_find(sofia_profile_t *profile, const char *user, const char *host, reg_store_callback_t callback, void *pArg)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	reg_bucket_t *bucket;
+	char expires[32];
+	char *argv[2];
+	int i, found = 0;
+
+	switch_mutex_lock(store->mutex);
+
+	if ((bucket = switch_core_hash_find(store->by_user, user))) {
+		for (i = 0; i < bucket->count; i++) {
+			sofia_reg_entry_t *entry = bucket->entries[i];
+
+			if (!reg_entry_host_match(entry, host)) {
+				continue;
+			}
+
+			found++;
+
+			if (callback) {
+				switch_snprintf(expires, sizeof(expires), "%ld", entry->expires);
+				argv[0] = entry->contact;
+				argv[1] = expires;
+
+				if (callback(pArg, 2, argv, NULL)) {
+					break;
+				}
+			}
+		}
+	}
+
+	switch_mutex_unlock(store->mutex);
+
+	return found;
+}
+
+static int reg_store_has_contact(sofia_profile_t *profile, const char *user, const char *username, const char *host, const char *contact)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	reg_bucket_t *bucket;
+	int i, found = 0;
+
+	switch_mutex_lock(store->mutex);
+
+	if ((bucket = switch_core_hash_find(store->by_contact, contact))) {
+		for (i = 0; i < bucket->count; i++) {
+			sofia_reg_entry_t *entry = bucket->entries[i];
+
+			if (!strcmp(entry->sip_user, user) && !strcmp(entry->sip_username, switch_str_nil(username)) && !strcmp(entry->sip_host, host)) {
+				found++;
+			}
+		}
+	}
+
+	switch_mutex_unlock(store->mutex);
+
+	return found;
+}
+
+static int reg_store_update(sofia_profile_t *profile, const char *user, const char *username, const char *host, const char *contact,
+							const char *call_id, const char *network_ip, const char *network_port, const char *server_host, long expires,
+							int force_ping)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	reg_bucket_t *bucket;
+	int i, found = 0;
+
+	switch_mutex_lock(store->mutex);
+
+	if ((bucket = switch_core_hash_find(store->by_contact, contact))) {
+		for (i = 0; i < bucket->count; i++) {
+			sofia_reg_entry_t *entry = bucket->entries[i];
+
+			if (strcmp(entry->sip_user, user) || strcmp(entry->sip_username, switch_str_nil(username)) || strcmp(entry->sip_host, host)) {
+				continue;
+			}
+
+			if (strcmp(entry->call_id, call_id)) {
+				reg_bucket_del(store->by_call_id, entry->call_id, entry);
+				reg_entry_set(&entry->call_id, call_id);
+				reg_bucket_add(store->by_call_id, entry->call_id, entry);
+			}
+
+			reg_entry_set(&entry->network_ip, network_ip);
+			reg_entry_set(&entry->network_port, network_port);
+			reg_entry_set(&entry->server_host, server_host);
+			reg_entry_set(&entry->presence_hosts, profile->presence_hosts);
+
+			reg_heap_del(&store->expire_heap, entry);
+			entry->expires = expires;
+			reg_heap_push(&store->expire_heap, entry);
+
+			if (entry->force_ping != force_ping) {
+				entry->force_ping = force_ping;
+				reg_entry_schedule_ping(profile, entry, switch_epoch_time_now(NULL), 1);
+			}
+
+			found++;
+		}
+	}
+
+	switch_mutex_unlock(store->mutex);
+
+	return found;
+}
+
+static int reg_store_load_callback(void *pArg, int argc, char **argv, char **columnNames)
+{
+	sofia_profile_t *profile = (sofia_profile_t *) pArg;
+
+	reg_store_add(profile, argv[0], argv[1], argv[2], argv[3], argv[4], argv[5], argv[6], atol(switch_str_nil(argv[7])),
+				  argv[8], argv[9], argv[10], argv[11], argv[12], argv[13], argv[14], atoi(switch_str_nil(argv[15])));
+
+	return 0;
+}
+
+void sofia_reg_store_create(sofia_profile_t *profile)
+{
+	sofia_reg_store_t *store;
+	char *sql;
+
+	store = switch_core_alloc(profile->pool, sizeof(*store));
+	switch_mutex_init(&store->mutex, SWITCH_MUTEX_NESTED, profile->pool);
+	switch_core_hash_init(&store->by_call_id);
+	switch_core_hash_init(&store->by_user);
+	switch_core_hash_init(&store->by_contact);
+	store->ping_heap.ping = 1;
+	store->rand_state = (uint32_t) switch_micro_time_now() ^ (uint32_t) (intptr_t) store;
+	if (!store->rand_state) {
+		store->rand_state = 0x9e3779b9;
+	}
+	profile->reg_store = store;
+
+	/* pick up what this box had registered before a restart */
+	sql = switch_mprintf("select call_id,sip_user,sip_host,presence_hosts,contact,status,rpid,expires,user_agent,"
+						 "server_user,server_host,network_ip,network_port,sip_username,sip_realm,force_ping "
+						 "from sip_registrations where profile_name='%q' and hostname='%q'", profile->name, mod_sofia_globals.hostname);
+	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, reg_store_load_callback, profile);
+	switch_safe_free(sql);
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Profile %s keeping registrations in memory, loaded %u\n", profile->name, store->count);
+}
+
+void sofia_reg_store_destroy(sofia_profile_t *profile)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	int i;
+
+	if (!store) {
+		return;
+	}
+
+	switch_mutex_lock(store->mutex);
+	profile->reg_store = NULL;
+
+	/* every entry is in the call-id index exactly once */
+	{
+		switch_hash_index_t *hi;
+		void *val;
+
+		for (hi = switch_core_hash_first(store->by_call_id); hi; hi = switch_core_hash_next(&hi)) {
+			reg_bucket_t *bucket;
+
+			switch_core_hash_this(hi, NULL, NULL, &val);
+			bucket = (reg_bucket_t *) val;
+
+			for (i = 0; i < bucket->count; i++) {
+				reg_entry_free(bucket->entries[i]);
+			}
+		}
+	}
+
+	reg_bucket_free_all(&store->by_call_id);
+	reg_bucket_free_all(&store->by_user);
+	reg_bucket_free_all(&store->by_contact);
+	switch_safe_free(store->expire_heap.entries);
+	switch_safe_free(store->ping_heap.entries);
+	switch_mutex_unlock(store->mutex);
+}
+
+/* only the entries that are due get pinged, each one is rescheduled on its own jittered interval */
+static void reg_store_check_ping(sofia_profile_t *profile, time_t now)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	sofia_reg_entry_t *entry;
+	char expires[32];
+	char *argv[11];
+
+	switch_mutex_lock(store->mutex);
+	while (store->ping_heap.count && store->ping_heap.entries[0]->ping_expires <= (long) now) {
+		entry = store->ping_heap.entries[0];
+		switch_snprintf(expires, sizeof(expires), "%ld", entry->expires);
+
+		argv[0] = entry->call_id;
+		argv[1] = entry->sip_user;
+		argv[2] = entry->sip_host;
+		argv[3] = entry->contact;
+		argv[4] = entry->status;
+		argv[5] = entry->rpid;
+		argv[6] = expires;
+		argv[7] = entry->user_agent;
+		argv[8] = entry->server_user;
+		argv[9] = entry->server_host;
+		argv[10] = profile->name;
+
+		sofia_reg_nat_callback(profile, 11, argv, NULL);
+		reg_entry_schedule_ping(profile, entry, now, 0);
+	}
+	switch_mutex_unlock(store->mutex);
+}
+
+uint32_t sofia_reg_store_count(sofia_profile_t *profile)
+{
+	return profile->reg_store ? profile->reg_store->count : 0;
+}
+
+/* for writers outside this file that insert or delete sip_registrations rows directly */
+void sofia_reg_store_add(sofia_profile_t *profile, const char *call_id, const char *sip_user, const char *sip_host, const char *presence_hosts,
+						 const char *contact, const char *status, const char *rpid, long expires, const char *user_agent,
+						 const char *server_user, const char *server_host, const char *network_ip, const char *network_port,
+						 const char *sip_username, const char *sip_realm)
+{
+	if (profile->reg_store) {
+		reg_store_add(profile, call_id, sip_user, sip_host, presence_hosts, contact, status, rpid, expires, user_agent,
+					  server_user, server_host, network_ip, network_port, sip_username, sip_realm, 0);
+	}
+}
+
+/* NULL arguments match anything, call_id or sip_user is required */
+void sofia_reg_store_del(sofia_profile_t *profile, const char *call_id, const char *sip_user, const char *sip_host,
+						 const char *network_ip, const char *network_port)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	sofia_reg_entry_t *list = NULL, *entry;
+	reg_bucket_t *bucket;
+	int i;
+
+	if (!store || (!call_id && !sip_user)) {
+		return;
+	}
+
+	switch_mutex_lock(store->mutex);
+
+	bucket = call_id ? switch_core_hash_find(store->by_call_id, call_id) : switch_core_hash_find(store->by_user, sip_user);
+
+	for (i = 0; bucket && i < bucket->count; i++) {
+		entry = bucket->entries[i];
+
+		if ((call_id && strcmp(entry->call_id, call_id)) || (sip_user && strcmp(entry->sip_user, sip_user)) ||
+			(sip_host && strcmp(entry->sip_host, sip_host)) || (network_ip && strcmp(entry->network_ip, network_ip)) ||
+			(network_port && strcmp(entry->network_port, network_port))) {
+			continue;
+		}
+
+		entry->next = list;
+		list = entry;
+	}
+
+	for (entry = list; entry; entry = entry->next) {
+		reg_store_unlink(store, entry);
+	}
+
+	switch_mutex_unlock(store->mutex);
+
+	reg_store_free_list(list);
+}
+
+/* moves the expiry of matching entries, the next sweep unregisters them like the sql one would */
+void sofia_reg_store_set_expires(sofia_profile_t *profile, const char *call_id, const char *sip_user, const char *sip_host, long expires)
+{
+	sofia_reg_store_t *store = profile->reg_store;
+	reg_bucket_t *bucket;
+	int i;
+
+	if (!store) {
+		return;
+	}
+
+	switch_mutex_lock(store->mutex);
+
+	if ((bucket = switch_core_hash_find(store->by_call_id, call_id))) {
+		for (i = 0; i < bucket->count; i++) {
+			sofia_reg_entry_t *entry = bucket->entries[i];
+
+			if (strcmp(entry->sip_user, sip_user) || strcmp(entry->sip_host, sip_host)) {
+				continue;
+			}
+
+			reg_heap_del(&store->expire_heap, entry);
+			entry->expires = expires;
+			reg_heap_push(&store->expire_heap, entry);
+		}
+	}
+
+	switch_mutex_unlock(store->mutex);
+}
+
 void sofia_reg_expire_call_id(sofia_profile_t *profile, const char *call_id, int reboot)
 {
 	char *sql = NULL;
@@ -768,16 +1519,36 @@ void sofia_reg_expire_call_id(sofia_profile_t *profile, const char *call_id, int
 		sqlextra = switch_mprintf(" or (sip_user='%q' and sip_host='%q')", user, host);
 	}
 
-	sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
-						 ",user_agent,server_user,server_host,profile_name,network_ip,network_port"
-						 ",%d,sip_realm from sip_registrations where call_id='%q' %s", reboot, call_id, sqlextra);
+	if (profile->reg_store) {
+		sofia_reg_entry_t *list, *last;
 
+		list = reg_store_take(profile->reg_store, REG_MATCH_CALL_ID, call_id, NULL, NULL, NULL, 0);
 
-	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
-	switch_safe_free(sql);
+		if ((last = list)) {
+			while (last->next) {
+				last = last->next;
+			}
+			last->next = reg_store_take(profile->reg_store, zstr(user) ? REG_MATCH_HOST : REG_MATCH_USER | REG_MATCH_HOST, NULL, user, host, NULL, 0);
+		} else {
+			list = reg_store_take(profile->reg_store, zstr(user) ? REG_MATCH_HOST : REG_MATCH_USER | REG_MATCH_HOST, NULL, user, host, NULL, 0);
+		}
 
-	sql = switch_mprintf("delete from sip_registrations where call_id='%q' %s", call_id, sqlextra);
-	sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+		reg_store_expire_list(profile, list, reboot);
+
+		sql = switch_mprintf("delete from sip_registrations where call_id='%q' %s", call_id, sqlextra);
+		sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+	} else {
+		sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
+							 ",user_agent,server_user,server_host,profile_name,network_ip,network_port"
+							 ",%d,sip_realm from sip_registrations where call_id='%q' %s", reboot, call_id, sqlextra);
+
+
+		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
+		switch_safe_free(sql);
+
+		sql = switch_mprintf("delete from sip_registrations where call_id='%q' %s", call_id, sqlextra);
+		sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+	}
 
 	switch_safe_free(sqlextra);
 	switch_safe_free(sql);
@@ -789,18 +1560,23 @@ void sofia_reg_check_expire(sofia_profile_t *profile, time_t now, int reboot)
 {
 	char *sql;
 
-	if (now) {
-		sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
-						",user_agent,server_user,server_host,profile_name,network_ip, network_port"
-						",%d,sip_realm from sip_registrations where expires > 0 and expires <= %ld", reboot, (long) now);
+	if (profile->reg_store) {
+		reg_store_expire(profile, now, reboot);
 	} else {
-		sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
-						",user_agent,server_user,server_host,profile_name,network_ip, network_port" ",%d,sip_realm from sip_registrations where expires > 0", reboot);
-	}
+		if (now) {
+			sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
+							",user_agent,server_user,server_host,profile_name,network_ip, network_port"
+							",%d,sip_realm from sip_registrations where expires > 0 and expires <= %ld", reboot, (long) now);
+		} else {
+			sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
+							",user_agent,server_user,server_host,profile_name,network_ip, network_port" ",%d,sip_realm from sip_registrations where expires > 0", reboot);
+		}
 
-	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
-	free(sql);
+		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
+		free(sql);
+	}
 
+	/* always swept, rows the store never saw must still go */
 	if (now) {
 		sql = switch_mprintf("delete from sip_registrations where expires > 0 and expires <= %ld and hostname='%q'",
 						(long) now, mod_sofia_globals.hostname);
@@ -881,7 +1657,9 @@ void sofia_reg_check_ping_expire(sofia_profile_t *profile, time_t now, int inter
 	char buf[32] = "";
 	int count;
 
-	if (now) {
+	if (now && profile->reg_store) {
+		reg_store_check_ping(profile, now);
+	} else if (now) {
 		if (sofia_test_pflag(profile, PFLAG_ALL_REG_OPTIONS_PING)) {
 			sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,"
 								 "expires,user_agent,server_user,server_host,profile_name "
@@ -998,13 +1776,17 @@ void sofia_reg_check_sync(sofia_profile_t *profile)
 {
 	char *sql;
 
-	sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
-					",user_agent,server_user,server_host,profile_name,network_ip,network_port,0,sip_realm"
-					" from sip_registrations where expires > 0");
+	if (profile->reg_store) {
+		reg_store_expire(profile, 0, 0);
+	} else {
+		sql = switch_mprintf("select call_id,sip_user,sip_host,contact,status,rpid,expires"
+						",user_agent,server_user,server_host,profile_name,network_ip,network_port,0,sip_realm"
+						" from sip_registrations where expires > 0");
 
 
-	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
-	switch_safe_free(sql);
+		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_del_callback, profile);
+		switch_safe_free(sql);
+	}
 
 	sql = switch_mprintf("delete from sip_registrations where expires > 0 and hostname='%q'", mod_sofia_globals.hostname);
 	sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
@@ -1036,7 +1818,10 @@ char *sofia_reg_find_reg_url(sofia_profile_t *profile, const char *user, const c
 	cbt.val = val;
 	cbt.len = len;
 
-	if (host) {
+	if (profile->reg_store) {
+		reg_store_find(profile, user, host, sofia_reg_find_callback, &cbt);
+		sql = NULL;
+	} else if (host) {
 		sql = switch_mprintf("select contact from sip_registrations where sip_user='%q' and (sip_host='%q' or presence_hosts like '%%%q%%')",
 						user, host, host);
 	} else {
@@ -1044,7 +1829,9 @@ char *sofia_reg_find_reg_url(sofia_profile_t *profile, const char *user, const c
 	}
 
 
-	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_find_callback, &cbt);
+	if (sql) {
+		sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_find_callback, &cbt);
+	}
 
 	switch_safe_free(sql);
 
@@ -1070,6 +1857,11 @@ switch_console_callback_match_t *sofia_reg_find_reg_url_multi(sofia_profile_t *p
 		return NULL;
 	}
 
+	if (profile->reg_store) {
+		reg_store_find(profile, user, host, sofia_reg_find_callback, &cbt);
+		return cbt.list;
+	}
+
 	if (host) {
 		sql = switch_mprintf("select contact from sip_registrations where sip_user='%q' and (sip_host='%q' or presence_hosts like '%%%q%%')",
 						user, host, host);
@@ -1096,6 +1888,15 @@ switch_console_callback_match_t *sofia_reg_find_reg_url_with_positive_expires_mu
 		return NULL;
 	}
 
+	cbt.time = reg_time;
+	cbt.contact_str = contact_str;
+	cbt.exptime = exptime;
+
+	if (profile->reg_store) {
+		reg_store_find(profile, user, host, sofia_reg_find_reg_with_positive_expires_callback, &cbt);
+		return cbt.list;
+	}
+
 	if (host) {
 		sql = switch_mprintf("select contact,expires from sip_registrations where sip_user='%q' and (sip_host='%q' or presence_hosts like '%%%q%%')",
 						user, host, host);
@@ -1103,10 +1904,6 @@ switch_console_callback_match_t *sofia_reg_find_reg_url_with_positive_expires_mu
 		sql = switch_mprintf("select contact,expires from sip_registrations where sip_user='%q'", user);
 	}
 
-	cbt.time = reg_time;
-	cbt.contact_str = contact_str;
-	cbt.exptime = exptime;
-
 	sofia_glue_execute_sql_callback(profile, profile->dbh_mutex, sql, sofia_reg_find_reg_with_positive_expires_callback, &cbt);
 	free(sql);
 
@@ -1154,6 +1951,10 @@ uint32_t sofia_reg_reg_count(sofia_profile_t *profile, const char *user, const c
 {
 	char buf[32] = "";
 	char *sql;
+
+	if (profile->reg_store) {
+		return reg_store_find(profile, user, host, NULL, NULL);
+	}
 	
 	sql = switch_mprintf("select count(*) from sip_registrations where profile_name='%q' and "
 						 "sip_user='%q' and (sip_host='%q' or presence_hosts like '%%%q%%')", profile->name, user, host, host);
@@ -1885,14 +2686,29 @@ uint8_t sofia_reg_handle_register_token(nua_t *nua, sofia_profile_t *profile, nu
 				if (multi_reg_contact) {
 					sql =
 						switch_mprintf("delete from sip_registrations where sip_user='%q' and sip_host='%q' and contact='%q'", to_user, reg_host, contact_str);
+					if (profile->reg_store) {
+						reg_store_drop(profile, REG_MATCH_USER | REG_MATCH_HOST | REG_MATCH_CONTACT, NULL, to_user, reg_host, contact_str, 0);
+					}
 				} else {
 					sql = switch_mprintf("delete from sip_registrations where call_id='%q'", call_id);
+					if (profile->reg_store) {
+						reg_store_drop(profile, REG_MATCH_CALL_ID, call_id, NULL, NULL, NULL, 0);
+					}
 				}
 			} else {
 				sql = switch_mprintf("delete from sip_registrations where sip_user='%q' and sip_host='%q'", to_user, reg_host);
+				if (profile->reg_store) {
+					reg_store_drop(profile, REG_MATCH_USER | REG_MATCH_HOST, NULL, to_user, reg_host, NULL, 0);
+				}
 			}
 
-			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+			if (profile->reg_store) {
+				sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+			} else {
+				sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+			}
+		} else if (profile->reg_store) {
+			update_registration = reg_store_has_contact(profile, to_user, username, reg_host, contact_str) ? SWITCH_TRUE : SWITCH_FALSE;
 		} else {
 			char buf[32] = "";
 
@@ -1974,7 +2790,18 @@ uint8_t sofia_reg_handle_register_token(nua_t *nua, sofia_profile_t *profile, nu
 								 to_user, username, reg_host, contact_str);
 		}				 
 
-		if (sql) {
+		if (sql && profile->reg_store) {
+			long expires = (long) reg_time + (long) exptime + profile->sip_expires_late_margin;
+
+			if (update_registration) {
+				reg_store_update(profile, to_user, username, reg_host, contact_str, call_id, network_ip, network_port_c, guess_ip4, expires, force_ping);
+			} else {
+				reg_store_add(profile, call_id, to_user, reg_host, profile->presence_hosts, contact_str, reg_desc, rpid, expires,
+							  agent, from_user, guess_ip4, network_ip, network_port_c, username, realm, force_ping);
+			}
+
+			sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+		} else if (sql) {
 			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
 		}
 
@@ -1990,8 +2817,16 @@ uint8_t sofia_reg_handle_register_token(nua_t *nua, sofia_profile_t *profile, nu
 		if (multi_reg) {
 			if (multi_reg_contact) {
 				sql = switch_mprintf("delete from sip_registrations where contact='%q' and expires!=%ld", contact_str, (long) reg_time + (long) exptime + profile->sip_expires_late_margin);
+				if (profile->reg_store) {
+					reg_store_drop(profile, REG_MATCH_CONTACT | REG_MATCH_NOT_EXPIRES, NULL, NULL, NULL, contact_str,
+								   (long) reg_time + (long) exptime + profile->sip_expires_late_margin);
+				}
 			} else {
 				sql = switch_mprintf("delete from sip_registrations where call_id='%q' and expires!=%ld", call_id, (long) reg_time + (long) exptime + profile->sip_expires_late_margin);
+				if (profile->reg_store) {
+					reg_store_drop(profile, REG_MATCH_CALL_ID | REG_MATCH_NOT_EXPIRES, call_id, NULL, NULL, NULL,
+								   (long) reg_time + (long) exptime + profile->sip_expires_late_margin);
+				}
 			}
 			
 			sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
@@ -2070,14 +2905,28 @@ uint8_t sofia_reg_handle_register_token(nua_t *nua, sofia_profile_t *profile, nu
 			} else {
 				sql = switch_mprintf("delete from sip_registrations where call_id='%q'", call_id);
 			}
-	
-			sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+
+			if (profile->reg_store) {
+				if (multi_reg_contact) {
+					reg_store_drop(profile, REG_MATCH_USER | REG_MATCH_HOST | REG_MATCH_CONTACT, NULL, to_user, reg_host, contact_str, 0);
+				} else {
+					reg_store_drop(profile, REG_MATCH_CALL_ID, call_id, NULL, NULL, NULL, 0);
+				}
+				sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+			} else {
+				sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+			}
 
 			switch_safe_free(icontact);
 		} else {
 
 			if ((sql = switch_mprintf("delete from sip_registrations where sip_user='%q' and sip_host='%q'", to_user, reg_host))) {
-				sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+				if (profile->reg_store) {
+					reg_store_drop(profile, REG_MATCH_USER | REG_MATCH_HOST, NULL, to_user, reg_host, NULL, 0);
+					sofia_glue_execute_sql(profile, &sql, SWITCH_TRUE);
+				} else {
+					sofia_glue_execute_sql_now(profile, &sql, SWITCH_TRUE);
+				}
 			}
 		}
 	}
@@ -679,6 +679,21 @@ SWITCH_DECLARE(switch_status_t) switch_thread_create(switch_thread_t ** new_thre
 	return apr_thread_create(new_thread, attr, func, data, cont);
 }
 
+SWITCH_DECLARE(switch_status_t) switch_threadkey_private_create(switch_threadkey_t ** key, void (*dest) (void *), switch_memory_pool_t *pool)
+{
+	return apr_threadkey_private_create(key, dest, pool);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_threadkey_private_get(void **data, switch_threadkey_t *key)
+{
+	return apr_threadkey_private_get(data, key);
+}
+
+SWITCH_DECLARE(switch_status_t) switch_threadkey_private_set(void *data, switch_threadkey_t *key)
+{
+	return apr_threadkey_private_set(data, key);
+}
+
 SWITCH_DECLARE(switch_interval_time_t) switch_interval_time_from_timeval(struct timeval *tvp)
 {
 	return ((switch_interval_time_t)tvp->tv_sec * 1000000) + tvp->tv_usec / 1000;
@@ -951,6 +966,182 @@ SWITCH_DECLARE(switch_status_t) switch_socket_recvfrom(switch_sockaddr_t *from,
 	return (switch_status_t)r;
 }
 
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+static void sockmsg_addr_set(switch_sockaddr_t *sa)
+{
+	/* mirror what apr does to a sockaddr after recvfrom() */
+	sa->family = sa->sa.sin.sin_family;
+	sa->port = ntohs(sa->sa.sin.sin_port);
+
+	if (sa->family == AF_INET) {
+		sa->salen = sizeof(struct sockaddr_in);
+		sa->addr_str_len = 16;
+		sa->ipaddr_ptr = &(sa->sa.sin.sin_addr);
+		sa->ipaddr_len = sizeof(struct in_addr);
+	}
+#if APR_HAVE_IPV6
+	else if (sa->family == AF_INET6) {
+		sa->salen = sizeof(struct sockaddr_in6);
+		sa->addr_str_len = 46;
+		sa->ipaddr_ptr = &(sa->sa.sin6.sin6_addr);
+		sa->ipaddr_len = sizeof(struct in6_addr);
+	}
+#endif
+}
+#endif
+
+SWITCH_DECLARE(switch_status_t) switch_socket_recvmmsg(switch_socket_t *sock, switch_sockmsg_t *msgs, int *count)
+{
+#if defined(HAVE_RECVMMSG) && defined(MSG_WAITFORONE)
+	struct mmsghdr hdrs[SWITCH_SOCKMSG_MAX];
+	struct iovec iov[SWITCH_SOCKMSG_MAX];
+	apr_os_sock_t fd;
+	int i, r, max = *count;
+
+	*count = 0;
+
+	if (!sock || !msgs || max <= 0 || apr_os_sock_get(&fd, sock) != APR_SUCCESS) {
+		return SWITCH_STATUS_GENERR;
+	}
+
+	if (max > SWITCH_SOCKMSG_MAX) {
+		max = SWITCH_SOCKMSG_MAX;
+	}
+
+	memset(hdrs, 0, sizeof(hdrs[0]) * max);
+
+	for (i = 0; i < max; i++) {
+		iov[i].iov_base = msgs[i].buf;
+		iov[i].iov_len = msgs[i].len;
+		hdrs[i].msg_hdr.msg_iov = &iov[i];
+		hdrs[i].msg_hdr.msg_iovlen = 1;
+
+		if (msgs[i].from) {
+			hdrs[i].msg_hdr.msg_name = &msgs[i].from->sa;
+			hdrs[i].msg_hdr.msg_namelen = sizeof(msgs[i].from->sa);
+		}
+	}
+
+	do {
+		r = recvmmsg(fd, hdrs, max, MSG_WAITFORONE, NULL);
+	} while (r == -1 && errno == EINTR);
+
+	if (r == -1) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return SWITCH_STATUS_BREAK;
+		}
+		return SWITCH_STATUS_GENERR;
+	}
+
+	for (i = 0; i < r; i++) {
+		msgs[i].len = hdrs[i].msg_len;
+		msgs[i].truncated = (hdrs[i].msg_hdr.msg_flags & MSG_TRUNC) ? SWITCH_TRUE : SWITCH_FALSE;
+
+		if (msgs[i].from) {
+			sockmsg_addr_set(msgs[i].from);
+		}
+	}
+
+	*count = r;
+
+	return SWITCH_STATUS_SUCCESS;
+#else
+	switch_status_t status;
+	switch_size_t len;
+
+	if (!msgs || *count <= 0) {
+		*count = 0;
+		return SWITCH_STATUS_GENERR;
+	}
+
+	/* no batching available, behave exactly like a single recvfrom */
+	*count = 0;
+	len = msgs[0].len;
+	msgs[0].truncated = SWITCH_FALSE;
+
+	if (msgs[0].from) {
+		status = switch_socket_recvfrom(msgs[0].from, sock, 0, msgs[0].buf, &len);
+	} else {
+		status = switch_socket_recv(sock, msgs[0].buf, &len);
+	}
+
+	msgs[0].len = len;
+
+	if (status == SWITCH_STATUS_SUCCESS && len) {
+		*count = 1;
+	}
+
+	return status;
+#endif
+}
+
+SWITCH_DECLARE(switch_status_t) switch_socket_sendmmsg(switch_socket_t *sock, switch_sockaddr_t *where, switch_sockmsg_t *msgs, int *count)
+{
+#if defined(HAVE_SENDMMSG)
+	struct mmsghdr hdrs[SWITCH_SOCKMSG_MAX];
+	struct iovec iov[SWITCH_SOCKMSG_MAX];
+	apr_os_sock_t fd;
+	int i, r, sent = 0, total = *count;
+
+	*count = 0;
+
+	if (!sock || !where || !msgs || total <= 0 || apr_os_sock_get(&fd, sock) != APR_SUCCESS) {
+		return SWITCH_STATUS_GENERR;
+	}
+
+	while (sent < total) {
+		int max = total - sent;
+
+		if (max > SWITCH_SOCKMSG_MAX) {
+			max = SWITCH_SOCKMSG_MAX;
+		}
+
+		memset(hdrs, 0, sizeof(hdrs[0]) * max);
+
+		for (i = 0; i < max; i++) {
+			iov[i].iov_base = msgs[sent + i].buf;
+			iov[i].iov_len = msgs[sent + i].len;
+			hdrs[i].msg_hdr.msg_iov = &iov[i];
+			hdrs[i].msg_hdr.msg_iovlen = 1;
+			hdrs[i].msg_hdr.msg_name = &where->sa;
+			hdrs[i].msg_hdr.msg_namelen = where->salen;
+		}
+
+		do {
+			r = sendmmsg(fd, hdrs, max, 0);
+		} while (r == -1 && errno == EINTR);
+
+		if (r <= 0) {
+			*count = sent;
+			return (r == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) ? SWITCH_STATUS_BREAK : SWITCH_STATUS_GENERR;
+		}
+
+		sent += r;
+	}
+
+	*count = sent;
+
+	return SWITCH_STATUS_SUCCESS;
+#else
+	switch_status_t status = SWITCH_STATUS_SUCCESS;
+	int i, total = *count;
+
+	*count = 0;
+
+	for (i = 0; i < total; i++) {
+		switch_size_t len = msgs[i].len;
+
+		if ((status = switch_socket_sendto(sock, where, 0, msgs[i].buf, &len)) != SWITCH_STATUS_SUCCESS) {
+			break;
+		}
+
+		(*count)++;
+	}
+
+	return status;
+#endif
+}
+
 /* poll stubs */
 
 SWITCH_DECLARE(switch_status_t) switch_pollset_create(switch_pollset_t ** pollset, uint32_t size, switch_memory_pool_t *pool, uint32_t flags)
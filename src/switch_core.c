@@ -1984,6 +1984,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_init(switch_core_flag_t flags, switc
 		return SWITCH_STATUS_FALSE;
 	}
 	switch_core_media_init();
+	switch_core_video_init(runtime.memory_pool);
 	switch_scheduler_task_thread_start();
 
 	switch_nat_late_init();
@@ -2095,6 +2096,9 @@ static void switch_load_core_config(const char *file)
 		}
 
 		if ((settings = switch_xml_child(cfg, "settings"))) {
+			uint32_t pool_cache_depth = 0, pool_cache_max_idle = 0, pool_cache_prewarm = 0;
+			switch_bool_t pool_cache = SWITCH_FALSE;
+
 			for (param = switch_xml_child(settings, "param"); param; param = param->next) {
 				const char *var = switch_xml_attr_soft(param, "name");
 				const char *val = switch_xml_attr_soft(param, "value");
@@ -2293,6 +2297,12 @@ static void switch_load_core_config(const char *file)
 					switch_rtp_set_start_port((switch_port_t) atoi(val));
 				} else if (!strcasecmp(var, "rtp-end-port") && !zstr(val)) {
 					switch_rtp_set_end_port((switch_port_t) atoi(val));
+				} else if (!strcasecmp(var, "rtp-reactor-threads") && !zstr(val)) {
+					if (!strcasecmp(val, "auto")) {
+						switch_rtp_set_reactor_threads(switch_core_cpu_count());
+					} else {
+						switch_rtp_set_reactor_threads((uint32_t) atoi(val));
+					}
 				} else if (!strcasecmp(var, "rtp-port-usage-robustness") && switch_true(val)) {
 					runtime.port_alloc_flags |= SPF_ROBUST_UDP;
 				} else if (!strcasecmp(var, "core-db-name") && !zstr(val)) {
@@ -2324,8 +2334,24 @@ static void switch_load_core_config(const char *file)
 										  "rtp-retain-crypto-keys enabled. Could be used to decrypt secure media.\n");
 					}
 					switch_core_set_variable("rtp_retain_crypto_keys", val);
+				} else if (!strcasecmp(var, "pool-cache-depth") && !zstr(val)) {
+					pool_cache_depth = switch_atoui(val);
+					pool_cache = SWITCH_TRUE;
+				} else if (!strcasecmp(var, "pool-cache-max-idle") && !zstr(val)) {
+					pool_cache_max_idle = switch_atoui(val);
+					pool_cache = SWITCH_TRUE;
+				} else if (!strcasecmp(var, "pool-cache-prewarm") && !zstr(val)) {
+					pool_cache_prewarm = switch_atoui(val);
 				}
 			}
+
+			if (pool_cache) {
+				switch_core_memory_pool_cache_set(pool_cache_depth, pool_cache_max_idle);
+			}
+
+			if (pool_cache_prewarm) {
+				switch_core_memory_pool_cache_prewarm(pool_cache_prewarm);
+			}
 		}
 
 		if ((settings = switch_xml_child(cfg, "variables"))) {
@@ -2961,6 +2987,7 @@ SWITCH_DECLARE(switch_status_t) switch_core_destroy(void)
 	}
 
 	switch_core_media_deinit();
+	switch_core_video_deinit();
 
 	if (runtime.memory_pool) {
 		apr_pool_destroy(runtime.memory_pool);
@@ -166,6 +166,7 @@ typedef struct switch_rtp_engine_s {
 	uint8_t pli;
 	uint8_t nack;
 	uint8_t tmmbr;
+	switch_payload_t rtx_pt;
 	uint8_t no_crypto;
 	uint8_t dtls_controller;
 	switch_codec_settings_t codec_settings;
@@ -233,6 +234,7 @@ struct switch_media_handle_s {
 	uint64_t vid_frames;
 	time_t vid_started;
 	int ready_loops;
+	int video_decode_paused;
 
 	switch_thread_t *video_write_thread;
 	int video_write_thread_running;
@@ -1517,6 +1519,12 @@ static void set_stats(switch_core_session_t *session, switch_media_type_t type,
 		add_stat(stats->inbound.cng_packet_count, "in_cng_packet_count");
 		add_stat(stats->inbound.flush_packet_count, "in_flush_packet_count");
 		add_stat(stats->inbound.largest_jb_size, "in_largest_jb_size");
+		add_stat(stats->inbound.syscall_count, "in_syscall_count");
+		add_stat_double(stats->inbound.syscall_count ? (double) stats->inbound.packet_count / stats->inbound.syscall_count : 0.0, "in_packets_per_syscall");
+		add_stat(stats->inbound.nack_count, "in_nack_count");
+		add_stat(stats->inbound.nack_recovered_count, "in_nack_recovered_count");
+		add_stat(stats->inbound.nack_late_count, "in_nack_late_count");
+		add_stat(stats->inbound.rtx_packet_count, "in_rtx_packet_count");
 		add_stat_double(stats->inbound.min_variance, "in_jitter_min_variance");
 		add_stat_double(stats->inbound.max_variance, "in_jitter_max_variance");
 		add_stat_double(stats->inbound.lossrate, "in_jitter_loss_rate");
@@ -1534,6 +1542,17 @@ static void set_stats(switch_core_session_t *session, switch_media_type_t type,
 		add_stat(stats->outbound.skip_packet_count, "out_skip_packet_count");
 		add_stat(stats->outbound.dtmf_packet_count, "out_dtmf_packet_count");
 		add_stat(stats->outbound.cng_packet_count, "out_cng_packet_count");
+		add_stat(stats->outbound.syscall_count, "out_syscall_count");
+		add_stat_double(stats->outbound.syscall_count ? (double) stats->outbound.packet_count / stats->outbound.syscall_count : 0.0, "out_packets_per_syscall");
+		add_stat(stats->outbound.nack_count, "out_nack_count");
+		add_stat(stats->outbound.rtx_packet_count, "out_rtx_packet_count");
+		add_stat(stats->outbound.rtx_miss_count, "out_rtx_miss_count");
+		add_stat(stats->outbound.paced_packet_count, "out_paced_packet_count");
+		add_stat(stats->outbound.pacing_queue_depth, "out_pacing_queue_depth");
+		add_stat(stats->outbound.pacing_queue_max, "out_pacing_queue_max");
+		add_stat_double(stats->outbound.paced_packet_count ?
+						(double) stats->outbound.pacing_delay_total / stats->outbound.paced_packet_count / 1000 : 0.0, "out_pacing_delay_avg_ms");
+		add_stat_double((double) stats->outbound.pacing_delay_max / 1000, "out_pacing_delay_max_ms");
 
 		add_stat(stats->rtcp.packet_count, "rtcp_packet_count");
 		add_stat(stats->rtcp.octet_count, "rtcp_octet_count");
@@ -3765,6 +3784,15 @@ SWITCH_DECLARE(uint8_t) switch_core_media_negotiate_sdp(switch_core_session_t *s
 	a_engine->new_ice = 1;
 	a_engine->reject_avp = 0;
 
+	/* rtx only lives as long as the remote keeps listing it, a video match below turns it back on */
+	if (v_engine->rtx_pt) {
+		v_engine->rtx_pt = 0;
+
+		if (v_engine->rtp_session) {
+			switch_rtp_set_rtx(v_engine->rtp_session, 0, 0);
+		}
+	}
+
 	switch_media_handle_set_media_flag(smh, SCMF_RECV_SDP);
 	
 	switch_core_session_parse_crypto_prefs(session);
@@ -4870,6 +4898,26 @@ SWITCH_DECLARE(uint8_t) switch_core_media_negotiate_sdp(switch_core_session_t *s
 				switch_snprintf(tmp, sizeof(tmp), "%d", v_engine->cur_payload_map->recv_pt);
 				switch_channel_set_variable(session->channel, "rtp_video_recv_pt", tmp);
 
+				v_engine->rtx_pt = 0;
+
+				if (v_engine->nack) {
+					sdp_rtpmap_t *rmap;
+					const char *apt;
+
+					/* RFC 4588 retransmission, only when the remote offered it for the agreed payload */
+					for (rmap = m->m_rtpmaps; rmap; rmap = rmap->rm_next) {
+						if (rmap->rm_encoding && !strcasecmp(rmap->rm_encoding, "rtx") && rmap->rm_fmtp &&
+							(apt = switch_stristr("apt=", rmap->rm_fmtp)) && atoi(apt + 4) == v_engine->cur_payload_map->agreed_pt) {
+							v_engine->rtx_pt = (switch_payload_t) rmap->rm_pt;
+							break;
+						}
+					}
+				}
+
+				if (v_engine->rtp_session) {
+					switch_rtp_set_rtx(v_engine->rtp_session, v_engine->rtx_pt, v_engine->cur_payload_map->agreed_pt);
+				}
+
 				if (switch_core_codec_ready(&v_engine->read_codec) && strcasecmp(matches[0].imp->iananame, v_engine->read_codec.implementation->iananame)) {
 					v_engine->reset_codec = 1;
 				}
@@ -6406,6 +6454,10 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_activate_rtp(switch_core_sessi
 		flags[SWITCH_RTP_FLAG_GEN_TS_DELTA] = 1;
 	}
 
+	if ((val = switch_channel_get_variable(session->channel, "rtp_batch_io")) && switch_true(val)) {
+		flags[SWITCH_RTP_FLAG_BATCH_IO] = 1;
+	}
+
 	if (a_engine->rtp_session && switch_channel_test_flag(session->channel, CF_REINVITE)) {
 		//const char *ip = switch_channel_get_variable(session->channel, SWITCH_LOCAL_MEDIA_IP_VARIABLE);
 		//const char *port = switch_channel_get_variable(session->channel, SWITCH_LOCAL_MEDIA_PORT_VARIABLE);
@@ -6941,6 +6993,10 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_activate_rtp(switch_core_sessi
 				flags[SWITCH_RTP_FLAG_TMMBR]++;
 			}
 
+			if ((val = switch_channel_get_variable(session->channel, "rtp_batch_io")) && switch_true(val)) {
+				flags[SWITCH_RTP_FLAG_BATCH_IO]++;
+			}
+
 			v_engine->rtp_session = switch_rtp_new(a_engine->local_sdp_ip,
 														 v_engine->local_sdp_port,
 														 v_engine->cur_payload_map->remote_sdp_ip,
@@ -6986,6 +7042,14 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_activate_rtp(switch_core_sessi
 					switch_rtp_set_remote_ssrc(v_engine->rtp_session, v_engine->remote_ssrc);
 				}
 
+				if (v_engine->rtx_pt) {
+					switch_rtp_set_rtx(v_engine->rtp_session, v_engine->rtx_pt, v_engine->cur_payload_map->agreed_pt);
+				}
+
+				if ((val = switch_channel_get_variable(session->channel, "rtp_video_pacing")) && switch_true(val)) {
+					switch_rtp_set_video_pacing(v_engine->rtp_session, v_engine->codec_settings.video.bandwidth);
+				}
+
 				if (v_engine->ice_in.cands[v_engine->ice_in.chosen[0]][0].ready) {
 					
 					gen_ice(session, SWITCH_MEDIA_TYPE_VIDEO, NULL, 0);
@@ -8313,6 +8377,10 @@ SWITCH_DECLARE(void) switch_core_media_gen_local_sdp(switch_core_session_t *sess
 					payload_map_t *pmap;
 					switch_core_media_set_video_codec(session, 0);
 					switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), " %d", v_engine->cur_payload_map->agreed_pt);
+
+					if (v_engine->rtx_pt && sdp_type == SDP_TYPE_RESPONSE) {
+						switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), " %d", v_engine->rtx_pt);
+					}
 				
 					if (switch_media_handle_test_media_flag(smh, SCMF_MULTI_ANSWER_VIDEO)) {
 						switch_mutex_lock(smh->sdp_mutex);
@@ -8420,6 +8488,11 @@ SWITCH_DECLARE(void) switch_core_media_gen_local_sdp(switch_core_session_t *sess
 						switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), "a=fmtp:%d %s\r\n", v_engine->cur_payload_map->pt, pass_fmtp);
 					}
 
+					if (v_engine->rtx_pt && sdp_type == SDP_TYPE_RESPONSE) {
+						switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), "a=rtpmap:%d rtx/%ld\r\na=fmtp:%d apt=%d\r\n",
+										v_engine->rtx_pt, v_engine->cur_payload_map->rm_rate, v_engine->rtx_pt, v_engine->cur_payload_map->pt);
+					}
+
 
 					if (switch_media_handle_test_media_flag(smh, SCMF_MULTI_ANSWER_VIDEO)) {
 						switch_mutex_lock(smh->sdp_mutex);
@@ -8622,6 +8695,21 @@ SWITCH_DECLARE(void) switch_core_media_gen_local_sdp(switch_core_session_t *sess
 					switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), "a=ssrc:%u msid:%s v0\r\n", v_engine->ssrc, smh->msid);
 					switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), "a=ssrc:%u mslabel:%s\r\n", v_engine->ssrc, smh->msid);
 					switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), "a=ssrc:%u label:%sv0\r\n", v_engine->ssrc, smh->msid);
+
+					if (v_engine->rtx_pt && sdp_type == SDP_TYPE_RESPONSE) {
+						uint32_t rtx_ssrc = v_engine->rtp_session ? switch_rtp_get_rtx_ssrc(v_engine->rtp_session) : 0;
+
+						/* before rtp is up the session will derive it from the ssrc we just signalled */
+						if (!rtx_ssrc) {
+							rtx_ssrc = SWITCH_RTP_RTX_SSRC(v_engine->ssrc);
+						}
+
+						switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), "a=ssrc-group:FID %u %u\r\n", v_engine->ssrc, rtx_ssrc);
+						switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), "a=ssrc:%u cname:%s\r\n", rtx_ssrc, smh->cname);
+						switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), "a=ssrc:%u msid:%s v0\r\n", rtx_ssrc, smh->msid);
+						switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), "a=ssrc:%u mslabel:%s\r\n", rtx_ssrc, smh->msid);
+						switch_snprintf(buf + strlen(buf), SDPBUFLEN - strlen(buf), "a=ssrc:%u label:%sv0\r\n", rtx_ssrc, smh->msid);
+					}
 				
 
 				
@@ -9384,6 +9472,17 @@ SWITCH_DECLARE(switch_status_t) switch_core_media_set_outgoing_bitrate(switch_co
 	return status;
 }
 
+SWITCH_DECLARE(uint32_t) switch_core_media_get_remote_bitrate(switch_core_session_t *session, switch_media_type_t type)
+{
+	switch_media_handle_t *smh;
+
+	if (!(smh = session->media_handle)) {
+		return 0;
+	}
+
+	return switch_rtp_get_remote_bitrate(smh->engines[type].rtp_session);
+}
+
 //?
 SWITCH_DECLARE(switch_status_t) switch_core_media_reset_jb(switch_core_session_t *session, switch_media_type_t type)
 {
@@ -11566,7 +11665,27 @@ SWITCH_DECLARE(switch_status_t) switch_core_session_read_video_frame(switch_core
 		goto done;
 	}
 
-	if (switch_channel_test_flag(session->channel, CF_VIDEO_DECODED_READ) && (*frame)->img == NULL) {
+	if (switch_channel_test_flag(session->channel, CF_VIDEO_DECODED_READ)) {
+		/* skip decoding while nobody looks at the picture, media bugs and read recordings still need it */
+		int pause = switch_channel_test_flag(session->channel, CF_VIDEO_DECODE_PAUSE) && !session->bugs && !smh->video_read_fh;
+
+		if (pause && !smh->video_decode_paused) {
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Video decoding paused\n");
+			smh->video_decode_paused = 1;
+		} else if (!pause && smh->video_decode_paused) {
+			int mask = 2;
+
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(session), SWITCH_LOG_DEBUG, "Video decoding resumed\n");
+			smh->video_decode_paused = 0;
+
+			/* the decoder missed its references, start over on the next key frame */
+			if ((*frame)->codec) {
+				switch_core_codec_control((*frame)->codec, SCC_VIDEO_RESET, SCCT_INT, (void *)&mask, SCCT_NONE, NULL, NULL, NULL);
+			}
+		}
+	}
+
+	if (switch_channel_test_flag(session->channel, CF_VIDEO_DECODED_READ) && !smh->video_decode_paused && (*frame)->img == NULL) {
 		switch_status_t decode_status;
 
 		(*frame)->img = NULL;
@@ -999,7 +999,8 @@ SWITCH_DECLARE(uint32_t) switch_core_media_bug_count(switch_core_session_t *orig
 	if (orig_session->bugs) {
 		switch_thread_rwlock_rdlock(orig_session->bug_rwlock);
 		for (bp = orig_session->bugs; bp; bp = bp->next) {
-			if (!switch_test_flag(bp, SMBF_PRUNE) && !switch_test_flag(bp, SMBF_LOCK) && !strcmp(bp->function, function)) {
+			/* a NULL function counts every live bug */
+			if (!switch_test_flag(bp, SMBF_PRUNE) && (!function || (!switch_test_flag(bp, SMBF_LOCK) && !strcmp(bp->function, function)))) {
 				x++;
 			}
 		}
@@ -50,6 +50,35 @@
 #define DEBUG_ALLOC_CUTOFF 500
 #endif
 
+#if defined(PER_POOL_LOCK) && !defined(INSTANTLY_DESTROY_POOLS)
+#define POOL_CACHE 1
+#endif
+
+#if defined(__GNUC__) && !defined(DEBUG_ALLOC)
+#define SESSION_CHUNK_ALLOC 1
+#endif
+
+#ifdef POOL_CACHE
+/* Destroyed pools are cleared and parked by the size the allocator kept after the clear.
+   New pools are taken from the class their call site needed last time, then from larger ones. */
+#define POOL_CACHE_CLASSES 3
+#define POOL_CACHE_HINTS 256
+#define POOL_CACHE_MAX_DEPTH 4096
+
+static const apr_size_t pool_cache_class_size[POOL_CACHE_CLASSES] = { 64 * 1024, 256 * 1024, 1024 * 1024 };
+
+typedef struct {
+	switch_memory_pool_t *pool;
+	apr_size_t bytes;
+	switch_time_t idle_since;
+} pool_cache_entry_t;
+
+typedef struct {
+	pool_cache_entry_t *entries;	/* oldest first */
+	uint32_t count;
+} pool_cache_class_t;
+#endif
+
 static struct {
 #ifdef USE_MEM_LOCK
 	switch_mutex_t *mem_lock;
@@ -58,6 +87,25 @@ static struct {
 	switch_queue_t *pool_recycle_queue;
 	switch_memory_pool_t *memory_pool;
 	int pool_thread_running;
+#ifdef POOL_CACHE
+	switch_mutex_t *cache_mutex;
+	pool_cache_class_t cache[POOL_CACHE_CLASSES];
+	uint8_t cache_hint[POOL_CACHE_HINTS];	/* class + 1 for each call site, 0 when unknown */
+	uint32_t cache_depth;
+	uint32_t cache_max_idle;
+	uint32_t cached;
+	uint64_t cached_bytes;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t reused_bytes;
+	uint64_t reclaimed;
+	uint64_t trimmed;
+	uint64_t reclaim_usec_total;
+	uint64_t reclaim_usec_max;
+#endif
+#ifdef SESSION_CHUNK_ALLOC
+	uint64_t session_chunks;
+#endif
 } memory_manager;
 
 SWITCH_DECLARE(switch_memory_pool_t *) switch_core_session_get_pool(switch_core_session_t *session)
@@ -67,6 +115,42 @@ SWITCH_DECLARE(switch_memory_pool_t *) switch_core_session_get_pool(switch_core_
 	return session->pool;
 }
 
+#ifdef SESSION_CHUNK_ALLOC
+/* Carve a small allocation out of the session's current chunk with a single atomic add.
+   The pool (and its mutex) is only touched when the chunk runs out. */
+static void *session_chunk_alloc(switch_core_session_t *session, switch_size_t memory)
+{
+	switch_session_chunk_t *chunk, *old;
+	uint32_t need = (uint32_t) APR_ALIGN_DEFAULT(memory), off;
+	char *ptr;
+
+	if ((old = __atomic_load_n(&session->alloc_chunk, __ATOMIC_ACQUIRE))) {
+		off = __atomic_fetch_add(&old->used, need, __ATOMIC_RELAXED);
+
+		if (off + need <= old->size) {
+			ptr = old->base + off;
+			goto done;
+		}
+	}
+
+	chunk = apr_palloc(session->pool, APR_ALIGN_DEFAULT(sizeof(*chunk)) + SWITCH_SESSION_CHUNK_SIZE);
+	switch_assert(chunk != NULL);
+	chunk->base = (char *) chunk + APR_ALIGN_DEFAULT(sizeof(*chunk));
+	chunk->size = SWITCH_SESSION_CHUNK_SIZE;
+	chunk->used = need;
+	ptr = chunk->base;
+
+	/* if another thread installed a chunk first this one just serves our allocation */
+	__atomic_compare_exchange_n(&session->alloc_chunk, &old, chunk, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&memory_manager.session_chunks, 1, __ATOMIC_RELAXED);
+
+  done:
+	memset(ptr, 0, memory);
+
+	return ptr;
+}
+#endif
+
 /* **ONLY** alloc things with this function that **WILL NOT** outlive
    the session itself or expect an earth shattering KABOOM!*/
 SWITCH_DECLARE(void *) switch_core_perform_session_alloc(switch_core_session_t *session, switch_size_t memory, const char *file, const char *func,
@@ -76,6 +160,12 @@ SWITCH_DECLARE(void *) switch_core_perform_session_alloc(switch_core_session_t *
 	switch_assert(session != NULL);
 	switch_assert(session->pool != NULL);
 
+#ifdef SESSION_CHUNK_ALLOC
+	if (memory <= SWITCH_SESSION_CHUNK_MAX_ALLOC) {
+		return session_chunk_alloc(session, memory);
+	}
+#endif
+
 #ifdef LOCK_MORE
 #ifdef USE_MEM_LOCK
 	switch_mutex_lock(memory_manager.mem_lock);
@@ -349,6 +439,305 @@ SWITCH_DECLARE(void) switch_pool_clear(switch_memory_pool_t *p)
 
 
 
+#ifdef POOL_CACHE
+static uint32_t pool_cache_hint_slot(const char *file, int line)
+{
+	uint32_t hash = 2166136261U;
+
+	for (; file && *file; file++) {
+		hash = (hash ^ (uint8_t) *file) * 16777619U;
+	}
+
+	hash ^= (uint32_t) line * 2654435761U;
+
+	return (hash ^ (hash >> 16)) % POOL_CACHE_HINTS;
+}
+
+/* pool tags are "file:line" unless someone retagged the pool, in which case the hint is just noise */
+static uint32_t pool_cache_tag_slot(const char *tag)
+{
+	char file[256] = "";
+	const char *p;
+	size_t len;
+
+	if (!tag || !(p = strrchr(tag, ':'))) {
+		return pool_cache_hint_slot(tag, 0);
+	}
+
+	len = (size_t) (p - tag);
+	if (len >= sizeof(file)) {
+		len = sizeof(file) - 1;
+	}
+	memcpy(file, tag, len);
+	file[len] = '\0';
+
+	return pool_cache_hint_slot(file, atoi(p + 1));
+}
+
+static int pool_cache_class(apr_size_t bytes)
+{
+	int i;
+
+	for (i = 0; i < POOL_CACHE_CLASSES; i++) {
+		if (bytes <= pool_cache_class_size[i]) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static void pool_cache_mutex_reset(switch_memory_pool_t *pool)
+{
+	apr_thread_mutex_t *my_mutex;
+
+	if ((apr_thread_mutex_create(&my_mutex, APR_THREAD_MUTEX_NESTED, pool)) != APR_SUCCESS) {
+		abort();
+	}
+
+	apr_allocator_mutex_set(apr_pool_allocator_get(pool), my_mutex);
+	apr_pool_mutex_set(pool, my_mutex);
+}
+
+static switch_memory_pool_t *pool_cache_pop(const char *file, int line)
+{
+	switch_memory_pool_t *pool = NULL;
+	pool_cache_class_t *class;
+	uint32_t slot = pool_cache_hint_slot(file, line);
+	int want, i;
+
+	if (!memory_manager.cache_depth) {
+		return NULL;
+	}
+
+	switch_mutex_lock(memory_manager.cache_mutex);
+
+	want = memory_manager.cache_hint[slot] ? memory_manager.cache_hint[slot] - 1 : 0;
+
+	/* the class this call site used last time, then anything bigger, then whatever is left */
+	for (i = 0; i < POOL_CACHE_CLASSES && !pool; i++) {
+		class = &memory_manager.cache[(want + i) % POOL_CACHE_CLASSES];
+
+		if (class->count) {
+			pool_cache_entry_t *entry = &class->entries[--class->count];
+
+			pool = entry->pool;
+			memory_manager.cached--;
+			memory_manager.cached_bytes -= entry->bytes;
+			memory_manager.reused_bytes += entry->bytes;
+		}
+	}
+
+	if (pool) {
+		memory_manager.hits++;
+	} else {
+		memory_manager.misses++;
+	}
+
+	switch_mutex_unlock(memory_manager.cache_mutex);
+
+	return pool;
+}
+
+/* The pool must no longer be referenced by anyone else, only the cache itself is shared. */
+static void pool_cache_reclaim(switch_memory_pool_t *pool)
+{
+	apr_allocator_t *allocator = apr_pool_allocator_get(pool);
+	switch_time_t start = switch_time_now();
+	uint64_t took;
+	apr_size_t bytes;
+	uint32_t slot;
+	int class;
+
+	if (!memory_manager.cache_depth) {
+		apr_pool_destroy(pool);
+		return;
+	}
+
+	slot = pool_cache_tag_slot(apr_pool_tag(pool, NULL));
+
+	/* the pool mutex lives in the pool itself and is destroyed by the clear */
+	apr_pool_mutex_set(pool, NULL);
+	apr_allocator_mutex_set(allocator, NULL);
+	apr_pool_clear(pool);
+
+	bytes = apr_allocator_free_bytes(allocator);
+
+	if ((class = pool_cache_class(bytes)) < 0) {
+		apr_pool_destroy(pool);
+		return;
+	}
+
+	pool_cache_mutex_reset(pool);
+
+	switch_mutex_lock(memory_manager.cache_mutex);
+
+	memory_manager.cache_hint[slot] = (uint8_t) (class + 1);
+
+	if (memory_manager.cache[class].count < memory_manager.cache_depth) {
+		pool_cache_entry_t *entry = &memory_manager.cache[class].entries[memory_manager.cache[class].count++];
+
+		entry->pool = pool;
+		entry->bytes = bytes;
+		entry->idle_since = switch_time_now();
+
+		memory_manager.cached++;
+		memory_manager.cached_bytes += bytes;
+		memory_manager.reclaimed++;
+
+		took = entry->idle_since - start;
+		memory_manager.reclaim_usec_total += took;
+		if (took > memory_manager.reclaim_usec_max) {
+			memory_manager.reclaim_usec_max = took;
+		}
+
+		pool = NULL;
+	}
+
+	switch_mutex_unlock(memory_manager.cache_mutex);
+
+	if (pool) {
+		apr_pool_destroy(pool);
+	}
+}
+
+/* Drop pools idle for longer than max_idle seconds (or all of them when max_idle is 0) */
+static void pool_cache_trim(uint32_t max_idle, switch_bool_t all)
+{
+	switch_time_t now = switch_time_now();
+	switch_memory_pool_t *pool;
+	pool_cache_class_t *class;
+	int i;
+
+	if (!memory_manager.cache_mutex || (!all && !max_idle)) {
+		return;
+	}
+
+	for (i = 0; i < POOL_CACHE_CLASSES; i++) {
+		class = &memory_manager.cache[i];
+
+		for (;;) {
+			pool = NULL;
+
+			switch_mutex_lock(memory_manager.cache_mutex);
+			if (class->count && (all || now - class->entries[0].idle_since > (switch_time_t) max_idle * 1000000)) {
+				pool = class->entries[0].pool;
+				memory_manager.cached--;
+				memory_manager.cached_bytes -= class->entries[0].bytes;
+				memory_manager.trimmed++;
+				memmove(&class->entries[0], &class->entries[1], --class->count * sizeof(class->entries[0]));
+			}
+			switch_mutex_unlock(memory_manager.cache_mutex);
+
+			if (!pool) {
+				break;
+			}
+
+			apr_pool_destroy(pool);
+		}
+	}
+}
+#endif
+
+SWITCH_DECLARE(void) switch_core_memory_pool_cache_set(uint32_t depth, uint32_t max_idle)
+{
+#ifdef POOL_CACHE
+	pool_cache_entry_t *entries;
+	int i;
+
+	if (depth > POOL_CACHE_MAX_DEPTH) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "pool-cache-depth %u is too large, using %d\n", depth, POOL_CACHE_MAX_DEPTH);
+		depth = POOL_CACHE_MAX_DEPTH;
+	}
+
+	if (depth < memory_manager.cache_depth) {
+		memory_manager.cache_depth = depth;
+		pool_cache_trim(0, SWITCH_TRUE);
+	}
+
+	switch_mutex_lock(memory_manager.cache_mutex);
+
+	for (i = 0; depth && i < POOL_CACHE_CLASSES; i++) {
+		if (!(entries = realloc(memory_manager.cache[i].entries, depth * sizeof(*entries)))) {
+			abort();
+		}
+		memory_manager.cache[i].entries = entries;
+	}
+
+	memory_manager.cache_depth = depth;
+	memory_manager.cache_max_idle = max_idle;
+
+	switch_mutex_unlock(memory_manager.cache_mutex);
+
+	if (depth) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "Pool cache depth %u per class, max idle %us\n", depth, max_idle);
+	}
+#else
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "Pool cache is not available in this build\n");
+#endif
+}
+
+SWITCH_DECLARE(void) switch_core_memory_pool_cache_prewarm(uint32_t count)
+{
+#ifdef POOL_CACHE
+	switch_memory_pool_t *pool;
+	uint32_t i;
+
+	if (count > memory_manager.cache_depth) {
+		count = memory_manager.cache_depth;
+	}
+
+	for (i = memory_manager.cache[0].count; i < count; i++) {
+		apr_allocator_t *my_allocator = NULL;
+
+		if ((apr_allocator_create(&my_allocator)) != APR_SUCCESS) {
+			abort();
+		}
+
+		if ((apr_pool_create_ex(&pool, NULL, NULL, my_allocator)) != APR_SUCCESS) {
+			abort();
+		}
+
+		apr_allocator_owner_set(my_allocator, pool);
+
+		/* leave the allocator holding a small class worth of blocks */
+		apr_palloc(pool, pool_cache_class_size[0] / 2);
+		pool_cache_reclaim(pool);
+	}
+#endif
+}
+
+SWITCH_DECLARE(void) switch_core_memory_pool_stats(switch_memory_pool_stats_t *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+#ifdef POOL_CACHE
+	if (memory_manager.cache_mutex) {
+		int i;
+
+		switch_mutex_lock(memory_manager.cache_mutex);
+		stats->depth = memory_manager.cache_depth;
+		stats->max_idle = memory_manager.cache_max_idle;
+		stats->cached = memory_manager.cached;
+		for (i = 0; i < POOL_CACHE_CLASSES; i++) {
+			stats->cached_class[i] = memory_manager.cache[i].count;
+		}
+		stats->cached_bytes = memory_manager.cached_bytes;
+		stats->hits = memory_manager.hits;
+		stats->misses = memory_manager.misses;
+		stats->reused_bytes = memory_manager.reused_bytes;
+		stats->reclaimed = memory_manager.reclaimed;
+		stats->trimmed = memory_manager.trimmed;
+		stats->reclaim_usec_avg = memory_manager.reclaimed ? memory_manager.reclaim_usec_total / memory_manager.reclaimed : 0;
+		stats->reclaim_usec_max = memory_manager.reclaim_usec_max;
+		switch_mutex_unlock(memory_manager.cache_mutex);
+	}
+#endif
+#ifdef SESSION_CHUNK_ALLOC
+	stats->session_chunks = __atomic_load_n(&memory_manager.session_chunks, __ATOMIC_RELAXED);
+#endif
+}
+
 SWITCH_DECLARE(switch_status_t) switch_core_perform_new_memory_pool(switch_memory_pool_t **pool, const char *file, const char *func, int line)
 {
 	char *tmp;
@@ -369,6 +758,12 @@ SWITCH_DECLARE(switch_status_t) switch_core_perform_new_memory_pool(switch_memor
 #endif
 	switch_assert(pool != NULL);
 
+#ifdef POOL_CACHE
+	if ((*pool = pool_cache_pop(file, line))) {
+		goto tag;
+	}
+#endif
+
 #ifndef PER_POOL_LOCK
 	if (switch_queue_trypop(memory_manager.pool_recycle_queue, &pop) == SWITCH_STATUS_SUCCESS && pop) {
 		*pool = (switch_memory_pool_t *) pop;
@@ -398,6 +793,10 @@ SWITCH_DECLARE(switch_status_t) switch_core_perform_new_memory_pool(switch_memor
 		switch_assert(*pool != NULL);
 	}
 #endif
+
+#ifdef POOL_CACHE
+  tag:
+#endif
 #endif
 
 	tmp = switch_core_sprintf(*pool, "%s:%d", file, line);
@@ -501,6 +900,12 @@ SWITCH_DECLARE(void) switch_core_memory_reclaim(void)
 		switch_mutex_unlock(memory_manager.mem_lock);
 #endif
 	}
+#endif
+#ifdef POOL_CACHE
+	if (memory_manager.cached) {
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Returning %u cached memory pool(s)\n", memory_manager.cached);
+		pool_cache_trim(0, SWITCH_TRUE);
+	}
 #endif
 	return;
 }
@@ -533,7 +938,11 @@ static void *SWITCH_THREAD_FUNC pool_thread(switch_thread_t *thread, void *obj)
 #ifdef DEBUG_ALLOC
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "%p DESTROY POOL\n", (void *) pop);	
 #endif
+#ifdef POOL_CACHE
+				pool_cache_reclaim(pop);
+#else
 				apr_pool_destroy(pop);
+#endif
 #ifdef USE_MEM_LOCK
 				switch_mutex_unlock(memory_manager.mem_lock);
 #endif
@@ -568,6 +977,10 @@ static void *SWITCH_THREAD_FUNC pool_thread(switch_thread_t *thread, void *obj)
 		} else {
 			switch_yield(1000000);
 		}
+
+#ifdef POOL_CACHE
+		pool_cache_trim(memory_manager.cache_max_idle, SWITCH_FALSE);
+#endif
 	}
 
   done:
@@ -613,6 +1026,19 @@ void switch_core_memory_stop(void)
 		apr_pool_destroy(pop);
 	}
 #endif
+
+#ifdef POOL_CACHE
+	{
+		int i;
+
+		memory_manager.cache_depth = 0;
+		pool_cache_trim(0, SWITCH_TRUE);
+
+		for (i = 0; i < POOL_CACHE_CLASSES; i++) {
+			switch_safe_free(memory_manager.cache[i].entries);
+		}
+	}
+#endif
 }
 
 switch_memory_pool_t *switch_core_memory_init(void)
@@ -662,6 +1088,10 @@ switch_memory_pool_t *switch_core_memory_init(void)
 	}
 #else
 
+#ifdef POOL_CACHE
+	switch_mutex_init(&memory_manager.cache_mutex, SWITCH_MUTEX_NESTED, memory_manager.memory_pool);
+#endif
+
 	switch_queue_create(&memory_manager.pool_queue, 50000, memory_manager.memory_pool);
 	switch_queue_create(&memory_manager.pool_recycle_queue, 50000, memory_manager.memory_pool);
 
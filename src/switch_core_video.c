@@ -631,6 +631,93 @@ static inline void switch_img_get_rgb_pixel(switch_image_t *img, switch_rgb_colo
 #endif	
 }
 
+/* Plane blending kernels used by overlay and text rendering.  They are written with the compiler's
+   generic vector extensions so they map onto whatever SIMD unit the target has (SSE, NEON ...). */
+#if defined(__GNUC__) || defined(__clang__)
+#define SWITCH_IMG_VECTOR 1
+typedef uint16_t img_u16x8_t __attribute__((vector_size(16)));
+
+static inline img_u16x8_t img_splat8(uint16_t v)
+{
+	img_u16x8_t r = { v, v, v, v, v, v, v, v };
+	return r;
+}
+
+static inline img_u16x8_t img_load8(const uint8_t *p)
+{
+	img_u16x8_t r = { p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7] };
+	return r;
+}
+
+static inline void img_store8(uint8_t *p, img_u16x8_t v)
+{
+	int k;
+
+	for (k = 0; k < 8; k++) {
+		p[k] = (uint8_t) v[k];
+	}
+}
+#endif
+
+/* dst = dst * (255 - alpha) + src * alpha, per byte */
+static inline void img_blend_row(uint8_t *dst, const uint8_t *src, int len, uint8_t alpha)
+{
+	int i = 0;
+
+#ifdef SWITCH_IMG_VECTOR
+	img_u16x8_t va = img_splat8(alpha), vb = img_splat8(255 - alpha);
+
+	for (; i + 8 <= len; i += 8) {
+		img_store8(dst + i, ((img_load8(dst + i) * vb) >> 8) + ((img_load8(src + i) * va) >> 8));
+	}
+#endif
+
+	for (; i < len; i++) {
+		dst[i] = (uint8_t)(((dst[i] * (255 - alpha)) >> 8) + ((src[i] * alpha) >> 8));
+	}
+}
+
+/* dst = dst * (255 - mask) + value * mask, per byte */
+static inline void img_blend_mask_row(uint8_t *dst, const uint8_t *mask, int len, uint8_t value)
+{
+	int i = 0;
+
+#ifdef SWITCH_IMG_VECTOR
+	img_u16x8_t vv = img_splat8(value), v255 = img_splat8(255);
+
+	for (; i + 8 <= len; i += 8) {
+		img_u16x8_t m = img_load8(mask + i);
+
+		img_store8(dst + i, ((img_load8(dst + i) * (v255 - m)) >> 8) + ((vv * m) >> 8));
+	}
+#endif
+
+	for (; i < len; i++) {
+		dst[i] = (uint8_t)(((dst[i] * (255 - mask[i])) >> 8) + ((value * mask[i]) >> 8));
+	}
+}
+
+static void img_overlay_i420(switch_image_t *IMG, switch_image_t *img, int x, int y, int xoff, int yoff, int len, int max_h, uint8_t alpha)
+{
+	int i, clen;
+
+	for (i = y; i < max_h; i++) {
+		img_blend_row(IMG->planes[SWITCH_PLANE_Y] + IMG->stride[SWITCH_PLANE_Y] * i + x,
+					  img->planes[SWITCH_PLANE_Y] + img->stride[SWITCH_PLANE_Y] * (i - y + yoff) + xoff, len, alpha);
+	}
+
+	clen = MIN((len + 1) / 2, (int)((img->d_w + 1) / 2) - xoff / 2);
+
+	for (i = y; i < max_h; i += 2) {
+		int di = i / 2, si = (i - y + yoff) / 2;
+
+		img_blend_row(IMG->planes[SWITCH_PLANE_U] + IMG->stride[SWITCH_PLANE_U] * di + x / 2,
+					  img->planes[SWITCH_PLANE_U] + img->stride[SWITCH_PLANE_U] * si + xoff / 2, clen, alpha);
+		img_blend_row(IMG->planes[SWITCH_PLANE_V] + IMG->stride[SWITCH_PLANE_V] * di + x / 2,
+					  img->planes[SWITCH_PLANE_V] + img->stride[SWITCH_PLANE_V] * si + xoff / 2, clen, alpha);
+	}
+}
+
 SWITCH_DECLARE(void) switch_img_overlay(switch_image_t *IMG, switch_image_t *img, int x, int y, uint8_t percent)
 {
 	int i, j, len, max_h;
@@ -658,6 +745,11 @@ SWITCH_DECLARE(void) switch_img_overlay(switch_image_t *IMG, switch_image_t *img
 	if (y & 1) y++;
 	if (len <= 0) return;
 
+	if (img->fmt == SWITCH_IMG_FMT_I420) {
+		img_overlay_i420(IMG, img, x, y, xoff, yoff, len, max_h, alpha);
+		return;
+	}
+
 	for (i = y; i < max_h; i++) {
 		for (j = 0; j < len; j++) {
 			switch_img_get_rgb_pixel(IMG, &RGB, x + j, i);
@@ -806,11 +898,30 @@ SWITCH_DECLARE(void) switch_color_set_yuv(switch_yuv_color_t *color, const char
 #endif
 
 #define MAX_GRADIENT 8
+#define MAX_CACHED_GLYPHS 1024
+
+/* A rendered glyph, positioned relative to the whole pixel part of the pen */
+typedef struct glyph_cache_s {
+	int left;
+	int top;
+	long advance_x;
+	long advance_y;
+	unsigned int width;
+	unsigned int rows;
+	int pitch;
+	unsigned char pixel_mode;
+	unsigned char buffer[];
+} glyph_cache_t;
 
 struct switch_img_txt_handle_s {
 #if SWITCH_HAVE_FREETYPE
 	FT_Library library;
 	FT_Face face;
+	char *face_family;
+	uint16_t face_size;
+	double glyph_angle;
+	switch_hash_t *glyph_hash;
+	uint32_t glyph_count;
 #endif
 	char *font_family;
 	double angle;
@@ -910,6 +1021,17 @@ SWITCH_DECLARE(void) switch_img_txt_handle_destroy(switch_img_txt_handle_t **han
 	
 
 #if SWITCH_HAVE_FREETYPE
+	if (old_handle->glyph_hash) {
+		switch_core_hash_destroy(&old_handle->glyph_hash);
+	}
+
+	if (old_handle->face) {
+		FT_Done_Face(old_handle->face);
+		old_handle->face = NULL;
+	}
+
+	switch_safe_free(old_handle->face_family);
+
 	if (old_handle->library) {
 		FT_Done_FreeType(old_handle->library);
 		old_handle->library = NULL;
@@ -926,6 +1048,117 @@ SWITCH_DECLARE(void) switch_img_txt_handle_destroy(switch_img_txt_handle_t **han
 }
 
 #if SWITCH_HAVE_FREETYPE
+static void glyph_cache_clear(switch_img_txt_handle_t *handle)
+{
+	if (handle->glyph_hash) {
+		switch_core_hash_destroy(&handle->glyph_hash);
+	}
+
+	handle->glyph_count = 0;
+}
+
+static void glyph_cache_free(void *ptr)
+{
+	free(ptr);
+}
+
+static glyph_cache_t *glyph_cache_add(switch_img_txt_handle_t *handle, const char *key, FT_GlyphSlot slot, FT_Vector *pen)
+{
+	glyph_cache_t *glyph;
+	size_t pitch = slot->bitmap.pitch < 0 ? -slot->bitmap.pitch : slot->bitmap.pitch;
+	size_t len = pitch * slot->bitmap.rows;
+
+	if (handle->glyph_count >= MAX_CACHED_GLYPHS) {
+		glyph_cache_clear(handle);
+	}
+
+	if (!handle->glyph_hash) {
+		switch_core_hash_init(&handle->glyph_hash);
+	}
+
+	switch_zmalloc(glyph, sizeof(*glyph) + len);
+	glyph->left = slot->bitmap_left - (int)(pen->x >> 6);
+	glyph->top = slot->bitmap_top - (int)(pen->y >> 6);
+	glyph->advance_x = slot->advance.x;
+	glyph->advance_y = slot->advance.y;
+	glyph->width = slot->bitmap.width;
+	glyph->rows = slot->bitmap.rows;
+	glyph->pitch = slot->bitmap.pitch;
+	glyph->pixel_mode = slot->bitmap.pixel_mode;
+
+	if (len) {
+		memcpy(glyph->buffer, slot->bitmap.pitch < 0 ? slot->bitmap.buffer - (slot->bitmap.rows - 1) * pitch : slot->bitmap.buffer, len);
+	}
+
+	switch_core_hash_insert_destructor(handle->glyph_hash, key, glyph, glyph_cache_free);
+	handle->glyph_count++;
+
+	return glyph;
+}
+
+#ifdef SWITCH_HAVE_YUV
+/* Anti-aliased glyph straight onto the I420 planes */
+static void draw_gray_bitmap_i420(switch_img_txt_handle_t *handle, switch_image_t *img, FT_Bitmap* bitmap, FT_Int x, FT_Int y)
+{
+	int x0 = MAX(x, 0), y0 = MAX(y, 0);
+	int x1 = MIN(x + (int)bitmap->width, (int)img->d_w), y1 = MIN(y + (int)bitmap->rows, (int)img->d_h);
+	int i, j;
+	uint8_t *src, *dst_y, *dst_u, *dst_v;
+
+	if (x0 >= x1 || y0 >= y1) return;
+
+	if (handle->use_bgcolor) {
+		switch_yuv_color_t table[MAX_GRADIENT];
+
+		for (i = 0; i < MAX_GRADIENT; i++) {
+			switch_color_rgb2yuv(&handle->gradient_table[i], &table[i]);
+		}
+
+		for (j = y0; j < y1; j++) {
+			src = bitmap->buffer + (j - y) * bitmap->width - x;
+			dst_y = img->planes[SWITCH_PLANE_Y] + img->stride[SWITCH_PLANE_Y] * j;
+
+			for (i = x0; i < x1; i++) {
+				dst_y[i] = table[src[i] * MAX_GRADIENT / 256].y;
+			}
+
+			if (j & 1) continue;
+
+			dst_u = img->planes[SWITCH_PLANE_U] + img->stride[SWITCH_PLANE_U] * (j / 2);
+			dst_v = img->planes[SWITCH_PLANE_V] + img->stride[SWITCH_PLANE_V] * (j / 2);
+
+			for (i = x0 + (x0 & 1); i < x1; i += 2) {
+				dst_u[i / 2] = table[src[i] * MAX_GRADIENT / 256].u;
+				dst_v[i / 2] = table[src[i] * MAX_GRADIENT / 256].v;
+			}
+		}
+	} else {
+		switch_yuv_color_t yuv;
+
+		switch_color_rgb2yuv(&handle->color, &yuv);
+
+		for (j = y0; j < y1; j++) {
+			src = bitmap->buffer + (j - y) * bitmap->width - x;
+			img_blend_mask_row(img->planes[SWITCH_PLANE_Y] + img->stride[SWITCH_PLANE_Y] * j + x0, src + x0, x1 - x0, yuv.y);
+
+			if (j & 1) continue;
+
+			dst_u = img->planes[SWITCH_PLANE_U] + img->stride[SWITCH_PLANE_U] * (j / 2);
+			dst_v = img->planes[SWITCH_PLANE_V] + img->stride[SWITCH_PLANE_V] * (j / 2);
+
+			for (i = x0 + (x0 & 1); i < x1; i += 2) {
+				uint8_t g = src[i];
+
+				if (!g) continue;
+
+				dst_u[i / 2] = (uint8_t)(((dst_u[i / 2] * (255 - g)) >> 8) + ((yuv.u * g) >> 8));
+				dst_v[i / 2] = (uint8_t)(((dst_v[i / 2] * (255 - g)) >> 8) + ((yuv.v * g) >> 8));
+			}
+		}
+	}
+}
+#endif
+
 static void draw_bitmap(switch_img_txt_handle_t *handle, switch_image_t *img, FT_Bitmap* bitmap, FT_Int x, FT_Int y)
 {
 	FT_Int  i, j, p, q;
@@ -963,6 +1196,13 @@ static void draw_bitmap(switch_img_txt_handle_t *handle, switch_image_t *img, FT
 			return;
 	}
 
+#ifdef SWITCH_HAVE_YUV
+	if (img->fmt == SWITCH_IMG_FMT_I420) {
+		draw_gray_bitmap_i420(handle, img, bitmap, x, y);
+		return;
+	}
+#endif
+
 	for ( i = x, p = 0; i < x_max; i++, p++ ) {
 		for ( j = y, q = 0; j < y_max; j++, q++ ) {
 			int gradient = bitmap->buffer[q * bitmap->width + p];
@@ -1009,7 +1249,10 @@ SWITCH_DECLARE(uint32_t) switch_img_txt_handle_render(switch_img_txt_handle_t *h
 	int           index = 0;
 	FT_ULong      ch;
 	FT_Face face;
-	uint32_t width = 0;
+	FT_Bitmap     bitmap;
+	glyph_cache_t *glyph;
+	char key[64];
+	uint32_t width = 0, bitmap_width = 0;
 	int this_x = 0, last_x = 0, space = 0;
 	uint32_t ret;
 
@@ -1048,15 +1291,47 @@ SWITCH_DECLARE(uint32_t) switch_img_txt_handle_render(switch_img_txt_handle_t *h
 
 	//target_height = img->d_h;
 
-	error = FT_New_Face(handle->library, font_family, 0, &face); /* create face object */
-	if (error) {
-		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Unable to open font %s\n", font_family);
-		return 0;
+	/* keep the face open between renders, glyphs rendered with it stay valid until font, size or angle change */
+	if (!handle->face || !handle->face_family || strcmp(handle->face_family, font_family)) {
+		glyph_cache_clear(handle);
+
+		if (handle->face) {
+			FT_Done_Face(handle->face);
+			handle->face = NULL;
+		}
+
+		switch_safe_free(handle->face_family);
+		handle->face_size = 0;
+
+		error = FT_New_Face(handle->library, font_family, 0, &handle->face); /* create face object */
+		if (error) {
+			handle->face = NULL;
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Unable to open font %s\n", font_family);
+			return 0;
+		}
+
+		handle->face_family = strdup(font_family);
+	}
+
+	face = handle->face;
+
+	if (handle->face_size != font_size) {
+		glyph_cache_clear(handle);
+
+		/* use 50pt at 100dpi */
+		error = FT_Set_Char_Size(face, 64 * font_size, 0, 96, 96); /* set character size */
+		if (error) {
+			handle->face_size = 0;
+			return 0;
+		}
+
+		handle->face_size = font_size;
 	}
 
-	/* use 50pt at 100dpi */
-	error = FT_Set_Char_Size(face, 64 * font_size, 0, 96, 96); /* set character size */
-	if (error) return 0;
+	if (handle->glyph_angle != angle) {
+		glyph_cache_clear(handle);
+		handle->glyph_angle = angle;
+	}
 
 	slot = face->glyph;
 
@@ -1082,19 +1357,34 @@ SWITCH_DECLARE(uint32_t) switch_img_txt_handle_render(switch_img_txt_handle_t *h
 			continue;
 		}
 
-		/* set transformation */
-		FT_Set_Transform(face, &matrix, &pen);
+		/* the rendered bitmap only depends on the sub pixel part of the pen */
+		switch_snprintf(key, sizeof(key), "%lu:%ld:%ld", (unsigned long)ch, (long)(pen.x & 63), (long)(pen.y & 63));
 
-		/* load glyph image into the slot (erase previous one) */
-		error = FT_Load_Char(face, ch, FT_LOAD_RENDER);
+		if (!handle->glyph_hash || !(glyph = switch_core_hash_find(handle->glyph_hash, key))) {
+			/* set transformation */
+			FT_Set_Transform(face, &matrix, &pen);
 
-		if (error) continue;
+			/* load glyph image into the slot (erase previous one) */
+			error = FT_Load_Char(face, ch, FT_LOAD_RENDER);
+
+			if (error) continue;
+
+			glyph = glyph_cache_add(handle, key, slot, &pen);
+		}
 
-		this_x = pen.x + slot->bitmap_left;
+		this_x = pen.x + glyph->left + (int)(pen.x >> 6);
+		bitmap_width = glyph->width;
 		
 		if (img) {
+			memset(&bitmap, 0, sizeof(bitmap));
+			bitmap.width = glyph->width;
+			bitmap.rows = glyph->rows;
+			bitmap.pitch = glyph->pitch < 0 ? -glyph->pitch : glyph->pitch;
+			bitmap.pixel_mode = glyph->pixel_mode;
+			bitmap.buffer = glyph->buffer;
+
 			/* now, draw to our target surface (convert position) */
-			draw_bitmap(handle, img, &slot->bitmap, this_x, pen.y - slot->bitmap_top + font_size);
+			draw_bitmap(handle, img, &bitmap, this_x, pen.y - (glyph->top + (int)(pen.y >> 6)) + font_size);
 		}
 
 		if (last_x) {
@@ -1108,13 +1398,11 @@ SWITCH_DECLARE(uint32_t) switch_img_txt_handle_render(switch_img_txt_handle_t *h
 		width += space;
 
 		/* increment pen position */
-		pen.x += slot->advance.x >> 6;
-		pen.y += slot->advance.y >> 6;
+		pen.x += glyph->advance_x >> 6;
+		pen.y += glyph->advance_y >> 6;
 	}
 
-	ret = width + slot->bitmap.width * 5;
-
-	FT_Done_Face(face);
+	ret = width + bitmap_width * 5;
 
 	return ret;
 #else
@@ -2157,6 +2445,171 @@ SWITCH_DECLARE(switch_status_t) switch_img_scale(switch_image_t *src, switch_ima
 #endif
 }
 
+#define SCALE_CACHE_SIZE 32
+
+typedef struct scale_cache_entry_s {
+	switch_image_t *src;
+	uint64_t generation;
+	int width;
+	int height;
+	switch_image_t *img;
+	int refs;
+	uint64_t used;
+} scale_cache_entry_t;
+
+static struct {
+	switch_mutex_t *mutex;
+	scale_cache_entry_t entries[SCALE_CACHE_SIZE];
+	uint64_t clock;
+	uint64_t generation;
+	uint64_t hits;
+	uint64_t misses;
+} SCALE_CACHE;
+
+SWITCH_DECLARE(void) switch_core_video_init(switch_memory_pool_t *pool)
+{
+	memset(&SCALE_CACHE, 0, sizeof(SCALE_CACHE));
+	switch_mutex_init(&SCALE_CACHE.mutex, SWITCH_MUTEX_NESTED, pool);
+}
+
+SWITCH_DECLARE(void) switch_core_video_deinit(void)
+{
+	int i;
+
+	if (!SCALE_CACHE.mutex) {
+		return;
+	}
+
+	switch_mutex_lock(SCALE_CACHE.mutex);
+	for (i = 0; i < SCALE_CACHE_SIZE; i++) {
+		switch_img_free(&SCALE_CACHE.entries[i].img);
+	}
+	switch_mutex_unlock(SCALE_CACHE.mutex);
+
+	SCALE_CACHE.mutex = NULL;
+}
+
+SWITCH_DECLARE(switch_image_t *) switch_img_scale_cached(switch_image_t *src, uint64_t generation, int width, int height)
+{
+	scale_cache_entry_t *entry = NULL, *slot = NULL;
+	switch_image_t *img = NULL;
+	int i;
+
+	if (!src || width <= 0 || height <= 0) {
+		return NULL;
+	}
+
+	if (!SCALE_CACHE.mutex) {
+		switch_img_scale(src, &img, width, height);
+		return img;
+	}
+
+	switch_mutex_lock(SCALE_CACHE.mutex);
+
+	for (i = 0; i < SCALE_CACHE_SIZE; i++) {
+		entry = &SCALE_CACHE.entries[i];
+
+		if (entry->img && entry->src == src && entry->generation == generation && entry->width == width && entry->height == height) {
+			entry->refs++;
+			entry->used = ++SCALE_CACHE.clock;
+			SCALE_CACHE.hits++;
+			img = entry->img;
+			switch_mutex_unlock(SCALE_CACHE.mutex);
+			return img;
+		}
+
+		if (!entry->refs && (!slot || entry->used < slot->used)) {
+			slot = entry;
+		}
+	}
+
+	SCALE_CACHE.misses++;
+
+	if (!slot) {
+		/* every entry is still in use, this one is not shared and switch_img_scale_release frees it */
+		switch_mutex_unlock(SCALE_CACHE.mutex);
+		switch_img_scale(src, &img, width, height);
+		return img;
+	}
+
+	/* claim the slot and scale outside the lock, a lookup for the same frame meanwhile just scales on its own */
+	img = slot->img;
+	slot->img = NULL;
+	slot->src = src;
+	slot->generation = generation;
+	slot->width = width;
+	slot->height = height;
+	slot->refs = 1;
+	slot->used = ++SCALE_CACHE.clock;
+
+	switch_mutex_unlock(SCALE_CACHE.mutex);
+
+	if (img && (img->fmt != src->fmt || (int)img->d_w != width || (int)img->d_h != height)) {
+		switch_img_free(&img);
+	}
+
+	if (switch_img_scale(src, &img, width, height) != SWITCH_STATUS_SUCCESS) {
+		switch_img_free(&img);
+	}
+
+	switch_mutex_lock(SCALE_CACHE.mutex);
+	if (img) {
+		slot->img = img;
+	} else {
+		slot->src = NULL;
+		slot->refs = 0;
+	}
+	switch_mutex_unlock(SCALE_CACHE.mutex);
+
+	return img;
+}
+
+SWITCH_DECLARE(uint64_t) switch_img_scale_generation(void)
+{
+	uint64_t generation;
+
+	if (!SCALE_CACHE.mutex) {
+		return ++SCALE_CACHE.generation;
+	}
+
+	switch_mutex_lock(SCALE_CACHE.mutex);
+	generation = ++SCALE_CACHE.generation;
+	switch_mutex_unlock(SCALE_CACHE.mutex);
+
+	return generation;
+}
+
+SWITCH_DECLARE(void) switch_img_scale_release(switch_image_t **imgP)
+{
+	int i;
+
+	if (!imgP || !*imgP) {
+		return;
+	}
+
+	if (SCALE_CACHE.mutex) {
+		switch_mutex_lock(SCALE_CACHE.mutex);
+		for (i = 0; i < SCALE_CACHE_SIZE; i++) {
+			if (SCALE_CACHE.entries[i].img == *imgP) {
+				if (SCALE_CACHE.entries[i].refs > 0) {
+					SCALE_CACHE.entries[i].refs--;
+				}
+				*imgP = NULL;
+				break;
+			}
+		}
+		switch_mutex_unlock(SCALE_CACHE.mutex);
+	}
+
+	switch_img_free(imgP);
+}
+
+SWITCH_DECLARE(void) switch_img_scale_cache_stats(uint64_t *hits, uint64_t *misses)
+{
+	if (hits) *hits = SCALE_CACHE.hits;
+	if (misses) *misses = SCALE_CACHE.misses;
+}
+
 SWITCH_DECLARE(void) switch_img_find_position(switch_img_position_t pos, int sw, int sh, int iw, int ih, int *xP, int *yP)
 {
 	switch(pos) {
@@ -38,7 +38,6 @@
 #include "tpl.h"
 #include "private/switch_core_pvt.h"
 
-//#define SWITCH_EVENT_RECYCLE
 #define DISPATCH_QUEUE_LEN 10000
 //#define DEBUG_DISPATCH_QUEUES
 
@@ -55,6 +54,8 @@ struct switch_event_node {
 	/*! private data */
 	void *user_data;
 	struct switch_event_node *next;
+	/*! next node in the same delivery index chain */
+	struct switch_event_node *index_next;
 };
 
 /*! \brief A registered custom event subclass  */
@@ -83,6 +84,9 @@ static unsigned int SOFT_MAX_DISPATCH = 0;
 static char guess_ip_v4[80] = "";
 static char guess_ip_v6[80] = "";
 static switch_event_node_t *EVENT_NODES[SWITCH_EVENT_ALL + 1] = { NULL };
+/* delivery index: bindings that must be matched one by one, and bindings keyed by plain subclass name */
+static switch_event_node_t *EVENT_GENERIC_NODES[SWITCH_EVENT_ALL + 1] = { NULL };
+static switch_hash_t *EVENT_SUBCLASS_NODES[SWITCH_EVENT_ALL + 1] = { NULL };
 static switch_thread_rwlock_t *RWLOCK = NULL;
 static switch_mutex_t *BLOCK = NULL;
 static switch_mutex_t *POOL_LOCK = NULL;
@@ -90,7 +94,6 @@ static switch_memory_pool_t *RUNTIME_POOL = NULL;
 static switch_memory_pool_t *THRUNTIME_POOL = NULL;
 static switch_thread_t *EVENT_DISPATCH_QUEUE_THREADS[MAX_DISPATCH_VAL] = { 0 };
 static uint8_t EVENT_DISPATCH_QUEUE_RUNNING[MAX_DISPATCH_VAL] = { 0 };
-static switch_queue_t *EVENT_DISPATCH_QUEUE = NULL;
 static switch_queue_t *EVENT_CHANNEL_DISPATCH_QUEUE = NULL;
 static switch_mutex_t *EVENT_QUEUE_MUTEX = NULL;
 static switch_hash_t *CUSTOM_HASH = NULL;
@@ -100,13 +103,228 @@ static int EVENT_CHANNEL_DISPATCH_THREAD_COUNT = 0;
 static int EVENT_CHANNEL_DISPATCH_THREAD_STARTING = 0;
 static int SYSTEM_RUNNING = 0;
 static uint64_t EVENT_SEQUENCE_NR = 0;
-#ifdef SWITCH_EVENT_RECYCLE
-static switch_queue_t *EVENT_RECYCLE_QUEUE = NULL;
-static switch_queue_t *EVENT_HEADER_RECYCLE_QUEUE = NULL;
-#endif
 
 static void unsub_all_switch_event_channel(void);
 
+/*
+ * Event dispatch ring: a bounded multi-producer/multi-consumer queue where each
+ * slot carries a sequence number, so producers and dispatch threads only ever
+ * CAS the head or tail index and never take a lock on the hot path.
+ * Dispatch threads spin briefly when it runs dry and then park on a condition;
+ * producers only touch that mutex when somebody is actually parked.
+ */
+#define DISPATCH_RING_SPIN 64
+#define DISPATCH_FULL_WAIT_MS 1000
+#define DISPATCH_LAT_BUCKETS 32
+
+#if defined(_MSC_VER)
+#define ering_load(_p) (*(volatile uint32_t *)(_p))
+#define ering_store(_p, _v) (*(volatile uint32_t *)(_p) = (_v))
+#define ering_add(_p, _v) (InterlockedExchangeAdd((volatile LONG *)(_p), (LONG)(_v)) + (_v))
+#define ering_add64(_p, _v) (InterlockedExchangeAdd64((volatile LONG64 *)(_p), (LONG64)(_v)) + (_v))
+#define ering_fence() MemoryBarrier()
+static __inline int ering_cas(volatile uint32_t *p, uint32_t *expect, uint32_t val)
+{
+	uint32_t prev = (uint32_t) InterlockedCompareExchange((volatile LONG *)p, (LONG)val, (LONG)*expect);
+
+	if (prev == *expect) {
+		return 1;
+	}
+
+	*expect = prev;
+	return 0;
+}
+#else
+#define ering_load(_p) __atomic_load_n((_p), __ATOMIC_ACQUIRE)
+#define ering_store(_p, _v) __atomic_store_n((_p), (_v), __ATOMIC_RELEASE)
+#define ering_add(_p, _v) __atomic_add_fetch((_p), (_v), __ATOMIC_RELAXED)
+#define ering_add64(_p, _v) __atomic_add_fetch((_p), (_v), __ATOMIC_RELAXED)
+#define ering_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define ering_cas(_p, _e, _v) __atomic_compare_exchange_n((_p), (_e), (_v), 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#endif
+
+typedef struct {
+	volatile uint32_t seq;
+	switch_event_t *event;
+} event_ring_cell_t;
+
+typedef struct {
+	/* producers and consumers hammer different cache lines */
+	volatile uint32_t enqueue_pos;
+	char pad0[60];
+	volatile uint32_t dequeue_pos;
+	char pad1[60];
+	uint32_t mask;
+	event_ring_cell_t *cells;
+	volatile uint32_t sleepers;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	volatile uint32_t high_water;
+	volatile uint64_t enqueued;
+	volatile uint64_t drops;
+	volatile uint64_t full_waits;
+	/* enqueue latency, bucket n holds samples below 2^n usec */
+	volatile uint64_t latency[DISPATCH_LAT_BUCKETS];
+} event_ring_t;
+
+static event_ring_t *EVENT_DISPATCH_RING = NULL;
+
+static event_ring_t *event_ring_create(uint32_t len, switch_memory_pool_t *pool)
+{
+	event_ring_t *ring;
+	uint32_t size = 1, i;
+
+	while (size < len) {
+		size <<= 1;
+	}
+
+	ring = switch_core_alloc(pool, sizeof(*ring));
+	ring->cells = switch_core_alloc(pool, sizeof(event_ring_cell_t) * size);
+	ring->mask = size - 1;
+
+	for (i = 0; i < size; i++) {
+		ring->cells[i].seq = i;
+	}
+
+	switch_mutex_init(&ring->mutex, SWITCH_MUTEX_NESTED, pool);
+	switch_thread_cond_create(&ring->cond, pool);
+
+	return ring;
+}
+
+static uint32_t event_ring_depth(event_ring_t *ring)
+{
+	uint32_t tail = ering_load(&ring->dequeue_pos);
+	uint32_t head = ering_load(&ring->enqueue_pos);
+
+	return (int32_t)(head - tail) > 0 ? head - tail : 0;
+}
+
+static switch_status_t event_ring_push(event_ring_t *ring, switch_event_t *event)
+{
+	event_ring_cell_t *cell;
+	uint32_t pos = ering_load(&ring->enqueue_pos);
+
+	for (;;) {
+		int32_t dif;
+
+		cell = &ring->cells[pos & ring->mask];
+		dif = (int32_t)(ering_load(&cell->seq) - pos);
+
+		if (dif == 0) {
+			if (ering_cas(&ring->enqueue_pos, &pos, pos + 1)) {
+				break;
+			}
+		} else if (dif < 0) {
+			return SWITCH_STATUS_BREAK;
+		} else {
+			pos = ering_load(&ring->enqueue_pos);
+		}
+	}
+
+	cell->event = event;
+	ering_store(&cell->seq, pos + 1);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+static switch_event_t *event_ring_pop(event_ring_t *ring)
+{
+	event_ring_cell_t *cell;
+	switch_event_t *event;
+	uint32_t pos = ering_load(&ring->dequeue_pos);
+
+	for (;;) {
+		int32_t dif;
+
+		cell = &ring->cells[pos & ring->mask];
+		dif = (int32_t)(ering_load(&cell->seq) - (pos + 1));
+
+		if (dif == 0) {
+			if (ering_cas(&ring->dequeue_pos, &pos, pos + 1)) {
+				break;
+			}
+		} else if (dif < 0) {
+			return NULL;
+		} else {
+			pos = ering_load(&ring->dequeue_pos);
+		}
+	}
+
+	event = cell->event;
+	ering_store(&cell->seq, pos + ring->mask + 1);
+
+	return event;
+}
+
+static void event_ring_wake(event_ring_t *ring, switch_bool_t all)
+{
+	ering_fence();
+
+	if (all || ering_load(&ring->sleepers)) {
+		switch_mutex_lock(ring->mutex);
+		if (all) {
+			switch_thread_cond_broadcast(ring->cond);
+		} else {
+			switch_thread_cond_signal(ring->cond);
+		}
+		switch_mutex_unlock(ring->mutex);
+	}
+}
+
+static switch_event_t *event_ring_pop_wait(event_ring_t *ring)
+{
+	switch_event_t *event = NULL;
+	int spin = 0;
+
+	while (SYSTEM_RUNNING) {
+		if ((event = event_ring_pop(ring))) {
+			return event;
+		}
+
+		if (++spin < DISPATCH_RING_SPIN) {
+			switch_os_yield();
+			continue;
+		}
+
+		switch_mutex_lock(ring->mutex);
+		ering_add(&ring->sleepers, 1);
+		ering_fence();
+
+		if (!(event = event_ring_pop(ring)) && SYSTEM_RUNNING) {
+			if (switch_thread_cond_timedwait(ring->cond, ring->mutex, 100000) != SWITCH_STATUS_TIMEOUT) {
+				spin = 0;
+			}
+		}
+
+		ering_add(&ring->sleepers, (uint32_t) -1);
+		switch_mutex_unlock(ring->mutex);
+
+		if (event) {
+			return event;
+		}
+	}
+
+	return NULL;
+}
+
+static void event_ring_note_enqueue(event_ring_t *ring, switch_time_t usec)
+{
+	uint32_t depth = event_ring_depth(ring);
+	uint32_t hwm = ering_load(&ring->high_water);
+	int bucket = 0;
+
+	while (depth > hwm && !ering_cas(&ring->high_water, &hwm, depth));
+
+	while (usec && bucket < DISPATCH_LAT_BUCKETS - 1) {
+		usec >>= 1;
+		bucket++;
+	}
+
+	ering_add64(&ring->latency[bucket], 1);
+	ering_add64(&ring->enqueued, 1);
+}
+
 static char *my_dup(const char *s)
 {
 	size_t len = strlen(s) + 1;
@@ -126,6 +344,227 @@ static char *my_dup(const char *s)
 #define FREE(ptr) switch_safe_free(ptr)
 #endif
 
+/*
+ * Event and header slabs: every thread keeps a private free list per object
+ * class and trades whole batches with a shared depot, so allocating or freeing
+ * normally takes no lock at all.  An object freed on a different thread than
+ * the one that allocated it (the usual fate of a dispatched event) just joins
+ * the freeing thread's list and flows back to producers through the depot.
+ */
+#define EVENT_SLAB_BATCH 64
+#define EVENT_SLAB_DEPOT_MAX 1024
+
+typedef enum {
+	EVENT_SLAB_EVENT,
+	EVENT_SLAB_HEADER,
+	EVENT_SLAB_CLASSES
+} event_slab_class_t;
+
+typedef struct event_slab_obj {
+	struct event_slab_obj *next;
+	struct event_slab_obj *next_batch;
+	uint32_t len;
+} event_slab_obj_t;
+
+typedef struct {
+	uint64_t allocs;
+	uint64_t hits;
+	uint64_t mallocs;
+	uint64_t frees;
+} event_slab_stats_t;
+
+typedef struct event_slab_cache {
+	event_slab_obj_t *free[EVENT_SLAB_CLASSES];
+	uint32_t count[EVENT_SLAB_CLASSES];
+	event_slab_stats_t stats[EVENT_SLAB_CLASSES];
+	struct event_slab_cache *next;
+} event_slab_cache_t;
+
+static struct {
+	switch_threadkey_t *key;
+	switch_mutex_t *mutex;
+	int running;
+	event_slab_obj_t *depot[EVENT_SLAB_CLASSES];
+	uint32_t depot_len[EVENT_SLAB_CLASSES];
+	uint32_t depot_batches[EVENT_SLAB_CLASSES];
+	uint64_t refills[EVENT_SLAB_CLASSES];
+	uint64_t spills[EVENT_SLAB_CLASSES];
+	/* counters of threads that have already exited */
+	event_slab_stats_t retired[EVENT_SLAB_CLASSES];
+	event_slab_cache_t *caches;
+} event_slab;
+
+static const char *EVENT_SLAB_NAMES[EVENT_SLAB_CLASSES] = { "event", "event header" };
+static const switch_size_t EVENT_SLAB_SIZES[EVENT_SLAB_CLASSES] = { sizeof(switch_event_t), sizeof(switch_event_header_t) };
+
+static uint32_t event_slab_release(event_slab_obj_t *obj)
+{
+	event_slab_obj_t *next;
+	uint32_t x = 0;
+
+	for (; obj; obj = next, x++) {
+		next = obj->next;
+		free(obj);
+	}
+
+	return x;
+}
+
+/* hand the first len objects of the thread list to the depot */
+static void event_slab_spill(event_slab_cache_t *cache, event_slab_class_t cls, uint32_t len)
+{
+	event_slab_obj_t *head = cache->free[cls], *tail = head;
+	uint32_t x;
+
+	if (!head || !len) {
+		return;
+	}
+
+	for (x = 1; x < len && tail->next; x++) {
+		tail = tail->next;
+	}
+
+	cache->free[cls] = tail->next;
+	cache->count[cls] -= x;
+	tail->next = NULL;
+	head->len = x;
+
+	switch_mutex_lock(event_slab.mutex);
+	if (event_slab.depot_batches[cls] < EVENT_SLAB_DEPOT_MAX) {
+		head->next_batch = event_slab.depot[cls];
+		event_slab.depot[cls] = head;
+		event_slab.depot_len[cls] += x;
+		event_slab.depot_batches[cls]++;
+		event_slab.spills[cls]++;
+		head = NULL;
+	}
+	switch_mutex_unlock(event_slab.mutex);
+
+	event_slab_release(head);
+}
+
+static void event_slab_thread_done(void *data)
+{
+	event_slab_cache_t *cache = (event_slab_cache_t *) data, **cp;
+	int cls;
+
+	if (!event_slab.running) {
+		for (cls = 0; cls < EVENT_SLAB_CLASSES; cls++) {
+			event_slab_release(cache->free[cls]);
+		}
+		free(cache);
+		return;
+	}
+
+	for (cls = 0; cls < EVENT_SLAB_CLASSES; cls++) {
+		while (cache->free[cls]) {
+			event_slab_spill(cache, cls, EVENT_SLAB_BATCH);
+		}
+	}
+
+	switch_mutex_lock(event_slab.mutex);
+	for (cls = 0; cls < EVENT_SLAB_CLASSES; cls++) {
+		event_slab.retired[cls].allocs += cache->stats[cls].allocs;
+		event_slab.retired[cls].hits += cache->stats[cls].hits;
+		event_slab.retired[cls].mallocs += cache->stats[cls].mallocs;
+		event_slab.retired[cls].frees += cache->stats[cls].frees;
+	}
+	for (cp = &event_slab.caches; *cp; cp = &(*cp)->next) {
+		if (*cp == cache) {
+			*cp = cache->next;
+			break;
+		}
+	}
+	switch_mutex_unlock(event_slab.mutex);
+
+	free(cache);
+}
+
+static event_slab_cache_t *event_slab_cache(void)
+{
+	void *data = NULL;
+	event_slab_cache_t *cache;
+
+	if (!event_slab.running) {
+		return NULL;
+	}
+
+	switch_threadkey_private_get(&data, event_slab.key);
+
+	if (!(cache = (event_slab_cache_t *) data)) {
+		switch_zmalloc(cache, sizeof(*cache));
+		switch_threadkey_private_set(cache, event_slab.key);
+
+		switch_mutex_lock(event_slab.mutex);
+		cache->next = event_slab.caches;
+		event_slab.caches = cache;
+		switch_mutex_unlock(event_slab.mutex);
+	}
+
+	return cache;
+}
+
+static void *event_slab_alloc(event_slab_class_t cls)
+{
+	event_slab_cache_t *cache = event_slab_cache();
+	event_slab_obj_t *obj;
+	void *ptr;
+
+	if (cache) {
+		cache->stats[cls].allocs++;
+
+		if (!cache->free[cls] && event_slab.depot[cls]) {
+			switch_mutex_lock(event_slab.mutex);
+			if ((obj = event_slab.depot[cls])) {
+				event_slab.depot[cls] = obj->next_batch;
+				event_slab.depot_len[cls] -= obj->len;
+				event_slab.depot_batches[cls]--;
+				event_slab.refills[cls]++;
+				cache->free[cls] = obj;
+				cache->count[cls] = obj->len;
+			}
+			switch_mutex_unlock(event_slab.mutex);
+		}
+
+		if ((obj = cache->free[cls])) {
+			cache->free[cls] = obj->next;
+			cache->count[cls]--;
+			cache->stats[cls].hits++;
+			return obj;
+		}
+
+		cache->stats[cls].mallocs++;
+	}
+
+	ptr = malloc(EVENT_SLAB_SIZES[cls]);
+	switch_assert(ptr);
+
+	return ptr;
+}
+
+static void event_slab_free(event_slab_class_t cls, void *ptr)
+{
+	event_slab_cache_t *cache;
+	event_slab_obj_t *obj = (event_slab_obj_t *) ptr;
+
+	if (!ptr) {
+		return;
+	}
+
+	if (!(cache = event_slab_cache())) {
+		free(ptr);
+		return;
+	}
+
+	cache->stats[cls].frees++;
+	obj->next = cache->free[cls];
+	cache->free[cls] = obj;
+
+	if (++cache->count[cls] >= EVENT_SLAB_BATCH * 2) {
+		event_slab_spill(cache, cls, EVENT_SLAB_BATCH);
+	}
+}
+
 /* make sure this is synced with the switch_event_types_t enum in switch_types.h
    also never put any new ones before EVENT_ALL
 */
@@ -260,6 +699,57 @@ static int switch_events_match(switch_event_t *event, switch_event_node_t *node)
 	return match;
 }
 
+static int switch_event_node_indexed(switch_event_node_t *node)
+{
+	return node->subclass_name && strncasecmp(node->subclass_name, "file:", 5) && strncasecmp(node->subclass_name, "func:", 5);
+}
+
+/* must be called with RWLOCK write locked */
+static void switch_event_index_node(switch_event_node_t *node)
+{
+	switch_event_types_t e = node->event_id;
+
+	if (!switch_event_node_indexed(node)) {
+		node->index_next = EVENT_GENERIC_NODES[e];
+		EVENT_GENERIC_NODES[e] = node;
+		return;
+	}
+
+	if (!EVENT_SUBCLASS_NODES[e]) {
+		switch_core_hash_init(&EVENT_SUBCLASS_NODES[e]);
+	}
+
+	node->index_next = switch_core_hash_find(EVENT_SUBCLASS_NODES[e], node->subclass_name);
+	switch_core_hash_insert(EVENT_SUBCLASS_NODES[e], node->subclass_name, node);
+}
+
+/* must be called with RWLOCK write locked */
+static void switch_event_unindex_node(switch_event_node_t *node)
+{
+	switch_event_types_t e = node->event_id;
+	switch_event_node_t *head, **npp;
+
+	if (!switch_event_node_indexed(node)) {
+		head = EVENT_GENERIC_NODES[e];
+	} else if (!EVENT_SUBCLASS_NODES[e] || !(head = switch_core_hash_find(EVENT_SUBCLASS_NODES[e], node->subclass_name))) {
+		return;
+	}
+
+	for (npp = &head; *npp; npp = &(*npp)->index_next) {
+		if (*npp == node) {
+			*npp = node->index_next;
+			break;
+		}
+	}
+
+	if (!switch_event_node_indexed(node)) {
+		EVENT_GENERIC_NODES[e] = head;
+	} else if (head) {
+		switch_core_hash_insert(EVENT_SUBCLASS_NODES[e], node->subclass_name, head);
+	} else {
+		switch_core_hash_delete(EVENT_SUBCLASS_NODES[e], node->subclass_name);
+	}
+}
 
 static void *SWITCH_THREAD_FUNC switch_event_deliver_thread(switch_thread_t *thread, void *obj)
 {
@@ -290,7 +780,7 @@ static void switch_event_deliver_thread_pool(switch_event_t **event)
 
 static void *SWITCH_THREAD_FUNC switch_event_dispatch_thread(switch_thread_t *thread, void *obj)
 {
-	switch_queue_t *queue = (switch_queue_t *) obj;
+	event_ring_t *ring = (event_ring_t *) obj;
 	int my_id = 0;
 
 	switch_mutex_lock(EVENT_QUEUE_MUTEX);
@@ -313,24 +803,13 @@ static void *SWITCH_THREAD_FUNC switch_event_dispatch_thread(switch_thread_t *th
 
 
 	for (;;) {
-		void *pop = NULL;
 		switch_event_t *event = NULL;
 
-		if (!SYSTEM_RUNNING) {
+		if (!(event = event_ring_pop_wait(ring))) {
 			break;
 		}
 
-		if (switch_queue_pop(queue, &pop) != SWITCH_STATUS_SUCCESS) {
-			continue;
-		}
-
-		if (!pop) {
-			break;
-		}
-
-		event = (switch_event_t *) pop;
 		switch_event_deliver(&event);
-		switch_os_yield();
 	}
 
 
@@ -349,23 +828,25 @@ static int PENDING = 0;
 
 static switch_status_t switch_event_queue_dispatch_event(switch_event_t **eventp)
 {
-
+	event_ring_t *ring = EVENT_DISPATCH_RING;
 	switch_event_t *event = *eventp;
+	switch_time_t start;
+	int waited = 0;
 
 	if (!SYSTEM_RUNNING) {
 		return SWITCH_STATUS_FALSE;
 	}
 
-	while (event) {
+	start = switch_time_now();
+
+	if (!PENDING && event_ring_depth(ring) > (uint32_t)(DISPATCH_QUEUE_LEN * DISPATCH_THREAD_COUNT)) {
 		int launch = 0;
 
 		switch_mutex_lock(EVENT_QUEUE_MUTEX);
 
-		if (!PENDING && switch_queue_size(EVENT_DISPATCH_QUEUE) > (unsigned int)(DISPATCH_QUEUE_LEN * DISPATCH_THREAD_COUNT)) {
-			if (SOFT_MAX_DISPATCH + 1 > MAX_DISPATCH) {
-				launch++;
-				PENDING++;
-			}
+		if (!PENDING && SOFT_MAX_DISPATCH + 1 > MAX_DISPATCH) {
+			launch++;
+			PENDING++;
 		}
 
 		switch_mutex_unlock(EVENT_QUEUE_MUTEX);
@@ -379,13 +860,30 @@ static switch_status_t switch_event_queue_dispatch_event(switch_event_t **eventp
 			PENDING--;
 			switch_mutex_unlock(EVENT_QUEUE_MUTEX);
 		}
+	}
+
+	while (event_ring_push(ring, event) != SWITCH_STATUS_SUCCESS) {
+		if (!waited++) {
+			ering_add64(&ring->full_waits, 1);
+		}
 
-		*eventp = NULL;
-		switch_queue_push(EVENT_DISPATCH_QUEUE, event);
-		event = NULL;
+		if (!SYSTEM_RUNNING || switch_time_now() - start > DISPATCH_FULL_WAIT_MS * 1000) {
+			if (ering_add64(&ring->drops, 1) % 1000 == 1) {
+				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Event dispatch queue full, dropping %s event (%u queued)\n",
+								  switch_event_name(event->event_id), event_ring_depth(ring));
+			}
+			return SWITCH_STATUS_FALSE;
+		}
 
+		event_ring_wake(ring, SWITCH_FALSE);
+		switch_cond_next();
 	}
 
+	*eventp = NULL;
+
+	event_ring_wake(ring, SWITCH_FALSE);
+	event_ring_note_enqueue(ring, switch_time_now() - start);
+
 	return SWITCH_STATUS_SUCCESS;
 }
 
@@ -397,13 +895,20 @@ SWITCH_DECLARE(void) switch_event_deliver(switch_event_t **event)
 	if (SYSTEM_RUNNING) {
 		switch_thread_rwlock_rdlock(RWLOCK);
 		for (e = (*event)->event_id;; e = SWITCH_EVENT_ALL) {
-			for (node = EVENT_NODES[e]; node; node = node->next) {
+			for (node = EVENT_GENERIC_NODES[e]; node; node = node->index_next) {
 				if (switch_events_match(*event, node)) {
 					(*event)->bind_user_data = node->user_data;
 					node->callback(*event);
 				}
 			}
 
+			if ((*event)->subclass_name && EVENT_SUBCLASS_NODES[e]) {
+				for (node = switch_core_hash_find(EVENT_SUBCLASS_NODES[e], (*event)->subclass_name); node; node = node->index_next) {
+					(*event)->bind_user_data = node->user_data;
+					node->callback(*event);
+				}
+			}
+
 			if (e == SWITCH_EVENT_ALL) {
 				break;
 			}
@@ -498,27 +1003,59 @@ SWITCH_DECLARE(switch_status_t) switch_event_reserve_subclass_detailed(const cha
 
 SWITCH_DECLARE(void) switch_core_memory_reclaim_events(void)
 {
-#ifdef SWITCH_EVENT_RECYCLE
-
-	void *pop;
-	int size;
-	size = switch_queue_size(EVENT_RECYCLE_QUEUE);
+	event_slab_cache_t *cache, *mine = NULL;
+	event_slab_obj_t *batch, *next;
+	void *data = NULL;
+	int cls;
 
-	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Returning %d recycled event(s) %d bytes\n", size, (int) sizeof(switch_event_t) * size);
-	size = switch_queue_size(EVENT_HEADER_RECYCLE_QUEUE);
-	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Returning %d recycled event header(s) %d bytes\n",
-					  size, (int) sizeof(switch_event_header_t) * size);
+	if (!event_slab.mutex) {
+		return;
+	}
 
-	while (switch_queue_trypop(EVENT_HEADER_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS && pop) {
-		free(pop);
+	if (event_slab.key && switch_threadkey_private_get(&data, event_slab.key) == SWITCH_STATUS_SUCCESS) {
+		mine = (event_slab_cache_t *) data;
 	}
-	while (switch_queue_trypop(EVENT_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS && pop) {
-		free(pop);
+
+	switch_mutex_lock(event_slab.mutex);
+
+	for (cls = 0; cls < EVENT_SLAB_CLASSES; cls++) {
+		event_slab_stats_t total = event_slab.retired[cls];
+		uint32_t cached = 0, returned = 0;
+
+		for (cache = event_slab.caches; cache; cache = cache->next) {
+			total.allocs += cache->stats[cls].allocs;
+			total.hits += cache->stats[cls].hits;
+			total.mallocs += cache->stats[cls].mallocs;
+			total.frees += cache->stats[cls].frees;
+			cached += cache->count[cls];
+		}
+
+		if (mine) {
+			cached -= mine->count[cls];
+			returned += event_slab_release(mine->free[cls]);
+			mine->free[cls] = NULL;
+			mine->count[cls] = 0;
+		}
+
+		for (batch = event_slab.depot[cls]; batch; batch = next) {
+			next = batch->next_batch;
+			returned += event_slab_release(batch);
+		}
+
+		event_slab.depot[cls] = NULL;
+		event_slab.depot_len[cls] = 0;
+		event_slab.depot_batches[cls] = 0;
+
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE,
+						  "%s slab: %" SWITCH_UINT64_T_FMT " alloc(s) %.1f%% from slab %" SWITCH_UINT64_T_FMT " malloc(s) %" SWITCH_UINT64_T_FMT
+						  " free(s) %" SWITCH_UINT64_T_FMT " refill(s) %" SWITCH_UINT64_T_FMT " spill(s) %u held by threads\n",
+						  EVENT_SLAB_NAMES[cls], total.allocs, total.allocs ? (double) total.hits * 100 / total.allocs : 0.0, total.mallocs,
+						  total.frees, event_slab.refills[cls], event_slab.spills[cls], cached);
+		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Returning %u cached %s(s) %u bytes\n",
+						  returned, EVENT_SLAB_NAMES[cls], (unsigned int) (returned * EVENT_SLAB_SIZES[cls]));
 	}
-#else
-	return;
-#endif
 
+	switch_mutex_unlock(event_slab.mutex);
 }
 
 SWITCH_DECLARE(switch_status_t) switch_event_shutdown(void)
@@ -547,18 +1084,15 @@ SWITCH_DECLARE(switch_status_t) switch_event_shutdown(void)
 	if (runtime.events_use_dispatch) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Stopping dispatch queues\n");
 
-		for(x = 0; x < (uint32_t)DISPATCH_THREAD_COUNT; x++) {
-			switch_queue_trypush(EVENT_DISPATCH_QUEUE, NULL);
-		}
-		
+		event_ring_wake(EVENT_DISPATCH_RING, SWITCH_TRUE);
 
-		switch_queue_interrupt_all(EVENT_DISPATCH_QUEUE);
-		
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CONSOLE, "Stopping dispatch threads\n");
-		
-		for(x = 0; x < (uint32_t)DISPATCH_THREAD_COUNT; x++) {
+
+		for(x = 0; x < SOFT_MAX_DISPATCH; x++) {
 			switch_status_t st;
-			switch_thread_join(&st, EVENT_DISPATCH_QUEUE_THREADS[x]);
+			if (EVENT_DISPATCH_QUEUE_THREADS[x]) {
+				switch_thread_join(&st, EVENT_DISPATCH_QUEUE_THREADS[x]);
+			}
 		}
 	}
 
@@ -572,11 +1106,9 @@ SWITCH_DECLARE(switch_status_t) switch_event_shutdown(void)
 	}
 
 	if (runtime.events_use_dispatch) {
-		void *pop = NULL;
 		switch_event_t *event = NULL;
 
-		while (switch_queue_trypop(EVENT_DISPATCH_QUEUE, &pop) == SWITCH_STATUS_SUCCESS && pop) {
-			event = (switch_event_t *) pop;
+		while ((event = event_ring_pop(EVENT_DISPATCH_RING))) {
 			switch_event_destroy(&event);
 		}
 	}
@@ -596,18 +1128,28 @@ SWITCH_DECLARE(switch_status_t) switch_event_shutdown(void)
 	switch_core_hash_destroy(&event_channel_manager.perm_hash);
 
 	switch_core_hash_destroy(&CUSTOM_HASH);
+
+	/* the delivery index only points at nodes owned by EVENT_NODES */
+	for (x = 0; x <= SWITCH_EVENT_ALL; x++) {
+		if (EVENT_SUBCLASS_NODES[x]) {
+			switch_core_hash_destroy(&EVENT_SUBCLASS_NODES[x]);
+		}
+		EVENT_GENERIC_NODES[x] = NULL;
+	}
+
 	switch_core_memory_reclaim_events();
+	event_slab.running = 0;
 
 	return SWITCH_STATUS_SUCCESS;
 }
 
 static void check_dispatch(void)
 {
-	if (!EVENT_DISPATCH_QUEUE) {
+	if (!EVENT_DISPATCH_RING) {
 		switch_mutex_lock(BLOCK);
 		
-		if (!EVENT_DISPATCH_QUEUE) {
-			switch_queue_create(&EVENT_DISPATCH_QUEUE, DISPATCH_QUEUE_LEN * MAX_DISPATCH, THRUNTIME_POOL);
+		if (!EVENT_DISPATCH_RING) {
+			EVENT_DISPATCH_RING = event_ring_create(DISPATCH_QUEUE_LEN * MAX_DISPATCH, THRUNTIME_POOL);
 			switch_event_launch_dispatch_threads(1);
 			
 			while (!THREAD_COUNT) {
@@ -647,7 +1189,7 @@ SWITCH_DECLARE(void) switch_event_launch_dispatch_threads(uint32_t max)
 		switch_threadattr_create(&thd_attr, pool);
 		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
 		switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
-		switch_thread_create(&EVENT_DISPATCH_QUEUE_THREADS[index], thd_attr, switch_event_dispatch_thread, EVENT_DISPATCH_QUEUE, pool);
+		switch_thread_create(&EVENT_DISPATCH_QUEUE_THREADS[index], thd_attr, switch_event_dispatch_thread, EVENT_DISPATCH_RING, pool);
 		while(--sanity && !EVENT_DISPATCH_QUEUE_RUNNING[index]) switch_yield(10000);
 
 		if (index == 1) {
@@ -661,6 +1203,50 @@ SWITCH_DECLARE(void) switch_event_launch_dispatch_threads(uint32_t max)
 	SOFT_MAX_DISPATCH = index;
 }
 
+SWITCH_DECLARE(void) switch_event_get_queue_stats(switch_event_queue_stats_t *stats)
+{
+	event_ring_t *ring = EVENT_DISPATCH_RING;
+	uint64_t total = 0, seen = 0;
+	uint32_t *pct[] = { &stats->p50_usec, &stats->p90_usec, &stats->p99_usec, &stats->p999_usec };
+	uint64_t mark[4];
+	int i, p = 0;
+
+	memset(stats, 0, sizeof(*stats));
+
+	if (!ring) {
+		return;
+	}
+
+	stats->size = ring->mask + 1;
+	stats->depth = event_ring_depth(ring);
+	stats->high_water = ering_load(&ring->high_water);
+	stats->threads = DISPATCH_THREAD_COUNT;
+	stats->enqueued = ring->enqueued;
+	stats->drops = ring->drops;
+	stats->full_waits = ring->full_waits;
+
+	for (i = 0; i < DISPATCH_LAT_BUCKETS; i++) {
+		total += ring->latency[i];
+	}
+
+	if (!total) {
+		return;
+	}
+
+	mark[0] = (total * 50 + 99) / 100;
+	mark[1] = (total * 90 + 99) / 100;
+	mark[2] = (total * 99 + 99) / 100;
+	mark[3] = (total * 999 + 999) / 1000;
+
+	/* report the upper edge of the bucket each percentile falls in */
+	for (i = 0; i < DISPATCH_LAT_BUCKETS && p < 4; i++) {
+		seen += ring->latency[i];
+		while (p < 4 && seen >= mark[p]) {
+			*pct[p++] = i ? (uint32_t)((1ULL << i) - 1) : 0;
+		}
+	}
+}
+
 SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 {
 
@@ -678,6 +1264,11 @@ SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 	switch_mutex_init(&EVENT_QUEUE_MUTEX, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
 	switch_core_hash_init(&CUSTOM_HASH);
 
+	switch_mutex_init(&event_slab.mutex, SWITCH_MUTEX_NESTED, RUNTIME_POOL);
+	if (switch_threadkey_private_create(&event_slab.key, event_slab_thread_done, RUNTIME_POOL) == SWITCH_STATUS_SUCCESS) {
+		event_slab.running = 1;
+	}
+
 	if (switch_core_test_flag(SCF_MINIMAL)) {
 		return SWITCH_STATUS_SUCCESS;
 	}
@@ -701,11 +1292,6 @@ SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 	switch_find_local_ip(guess_ip_v6, sizeof(guess_ip_v6), NULL, AF_INET6);
 
 
-#ifdef SWITCH_EVENT_RECYCLE
-	switch_queue_create(&EVENT_RECYCLE_QUEUE, 250000, THRUNTIME_POOL);
-	switch_queue_create(&EVENT_HEADER_RECYCLE_QUEUE, 250000, THRUNTIME_POOL);
-#endif
-
 	check_dispatch();
 
 	switch_mutex_lock(EVENT_QUEUE_MUTEX);
@@ -718,25 +1304,13 @@ SWITCH_DECLARE(switch_status_t) switch_event_init(switch_memory_pool_t *pool)
 SWITCH_DECLARE(switch_status_t) switch_event_create_subclass_detailed(const char *file, const char *func, int line,
 																	  switch_event_t **event, switch_event_types_t event_id, const char *subclass_name)
 {
-#ifdef SWITCH_EVENT_RECYCLE
-	void *pop;
-#endif
-
 	*event = NULL;
 
 	if ((event_id != SWITCH_EVENT_CLONE && event_id != SWITCH_EVENT_CUSTOM) && subclass_name) {
 		return SWITCH_STATUS_GENERR;
 	}
-#ifdef SWITCH_EVENT_RECYCLE
-	if (EVENT_RECYCLE_QUEUE && switch_queue_trypop(EVENT_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS && pop) {
-		*event = (switch_event_t *) pop;
-	} else {
-#endif
-		*event = ALLOC(sizeof(switch_event_t));
-		switch_assert(*event);
-#ifdef SWITCH_EVENT_RECYCLE
-	}
-#endif
+
+	*event = event_slab_alloc(EVENT_SLAB_EVENT);
 
 	memset(*event, 0, sizeof(switch_event_t));
 
@@ -764,6 +1338,122 @@ SWITCH_DECLARE(switch_status_t) switch_event_set_priority(switch_event_t *event,
 	return SWITCH_STATUS_SUCCESS;
 }
 
+/*
+ * Header lookup index: an open addressed table mapping a header name to the
+ * first header of that name in the list.  The list itself stays the source of
+ * truth (and keeps insertion order for serialization); the index is only
+ * built by writers once an event has more than SWITCH_EVENT_HINDEX_MIN headers
+ * so lookups stay read-only.
+ */
+#define SWITCH_EVENT_HINDEX_MIN 32
+
+struct switch_event_hindex {
+	uint32_t size;
+	uint32_t used;
+	switch_event_header_t **slots;
+};
+
+static switch_event_header_t HINDEX_TOMBSTONE;
+
+static switch_event_header_t **switch_event_hindex_slot(struct switch_event_hindex *hi, const char *name, unsigned long hash, switch_bool_t insert)
+{
+	uint32_t mask = hi->size - 1, i = (uint32_t) hash & mask;
+	switch_event_header_t **tomb = NULL, *hp;
+
+	for (;;) {
+		hp = hi->slots[i];
+
+		if (!hp) {
+			return insert ? (tomb ? tomb : &hi->slots[i]) : NULL;
+		}
+
+		if (hp == &HINDEX_TOMBSTONE) {
+			if (!tomb) {
+				tomb = &hi->slots[i];
+			}
+		} else if (hp->hash == hash && !strcasecmp(hp->name, name)) {
+			return &hi->slots[i];
+		}
+
+		i = (i + 1) & mask;
+	}
+}
+
+/* the slot holding this very header, if it is the one indexed for its name */
+static switch_event_header_t **switch_event_hindex_find(struct switch_event_hindex *hi, switch_event_header_t *header)
+{
+	uint32_t mask = hi->size - 1, i = (uint32_t) header->hash & mask;
+
+	while (hi->slots[i]) {
+		if (hi->slots[i] == header) {
+			return &hi->slots[i];
+		}
+		i = (i + 1) & mask;
+	}
+
+	return NULL;
+}
+
+static void switch_event_hindex_free(switch_event_t *event)
+{
+	if (event->hindex) {
+		FREE(event->hindex->slots);
+		FREE(event->hindex);
+	}
+}
+
+static void switch_event_hindex_build(switch_event_t *event)
+{
+	struct switch_event_hindex *hi;
+	switch_event_header_t *hp, **slot;
+	uint32_t size = 64;
+
+	switch_event_hindex_free(event);
+
+	while (size < (uint32_t) event->header_count * 4) {
+		size <<= 1;
+	}
+
+	switch_zmalloc(hi, sizeof(*hi));
+	switch_zmalloc(hi->slots, sizeof(switch_event_header_t *) * size);
+	hi->size = size;
+
+	for (hp = event->headers; hp; hp = hp->next) {
+		slot = switch_event_hindex_slot(hi, hp->name, hp->hash, SWITCH_TRUE);
+		if (!*slot) {
+			*slot = hp;
+			hi->used++;
+		}
+	}
+
+	event->hindex = hi;
+}
+
+/* index a header that was just linked in; top says it now shadows any older header of the same name */
+static void switch_event_hindex_add(switch_event_t *event, switch_event_header_t *header, switch_bool_t top)
+{
+	struct switch_event_hindex *hi = event->hindex;
+	switch_event_header_t **slot;
+
+	if (!hi) {
+		if (event->header_count > SWITCH_EVENT_HINDEX_MIN) {
+			switch_event_hindex_build(event);
+		}
+		return;
+	}
+
+	slot = switch_event_hindex_slot(hi, header->name, header->hash, SWITCH_TRUE);
+
+	if (!*slot) {
+		*slot = header;
+		if (++hi->used * 2 > hi->size) {
+			switch_event_hindex_build(event);
+		}
+	} else if (*slot == &HINDEX_TOMBSTONE || top) {
+		*slot = header;
+	}
+}
+
 SWITCH_DECLARE(switch_status_t) switch_event_rename_header(switch_event_t *event, const char *header_name, const char *new_header_name)
 {
 	switch_event_header_t *hp;
@@ -789,6 +1479,10 @@ SWITCH_DECLARE(switch_status_t) switch_event_rename_header(switch_event_t *event
 		}
 	}
 
+	if (x && event->hindex) {
+		switch_event_hindex_build(event);
+	}
+
 	return x ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
 }
 
@@ -806,6 +1500,11 @@ SWITCH_DECLARE(switch_event_header_t *) switch_event_get_header_ptr(switch_event
 
 	hash = switch_ci_hashfunc_default(header_name, &hlen);
 
+	if (event->hindex) {
+		switch_event_header_t **slot = switch_event_hindex_slot(event->hindex, header_name, hash, SWITCH_FALSE);
+		return slot ? *slot : NULL;
+	}
+
 	for (hp = event->headers; hp; hp = hp->next) {
 		if ((!hp->hash || hash == hp->hash) && !strcasecmp(hp->name, header_name)) {
 			return hp;
@@ -842,7 +1541,7 @@ SWITCH_DECLARE(char *) switch_event_get_body(switch_event_t *event)
 
 SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *event, const char *header_name, const char *val)
 {
-	switch_event_header_t *hp, *lp = NULL, *tp;
+	switch_event_header_t *hp, *lp = NULL, *tp, *keep = NULL, **slot = NULL;
 	switch_status_t status = SWITCH_STATUS_FALSE;
 	int x = 0;
 	switch_ssize_t hlen = -1;
@@ -866,6 +1565,12 @@ SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *even
 			if (hp == event->last_header || !hp->next) {
 				event->last_header = lp;
 			}
+			event->header_count--;
+
+			if (event->hindex && !slot) {
+				slot = switch_event_hindex_find(event->hindex, hp);
+			}
+
 			FREE(hp->name);
 
 			if (hp->idx) {
@@ -880,19 +1585,20 @@ SWITCH_DECLARE(switch_status_t) switch_event_del_header_val(switch_event_t *even
 			FREE(hp->value);
 
 			memset(hp, 0, sizeof(*hp));
-#ifdef SWITCH_EVENT_RECYCLE
-			if (switch_queue_trypush(EVENT_HEADER_RECYCLE_QUEUE, hp) != SWITCH_STATUS_SUCCESS) {
-				FREE(hp);
-			}
-#else
-			FREE(hp);
-#endif
+			event_slab_free(EVENT_SLAB_HEADER, hp);
 			status = SWITCH_STATUS_SUCCESS;
 		} else {
+			if (!keep && (!hp->hash || hash == hp->hash) && !strcasecmp(header_name, hp->name)) {
+				keep = hp;
+			}
 			lp = hp;
 		}
 	}
 
+	if (slot) {
+		*slot = keep ? keep : &HINDEX_TOMBSTONE;
+	}
+
 	return status;
 }
 
@@ -900,23 +1606,12 @@ static switch_event_header_t *new_header(const char *header_name)
 {
 	switch_event_header_t *header;
 
-#ifdef SWITCH_EVENT_RECYCLE
-		void *pop;
-		if (EVENT_HEADER_RECYCLE_QUEUE && switch_queue_trypop(EVENT_HEADER_RECYCLE_QUEUE, &pop) == SWITCH_STATUS_SUCCESS) {
-			header = (switch_event_header_t *) pop;
-		} else {
-#endif
-			header = ALLOC(sizeof(*header));
-			switch_assert(header);
-#ifdef SWITCH_EVENT_RECYCLE
-		}
-#endif
-
-		memset(header, 0, sizeof(*header));
-		header->name = DUP(header_name);
+	header = event_slab_alloc(EVENT_SLAB_HEADER);
 
-		return header;
+	memset(header, 0, sizeof(*header));
+	header->name = DUP(header_name);
 
+	return header;
 }
 
 SWITCH_DECLARE(int) switch_event_add_array(switch_event_t *event, const char *var, const char *val)
@@ -1148,6 +1843,9 @@ static switch_status_t switch_event_base_add_header(switch_event_t *event, switc
 			}
 			event->last_header = header;
 		}
+
+		event->header_count++;
+		switch_event_hindex_add(event, header, (stack & SWITCH_STACK_TOP) ? SWITCH_TRUE : SWITCH_FALSE);
 	}
 
  end:
@@ -1255,25 +1953,14 @@ SWITCH_DECLARE(void) switch_event_destroy(switch_event_t **event)
 			FREE(this->value);
 
 
-#ifdef SWITCH_EVENT_RECYCLE
-			if (switch_queue_trypush(EVENT_HEADER_RECYCLE_QUEUE, this) != SWITCH_STATUS_SUCCESS) {
-				FREE(this);
-			}
-#else
-			FREE(this);
-#endif
+			event_slab_free(EVENT_SLAB_HEADER, this);
 
 
 		}
 		FREE(ep->body);
 		FREE(ep->subclass_name);
-#ifdef SWITCH_EVENT_RECYCLE
-		if (switch_queue_trypush(EVENT_RECYCLE_QUEUE, ep) != SWITCH_STATUS_SUCCESS) {
-			FREE(ep);
-		}
-#else
-		FREE(ep);
-#endif
+		switch_event_hindex_free(ep);
+		event_slab_free(EVENT_SLAB_EVENT, ep);
 
 	}
 	*event = NULL;
@@ -2053,6 +2740,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_bind_removable(const char *id, swit
 		}
 
 		EVENT_NODES[event] = event_node;
+		switch_event_index_node(event_node);
 		switch_mutex_unlock(BLOCK);
 		switch_thread_rwlock_unlock(RWLOCK);
 		/* </LOCKED> ----------------------------------------------- */
@@ -2097,6 +2785,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_unbind_callback(switch_event_callba
 					EVENT_NODES[n->event_id] = n->next;
 				}
 
+				switch_event_unindex_node(n);
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Event Binding deleted for %s:%s\n", n->id, switch_event_name(n->event_id));
 				FREE(n->subclass_name);
 				FREE(n->id);
@@ -2137,6 +2826,7 @@ SWITCH_DECLARE(switch_status_t) switch_event_unbind(switch_event_node_t **node)
 			} else {
 				EVENT_NODES[n->event_id] = n->next;
 			}
+			switch_event_unindex_node(n);
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_NOTICE, "Event Binding deleted for %s:%s\n", n->id, switch_event_name(n->event_id));
 			FREE(n->subclass_name);
 			FREE(n->id);
@@ -37,6 +37,7 @@
 #define PERIOD_LEN 250
 #define MAX_FRAME_PADDING 2
 #define MAX_MISSING_SEQ 20
+#define MAX_NACK_BATCH 256
 #define jb_debug(_jb, _level, _format, ...) if (_jb->debug_level >= _level) switch_log_printf(SWITCH_CHANNEL_SESSION_LOG_CLEAN(_jb->session), SWITCH_LOG_ALERT, "JB:%p:%s lv:%d ln:%.4d sz:%.3u/%.3u/%.3u/%.3u c:%.3u %.3u/%.3u/%.3u/%.3u %.2f%% ->" _format, (void *) _jb, (jb->type == SJB_AUDIO ? "aud" : "vid"), _level, __LINE__,  _jb->min_frame_len, _jb->max_frame_len, _jb->frame_len, _jb->complete_frames, _jb->period_count, _jb->consec_good_count, _jb->period_good_count, _jb->consec_miss_count, _jb->period_miss_count, _jb->period_miss_pct, __VA_ARGS__)
 
 //const char *TOKEN_1 = "ONE";
@@ -89,6 +90,11 @@ struct switch_jb_s {
 	uint8_t debug_level;
 	uint16_t next_seq;
 	switch_size_t last_len;
+	uint64_t bytes_copied;
+	uint64_t bytes_avoided;
+	uint32_t nack_requested;
+	uint32_t nack_recovered;
+	uint32_t nack_late;
 	switch_inthash_t *missing_seq_hash;
 	switch_inthash_t *node_hash;
 	switch_inthash_t *node_hash_ts;
@@ -568,13 +574,29 @@ static inline void drop_second_newest_frame(switch_jb_t *jb)
 }
 #endif
 
+/* Copy only the rtp header and the bytes actually received instead of the whole 16k packet struct */
+static inline void copy_packet(switch_jb_t *jb, switch_rtp_packet_t *dst, const switch_rtp_packet_t *src, switch_size_t len)
+{
+	/* len does not count rtp header extensions, so keep copying len bytes of body like we always did */
+	switch_size_t body_len = len;
+
+	if (body_len > sizeof(src->body)) {
+		body_len = sizeof(src->body);
+	}
+
+	dst->header = src->header;
+	memcpy(dst->body, src->body, body_len);
+
+	jb->bytes_copied += sizeof(src->header) + body_len;
+	jb->bytes_avoided += sizeof(*src) - sizeof(src->header) - body_len;
+}
+
 static inline void add_node(switch_jb_t *jb, switch_rtp_packet_t *packet, switch_size_t len)
 {
 	switch_jb_node_t *node = new_node(jb);
 
-	node->packet = *packet;
 	node->len = len;
-	memcpy(node->packet.body, packet->body, len);
+	copy_packet(jb, &node->packet, packet, len);
 
 	switch_core_inthash_insert(jb->node_hash, node->packet.header.seq, node);
 
@@ -1002,6 +1024,8 @@ SWITCH_DECLARE(switch_status_t) switch_jb_destroy(switch_jb_t **jbp)
 {
 	switch_jb_t *jb = *jbp;
 	*jbp = NULL;
+
+	jb_debug(jb, 1, "Copied %" SWITCH_UINT64_T_FMT " packet bytes, avoided %" SWITCH_UINT64_T_FMT "\n", jb->bytes_copied, jb->bytes_avoided);
 	
 	if (jb->type == SJB_VIDEO) {
 		switch_core_inthash_destroy(&jb->missing_seq_hash);
@@ -1021,6 +1045,14 @@ SWITCH_DECLARE(switch_status_t) switch_jb_destroy(switch_jb_t **jbp)
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_DECLARE(void) switch_jb_get_copy_stats(switch_jb_t *jb, uint64_t *copied, uint64_t *avoided)
+{
+	switch_mutex_lock(jb->mutex);
+	if (copied) *copied = jb->bytes_copied;
+	if (avoided) *avoided = jb->bytes_avoided;
+	switch_mutex_unlock(jb->mutex);
+}
+
 SWITCH_DECLARE(uint32_t) switch_jb_pop_nack(switch_jb_t *jb)
 {
 	switch_hash_index_t *hi = NULL;
@@ -1103,6 +1135,94 @@ SWITCH_DECLARE(uint32_t) switch_jb_pop_nack(switch_jb_t *jb)
 	return nack;
 }
 
+static int nack_seq_cmp(const void *l, const void *r)
+{
+	return (int) *(const uint16_t *) l - (int) *(const uint16_t *) r;
+}
+
+static inline void renack(switch_jb_t *jb, uint16_t seq, switch_time_t now)
+{
+	switch_core_inthash_delete(jb->missing_seq_hash, (uint32_t)htons(seq));
+	switch_core_inthash_insert(jb->missing_seq_hash, (uint32_t)htons(seq), (void *)(intptr_t)now);
+	jb->nack_requested++;
+}
+
+/* Build up to max NACK entries (pid + blp) out of one pass over the missing seqs */
+SWITCH_DECLARE(int) switch_jb_pop_nacks(switch_jb_t *jb, uint32_t *nacks, int max)
+{
+	switch_hash_index_t *hi = NULL;
+	uint16_t seqs[MAX_NACK_BATCH];
+	switch_time_t now = switch_time_now();
+	int count = 0, n = 0, i, j;
+	void *val;
+	const void *var;
+
+	if (jb->type != SJB_VIDEO || max <= 0) {
+		return 0;
+	}
+
+	switch_mutex_lock(jb->mutex);
+
+ top:
+
+	count = 0;
+
+	for (hi = switch_core_hash_first_iter(jb->missing_seq_hash, hi); hi; hi = switch_core_hash_next(&hi)) {
+		uint16_t seq;
+		switch_time_t then = 0;
+
+		switch_core_hash_this(hi, &var, NULL, &val);
+
+		seq = ntohs(*((uint16_t *) var));
+		then = (intptr_t) val;
+
+		if (then != 1 && now - then < RENACK_TIME) {
+			continue;
+		}
+
+		if (seq < ntohs(jb->target_seq) - jb->frame_len) {
+			jb_debug(jb, 3, "NACKABLE seq %u expired\n", seq);
+			switch_core_inthash_delete(jb->missing_seq_hash, (uint32_t)htons(seq));
+			goto top;
+		}
+
+		if (count < MAX_NACK_BATCH) {
+			seqs[count++] = seq;
+		}
+	}
+
+	switch_safe_free(hi);
+
+	qsort(seqs, count, sizeof(seqs[0]), nack_seq_cmp);
+
+	for (i = 0; i < count && n < max; i = j) {
+		uint16_t pid = seqs[i], blp = 0;
+
+		renack(jb, pid, now);
+
+		for (j = i + 1; j < count && seqs[j] - pid <= 16; j++) {
+			blp |= (1 << (seqs[j] - pid - 1));
+			renack(jb, seqs[j], now);
+		}
+
+		jb_debug(jb, 3, "Found NACKABLE seq %u blp %04x\n", pid, blp);
+		nacks[n++] = (uint32_t) htons(pid) | ((uint32_t) htons(blp) << 16);
+	}
+
+	switch_mutex_unlock(jb->mutex);
+
+	return n;
+}
+
+SWITCH_DECLARE(void) switch_jb_get_nack_stats(switch_jb_t *jb, uint32_t *requested, uint32_t *recovered, uint32_t *late)
+{
+	switch_mutex_lock(jb->mutex);
+	if (requested) *requested = jb->nack_requested;
+	if (recovered) *recovered = jb->nack_recovered;
+	if (late) *late = jb->nack_late;
+	switch_mutex_unlock(jb->mutex);
+}
+
 SWITCH_DECLARE(switch_status_t) switch_jb_put_packet(switch_jb_t *jb, switch_rtp_packet_t *packet, switch_size_t len)
 {
 	uint32_t i;
@@ -1121,12 +1241,16 @@ SWITCH_DECLARE(switch_status_t) switch_jb_put_packet(switch_jb_t *jb, switch_rtp
 		jb->next_seq = htons(got + 1);
 	} else {
 
-		if (switch_core_inthash_delete(jb->missing_seq_hash, (uint32_t)htons(got))) {
+		void *nacked;
+
+		if ((nacked = switch_core_inthash_delete(jb->missing_seq_hash, (uint32_t)htons(got)))) {
 			if (got < ntohs(jb->target_seq)) {
 				jb_debug(jb, 2, "got nacked seq %u too late\n", got);
 				jb_frame_inc(jb, 1);
+				if ((intptr_t) nacked != 1) jb->nack_late++;
 			} else {
 				jb_debug(jb, 2, "got nacked %u saved the day!\n", got);
+				if ((intptr_t) nacked != 1) jb->nack_recovered++;
 			}
 		}
 
@@ -1176,9 +1300,8 @@ SWITCH_DECLARE(switch_status_t) switch_jb_get_packet_by_seq(switch_jb_t *jb, uin
 	switch_mutex_lock(jb->mutex);
 	if ((node = switch_core_inthash_find(jb->node_hash, seq))) {
 		jb_debug(jb, 2, "Found buffered seq: %u\n", ntohs(seq));
-		*packet = node->packet;
 		*len = node->len;
-		memcpy(packet->body, node->packet.body, node->len);
+		copy_packet(jb, packet, &node->packet, node->len);
 		status = SWITCH_STATUS_SUCCESS;
 	} else {
 		jb_debug(jb, 2, "Missing buffered seq: %u\n", ntohs(seq));
@@ -1319,10 +1442,9 @@ SWITCH_DECLARE(switch_status_t) switch_jb_get_packet(switch_jb_t *jb, switch_rtp
 	if (node) {
 		status = SWITCH_STATUS_SUCCESS;
 		
-		*packet = node->packet;
 		*len = node->len;
 		jb->last_len = *len;
-		memcpy(packet->body, node->packet.body, node->len);
+		copy_packet(jb, packet, &node->packet, node->len);
 		hide_node(node, SWITCH_TRUE);
 
 		jb_debug(jb, 1, "GET packet ts:%u seq:%u %s\n", ntohl(packet->header.ts), ntohs(packet->header.seq), packet->header.m ? " <MARK>" : "");
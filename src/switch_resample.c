@@ -271,6 +271,212 @@ SWITCH_DECLARE(uint32_t) switch_unmerge_sln(int16_t *data, uint32_t samples, int
 	return x;
 }
 
+/* Conference style mixing kernels.  The x86 versions are compiled with target attributes and
+   picked at runtime so the build does not need -msse2/-mavx2. */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+	(defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SWITCH_MIX_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void (*mix_accumulate_func_t)(int32_t *mix, const int16_t *data, uint32_t samples);
+typedef void (*mix_unmix_func_t)(int16_t *out, const int32_t *mix, const int16_t *own, uint32_t own_samples, uint32_t samples);
+
+typedef struct {
+	const char *name;
+	mix_accumulate_func_t accumulate;
+	mix_unmix_func_t unmix;
+} mix_kernel_t;
+
+static void mix_accumulate_scalar(int32_t *mix, const int16_t *data, uint32_t samples)
+{
+	uint32_t x;
+
+	for (x = 0; x < samples; x++) {
+		mix[x] += data[x];
+	}
+}
+
+static void mix_unmix_range(int16_t *out, const int32_t *mix, const int16_t *own, uint32_t own_samples, uint32_t x, uint32_t samples)
+{
+	int32_t z;
+
+	for (; x < samples; x++) {
+		z = mix[x];
+
+		if (x < own_samples) {
+			z -= own[x];
+		}
+
+		switch_normalize_to_16bit(z);
+		out[x] = (int16_t) z;
+	}
+}
+
+static void mix_unmix_scalar(int16_t *out, const int32_t *mix, const int16_t *own, uint32_t own_samples, uint32_t samples)
+{
+	mix_unmix_range(out, mix, own, own_samples, 0, samples);
+}
+
+#ifdef SWITCH_MIX_X86
+__attribute__((target("sse2")))
+static void mix_accumulate_sse2(int32_t *mix, const int16_t *data, uint32_t samples)
+{
+	uint32_t x = 0;
+
+	for (; x + 8 <= samples; x += 8) {
+		__m128i d = _mm_loadu_si128((const __m128i *) (data + x));
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16);
+
+		_mm_storeu_si128((__m128i *) (mix + x), _mm_add_epi32(_mm_loadu_si128((const __m128i *) (mix + x)), lo));
+		_mm_storeu_si128((__m128i *) (mix + x + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i *) (mix + x + 4)), hi));
+	}
+
+	mix_accumulate_scalar(mix + x, data + x, samples - x);
+}
+
+__attribute__((target("sse2")))
+static void mix_unmix_sse2(int16_t *out, const int32_t *mix, const int16_t *own, uint32_t own_samples, uint32_t samples)
+{
+	uint32_t x = 0, own_end = own ? (own_samples < samples ? own_samples : samples) : 0;
+
+	for (; x + 8 <= own_end; x += 8) {
+		__m128i o = _mm_loadu_si128((const __m128i *) (own + x));
+		__m128i lo = _mm_sub_epi32(_mm_loadu_si128((const __m128i *) (mix + x)), _mm_srai_epi32(_mm_unpacklo_epi16(o, o), 16));
+		__m128i hi = _mm_sub_epi32(_mm_loadu_si128((const __m128i *) (mix + x + 4)), _mm_srai_epi32(_mm_unpackhi_epi16(o, o), 16));
+
+		_mm_storeu_si128((__m128i *) (out + x), _mm_packs_epi32(lo, hi));
+	}
+
+	mix_unmix_range(out, mix, own, own_end, x, own_end);
+	x = own_end;
+
+	for (; x + 8 <= samples; x += 8) {
+		__m128i lo = _mm_loadu_si128((const __m128i *) (mix + x));
+		__m128i hi = _mm_loadu_si128((const __m128i *) (mix + x + 4));
+
+		_mm_storeu_si128((__m128i *) (out + x), _mm_packs_epi32(lo, hi));
+	}
+
+	mix_unmix_range(out, mix, NULL, 0, x, samples);
+}
+
+__attribute__((target("avx2")))
+static void mix_accumulate_avx2(int32_t *mix, const int16_t *data, uint32_t samples)
+{
+	uint32_t x = 0;
+
+	for (; x + 16 <= samples; x += 16) {
+		__m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (data + x)));
+		__m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (data + x + 8)));
+
+		_mm256_storeu_si256((__m256i *) (mix + x), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (mix + x)), lo));
+		_mm256_storeu_si256((__m256i *) (mix + x + 8), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) (mix + x + 8)), hi));
+	}
+
+	mix_accumulate_scalar(mix + x, data + x, samples - x);
+}
+
+__attribute__((target("avx2")))
+static __m128i mix_pack_avx2(__m256i v)
+{
+	return _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+__attribute__((target("avx2")))
+static void mix_unmix_avx2(int16_t *out, const int32_t *mix, const int16_t *own, uint32_t own_samples, uint32_t samples)
+{
+	uint32_t x = 0, own_end = own ? (own_samples < samples ? own_samples : samples) : 0;
+
+	for (; x + 8 <= own_end; x += 8) {
+		__m256i o = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (own + x)));
+		__m256i r = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *) (mix + x)), o);
+
+		_mm_storeu_si128((__m128i *) (out + x), mix_pack_avx2(r));
+	}
+
+	mix_unmix_range(out, mix, own, own_end, x, own_end);
+	x = own_end;
+
+	for (; x + 8 <= samples; x += 8) {
+		_mm_storeu_si128((__m128i *) (out + x), mix_pack_avx2(_mm256_loadu_si256((const __m256i *) (mix + x))));
+	}
+
+	mix_unmix_range(out, mix, NULL, 0, x, samples);
+}
+#endif
+
+static const mix_kernel_t mix_kernels[] = {
+#ifdef SWITCH_MIX_X86
+	{ "avx2", mix_accumulate_avx2, mix_unmix_avx2 },
+	{ "sse2", mix_accumulate_sse2, mix_unmix_sse2 },
+#endif
+	{ "scalar", mix_accumulate_scalar, mix_unmix_scalar }
+};
+
+static const mix_kernel_t *mix_kernel = NULL;
+
+static switch_bool_t mix_kernel_supported(const mix_kernel_t *kernel)
+{
+#ifdef SWITCH_MIX_X86
+	__builtin_cpu_init();
+
+	if (!strcmp(kernel->name, "avx2")) {
+		return __builtin_cpu_supports("avx2") ? SWITCH_TRUE : SWITCH_FALSE;
+	}
+
+	if (!strcmp(kernel->name, "sse2")) {
+		return __builtin_cpu_supports("sse2") ? SWITCH_TRUE : SWITCH_FALSE;
+	}
+#endif
+
+	return SWITCH_TRUE;
+}
+
+SWITCH_DECLARE(const char *) switch_mix_sln_kernel(const char *name)
+{
+	const mix_kernel_t *pick = NULL;
+	size_t i;
+
+	for (i = 0; i < sizeof(mix_kernels) / sizeof(mix_kernels[0]); i++) {
+		if ((!name || !strcasecmp(name, mix_kernels[i].name)) && mix_kernel_supported(&mix_kernels[i])) {
+			pick = &mix_kernels[i];
+			break;
+		}
+	}
+
+	if (!pick) {
+		/* keep a usable kernel installed, but report that the requested one is not available */
+		if (!mix_kernel) {
+			switch_mix_sln_kernel(NULL);
+		}
+		return NULL;
+	}
+
+	mix_kernel = pick;
+
+	return pick->name;
+}
+
+SWITCH_DECLARE(void) switch_mix_sln_accumulate(int32_t *mix, const int16_t *data, uint32_t samples)
+{
+	if (!mix_kernel) {
+		switch_mix_sln_kernel(NULL);
+	}
+
+	mix_kernel->accumulate(mix, data, samples);
+}
+
+SWITCH_DECLARE(void) switch_mix_sln_unmix(int16_t *out, const int32_t *mix, const int16_t *own, uint32_t own_samples, uint32_t samples)
+{
+	if (!mix_kernel) {
+		switch_mix_sln_kernel(NULL);
+	}
+
+	mix_kernel->unmix(out, mix, own, own ? own_samples : 0, samples);
+}
+
 SWITCH_DECLARE(void) switch_mux_channels(int16_t *data, switch_size_t samples, uint32_t orig_channels, uint32_t channels)
 {
 	switch_size_t i = 0;
@@ -55,6 +55,10 @@
 #include <srtp_priv.h>
 #include <switch_ssl.h>
 #include <switch_jitterbuffer.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#define RTP_REACTOR 1
+#endif
 
 #define JITTER_LEAD_FRAMES 10
 #define READ_INC(rtp_session) switch_mutex_lock(rtp_session->read_mutex); rtp_session->reading++
@@ -117,6 +121,101 @@ typedef struct {
 
 #define RTP_BODY(_s) (char *) (_s->recv_msg.ebody ? _s->recv_msg.ebody : _s->recv_msg.body)
 
+/* retransmission cache for NACK / RTX (RFC 4588), indexed by seq */
+#define RTX_CACHE_SIZE 256
+#define RTX_CACHE_PACKET_LEN 1500
+#define RTX_CACHE_MAX_AGE 1000000
+
+typedef struct {
+	uint16_t seq;
+	uint16_t len;
+	uint8_t resent;
+	switch_time_t sent;
+	char data[RTX_CACHE_PACKET_LEN];
+} rtx_cache_slot_t;
+
+typedef struct {
+	rtx_cache_slot_t slots[RTX_CACHE_SIZE];
+} rtx_cache_t;
+
+/* batched socket io (SWITCH_RTP_FLAG_BATCH_IO) */
+#define RTP_BATCH_LEN 8
+#define RTP_BATCH_BUF_LEN 2048
+
+typedef struct {
+	switch_sockmsg_t msgs[RTP_BATCH_LEN];
+	int count;
+	int pos;
+	uint32_t ts;
+} rtp_batch_t;
+
+/* video pacing: finished packets wait here and a per session thread releases them at the media rate */
+#define RTP_PACER_LEN 256
+#define RTP_PACER_BUF_LEN 1500
+#define RTP_PACER_FACTOR 2			/* drain at twice the bitrate so a key frame clears within a frame or two */
+#define RTP_PACER_BURST 3000		/* bytes allowed out back to back */
+#define RTP_PACER_MAX_DELAY 100000	/* never hold a packet longer than this */
+#define RTP_PACER_DEFAULT_KBPS 1024
+
+typedef struct {
+	char data[RTP_PACER_BUF_LEN];
+	switch_size_t len;
+	switch_time_t queued;
+} rtp_pacer_packet_t;
+
+typedef struct {
+	rtp_pacer_packet_t packets[RTP_PACER_LEN];
+	uint32_t head;
+	uint32_t tail;
+	uint32_t kbps;
+	double tokens;
+	switch_time_t last_fill;
+	int running;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	switch_thread_t *thread;
+} rtp_pacer_t;
+
+/* shared reactor: a few epoll threads own the rtp sockets and queue raw datagrams per session */
+#define RTP_RING_LEN 16
+#define RTP_RING_BUF_LEN 1500
+#define RTP_REACTOR_MAX_THREADS 64
+#define RTP_REACTOR_EVENTS 128
+
+struct rtp_reactor_handle_s;
+
+typedef struct {
+	switch_sockmsg_t msgs[RTP_RING_LEN];
+	uint32_t head;
+	uint32_t tail;
+	uint32_t dropped;
+	uint32_t syscalls;
+	switch_socket_t *sock;
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	struct rtp_reactor_handle_s *handle;
+} rtp_ring_t;
+
+typedef struct rtp_reactor_handle_s {
+	rtp_ring_t *ring;
+	int idx;
+	int dead;
+	struct rtp_reactor_handle_s *next;
+} rtp_reactor_handle_t;
+
+static struct {
+	uint32_t threads;
+	uint32_t running;
+	uint32_t next;
+	int shutdown;
+	int epfd[RTP_REACTOR_MAX_THREADS];
+	switch_thread_t *thread[RTP_REACTOR_MAX_THREADS];
+	switch_mutex_t *mutex[RTP_REACTOR_MAX_THREADS];
+	rtp_reactor_handle_t *graveyard[RTP_REACTOR_MAX_THREADS];
+	switch_mutex_t *init_mutex;
+	switch_memory_pool_t *pool;
+} rtp_reactor;
+
 typedef struct {
 	uint32_t ssrc;
 	uint8_t seq;
@@ -321,6 +420,7 @@ struct switch_rtp {
 	uint32_t cur_tmmbr;
 	uint32_t tmmbr;
 	uint32_t tmmbn;
+	uint32_t remote_bitrate;
 
 	ts_normalize_t ts_norm;
 	switch_sockaddr_t *remote_addr, *rtcp_remote_addr;
@@ -413,7 +513,12 @@ struct switch_rtp {
 	uint8_t cn;
 	switch_jb_t *jb;
 	switch_jb_t *vb;
-	switch_jb_t *vbw;
+	rtx_cache_t *rtx_cache;
+	switch_payload_t rtx_pt;
+	switch_payload_t rtx_apt;
+	uint32_t rtx_ssrc;
+	uint16_t rtx_seq;
+	uint32_t rtx_media_ssrc;
 	uint32_t max_missed_packets;
 	uint32_t missed_count;
 	rtp_msg_t write_msg;
@@ -430,38 +535,670 @@ struct switch_rtp {
 	uint32_t bad_stream;
 	uint32_t recovering_stream;
 
-	uint32_t hot_hits;
-	uint32_t sync_packets;
-	int rtcp_interval;
-	int rtcp_sent_packets;
-	switch_bool_t rtcp_fresh_frame;
+	uint32_t hot_hits;
+	uint32_t sync_packets;
+	int rtcp_interval;
+	int rtcp_sent_packets;
+	switch_bool_t rtcp_fresh_frame;
+
+	switch_time_t send_time;
+	switch_byte_t auto_adj_used;
+	uint8_t pause_jb;
+	uint16_t last_seq;
+	switch_time_t last_read_time;
+	switch_size_t last_flush_packet_count;
+	uint32_t interdigit_delay;
+	switch_core_session_t *session;
+	payload_map_t **pmaps;
+	payload_map_t *pmap_tail;
+	int ice_adj;
+	uint8_t has_rtp;
+	uint8_t has_rtcp;
+	uint8_t has_ice;
+	uint8_t punts;
+	uint8_t clean;
+	uint32_t last_max_vb_frames;
+	rtp_batch_t *rbatch;
+	rtp_batch_t *wbatch;
+	rtp_ring_t *ring;
+	rtp_pacer_t *pacer;
+#ifdef ENABLE_ZRTP
+	zrtp_session_t *zrtp_session;
+	zrtp_profile_t *zrtp_profile;
+	zrtp_stream_t *zrtp_stream;
+	int zrtp_mitm_tries;
+	int zinit;
+#endif
+
+};
+
+static void rtx_cache_reset(switch_rtp_t *rtp_session)
+{
+	int i;
+
+	if (!rtp_session->rtx_cache) {
+		return;
+	}
+
+	for (i = 0; i < RTX_CACHE_SIZE; i++) {
+		rtp_session->rtx_cache->slots[i].len = 0;
+	}
+}
+
+/* called with the write mutex held, before the packet is encrypted */
+static void rtx_cache_put(switch_rtp_t *rtp_session, rtp_msg_t *msg, switch_size_t bytes)
+{
+	rtx_cache_slot_t *slot;
+
+	if (bytes > RTX_CACHE_PACKET_LEN) {
+		return;
+	}
+
+	if (!rtp_session->rtx_cache) {
+		rtp_session->rtx_cache = switch_core_alloc(rtp_session->pool, sizeof(*rtp_session->rtx_cache));
+	}
+
+	slot = &rtp_session->rtx_cache->slots[ntohs(msg->header.seq) % RTX_CACHE_SIZE];
+	slot->seq = msg->header.seq;
+	slot->len = (uint16_t) bytes;
+	slot->resent = 0;
+	slot->sent = switch_micro_time_now();
+	memcpy(slot->data, &msg->header, bytes);
+}
+
+static rtx_cache_slot_t *rtx_cache_find(switch_rtp_t *rtp_session, uint16_t seq)
+{
+	rtx_cache_slot_t *slot;
+
+	if (!rtp_session->rtx_cache) {
+		return NULL;
+	}
+
+	slot = &rtp_session->rtx_cache->slots[ntohs(seq) % RTX_CACHE_SIZE];
+
+	if (!slot->len || slot->seq != seq || switch_micro_time_now() - slot->sent > RTX_CACHE_MAX_AGE) {
+		return NULL;
+	}
+
+	return slot;
+}
+
+/* called with the write mutex and the pacer mutex held */
+static void rtp_pacer_send_one(switch_rtp_t *rtp_session, switch_time_t now)
+{
+	rtp_pacer_t *pacer = rtp_session->pacer;
+	rtp_pacer_packet_t *pkt = &pacer->packets[pacer->tail % RTP_PACER_LEN];
+	switch_size_t bytes = pkt->len;
+	switch_size_t delay = (switch_size_t) (now - pkt->queued);
+
+	if (rtp_session->sock_output && rtp_session->remote_addr) {
+		switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, (void *) pkt->data, &bytes);
+		rtp_session->stats.outbound.syscall_count++;
+	}
+
+	/* forced sends (too old or ring full) would otherwise run up a debt that stalls every frame after them */
+	pacer->tokens -= (double) pkt->len;
+	if (pacer->tokens < -RTP_PACER_BURST) {
+		pacer->tokens = -RTP_PACER_BURST;
+	}
+	pacer->tail++;
+
+	rtp_session->stats.outbound.paced_packet_count++;
+	rtp_session->stats.outbound.pacing_delay_total += delay;
+
+	if (delay > rtp_session->stats.outbound.pacing_delay_max) {
+		rtp_session->stats.outbound.pacing_delay_max = delay;
+	}
+}
+
+static double rtp_pacer_bytes_per_usec(switch_rtp_t *rtp_session)
+{
+	uint32_t kbps = rtp_session->pacer->kbps;
+
+	/* follow the receiver when it asked for less than we negotiated */
+	if (rtp_session->remote_bitrate && rtp_session->remote_bitrate / 1000 < kbps) {
+		kbps = rtp_session->remote_bitrate / 1000;
+	}
+
+	if (kbps < 64) {
+		kbps = 64;
+	}
+
+	return (double) kbps * RTP_PACER_FACTOR / 8000.0;
+}
+
+static void *SWITCH_THREAD_FUNC rtp_pacer_thread(switch_thread_t *thread, void *obj)
+{
+	switch_rtp_t *rtp_session = (switch_rtp_t *) obj;
+	rtp_pacer_t *pacer = rtp_session->pacer;
+
+	while (pacer->running) {
+		switch_time_t now;
+		switch_interval_time_t wait = 0;
+		double rate;
+
+		switch_mutex_lock(rtp_session->write_mutex);
+		switch_mutex_lock(pacer->mutex);
+
+		now = switch_micro_time_now();
+		rate = rtp_pacer_bytes_per_usec(rtp_session);
+
+		pacer->tokens += (double) (now - pacer->last_fill) * rate;
+		if (pacer->tokens > RTP_PACER_BURST) {
+			pacer->tokens = RTP_PACER_BURST;
+		}
+		pacer->last_fill = now;
+
+		while (pacer->tail != pacer->head) {
+			rtp_pacer_packet_t *pkt = &pacer->packets[pacer->tail % RTP_PACER_LEN];
+
+			if (pacer->tokens < (double) pkt->len && now - pkt->queued < RTP_PACER_MAX_DELAY) {
+				wait = (switch_interval_time_t) (((double) pkt->len - pacer->tokens) / rate);
+				if (wait > RTP_PACER_MAX_DELAY - (now - pkt->queued)) {
+					wait = RTP_PACER_MAX_DELAY - (now - pkt->queued);
+				}
+				break;
+			}
+
+			rtp_pacer_send_one(rtp_session, now);
+		}
+
+		switch_mutex_unlock(rtp_session->write_mutex);
+
+		if (pacer->tail == pacer->head && pacer->running) {
+			switch_thread_cond_timedwait(pacer->cond, pacer->mutex, RTP_PACER_MAX_DELAY);
+			pacer->last_fill = switch_micro_time_now();
+			switch_mutex_unlock(pacer->mutex);
+		} else {
+			switch_mutex_unlock(pacer->mutex);
+
+			if (wait < 1000) {
+				wait = 1000;
+			}
+
+			switch_yield(wait);
+		}
+	}
+
+	return NULL;
+}
+
+/* called with the write mutex held, the packet is final and only waits for its turn on the wire */
+static void rtp_pacer_push(switch_rtp_t *rtp_session, rtp_msg_t *send_msg, switch_size_t bytes)
+{
+	rtp_pacer_t *pacer = rtp_session->pacer;
+	rtp_pacer_packet_t *pkt;
+	switch_time_t now = switch_micro_time_now();
+	uint32_t depth;
+
+	switch_mutex_lock(pacer->mutex);
+
+	if (pacer->head - pacer->tail == RTP_PACER_LEN) {
+		rtp_pacer_send_one(rtp_session, now);
+	}
+
+	pkt = &pacer->packets[pacer->head % RTP_PACER_LEN];
+	memcpy(pkt->data, (void *) send_msg, bytes);
+	pkt->len = bytes;
+	pkt->queued = now;
+	pacer->head++;
+
+	depth = pacer->head - pacer->tail;
+	if (depth > rtp_session->stats.outbound.pacing_queue_max) {
+		rtp_session->stats.outbound.pacing_queue_max = depth;
+	}
+
+	switch_thread_cond_signal(pacer->cond);
+	switch_mutex_unlock(pacer->mutex);
+}
+
+static void rtp_pacer_stop(switch_rtp_t *rtp_session)
+{
+	rtp_pacer_t *pacer = rtp_session->pacer;
+	switch_status_t st;
+
+	if (!pacer || !pacer->thread) {
+		return;
+	}
+
+	switch_mutex_lock(pacer->mutex);
+	pacer->running = 0;
+	switch_thread_cond_signal(pacer->cond);
+	switch_mutex_unlock(pacer->mutex);
+
+	switch_thread_join(&st, pacer->thread);
+	pacer->thread = NULL;
+}
+
+static rtp_batch_t *rtp_batch_create(switch_memory_pool_t *pool, switch_bool_t with_from)
+{
+	rtp_batch_t *batch;
+	int i;
+
+	batch = switch_core_alloc(pool, sizeof(*batch));
+
+	for (i = 0; i < RTP_BATCH_LEN; i++) {
+		batch->msgs[i].buf = switch_core_alloc(pool, RTP_BATCH_BUF_LEN);
+		batch->msgs[i].len = RTP_BATCH_BUF_LEN;
+
+		if (with_from) {
+			switch_sockaddr_create(&batch->msgs[i].from, pool);
+		}
+	}
+
+	return batch;
+}
+
+#ifdef RTP_REACTOR
+static void rtp_ring_fill(rtp_ring_t *ring, int fd)
+{
+	uint32_t start, pos;
+	int i, count;
+
+	switch_mutex_lock(ring->mutex);
+
+	start = ring->head;
+	pos = ring->head % RTP_RING_LEN;
+	count = RTP_RING_LEN - (int) (ring->head - ring->tail);
+
+	if (count > RTP_RING_LEN - (int) pos) {
+		count = RTP_RING_LEN - (int) pos;
+	}
+
+	if (count > 0) {
+		for (i = 0; i < count; i++) {
+			ring->msgs[pos + i].len = RTP_RING_BUF_LEN;
+		}
+
+		/* level triggered, so one call per wakeup is enough; whatever is left wakes us again */
+		if (switch_socket_recvmmsg(ring->sock, &ring->msgs[pos], &count) == SWITCH_STATUS_SUCCESS) {
+			ring->head += count;
+		}
+		ring->syscalls++;
+	} else {
+		char junk[RTP_RING_BUF_LEN];
+
+		/* the session is not keeping up, make room at the socket rather than spin on it */
+		if (recv(fd, junk, sizeof(junk), MSG_DONTWAIT) >= 0) {
+			ring->dropped++;
+		}
+	}
+
+	if (ring->head != start) {
+		switch_thread_cond_signal(ring->cond);
+	}
+
+	switch_mutex_unlock(ring->mutex);
+}
+
+static void *SWITCH_THREAD_FUNC rtp_reactor_thread(switch_thread_t *thread, void *obj)
+{
+	int idx = (int) (intptr_t) obj;
+	struct epoll_event events[RTP_REACTOR_EVENTS];
+
+	while (!rtp_reactor.shutdown) {
+		rtp_reactor_handle_t *handle;
+		int i, n;
+
+		n = epoll_wait(rtp_reactor.epfd[idx], events, RTP_REACTOR_EVENTS, 100);
+
+		switch_mutex_lock(rtp_reactor.mutex[idx]);
+
+		for (i = 0; i < n; i++) {
+			handle = (rtp_reactor_handle_t *) events[i].data.ptr;
+
+			if (!handle->dead) {
+				rtp_ring_fill(handle->ring, switch_socket_fd_get(handle->ring->sock));
+			}
+		}
+
+		/* nothing can refer to a removed handle once the events from this wait are processed */
+		while ((handle = rtp_reactor.graveyard[idx])) {
+			rtp_reactor.graveyard[idx] = handle->next;
+			free(handle);
+		}
+
+		switch_mutex_unlock(rtp_reactor.mutex[idx]);
+	}
+
+	return NULL;
+}
+
+static switch_status_t rtp_reactor_start(void)
+{
+	switch_threadattr_t *thd_attr = NULL;
+	uint32_t x;
+
+	if (rtp_reactor.running) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	if (!rtp_reactor.threads || !rtp_reactor.init_mutex) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	switch_mutex_lock(rtp_reactor.init_mutex);
+
+	if (rtp_reactor.running) {
+		switch_mutex_unlock(rtp_reactor.init_mutex);
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	for (x = 0; x < rtp_reactor.threads; x++) {
+		if ((rtp_reactor.epfd[x] = epoll_create(1024)) < 0) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "RTP reactor epoll_create failed: %s\n", strerror(errno));
+			break;
+		}
+
+		switch_mutex_init(&rtp_reactor.mutex[x], SWITCH_MUTEX_NESTED, rtp_reactor.pool);
+		switch_threadattr_create(&thd_attr, rtp_reactor.pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
+		switch_thread_create(&rtp_reactor.thread[x], thd_attr, rtp_reactor_thread, (void *) (intptr_t) x, rtp_reactor.pool);
+	}
+
+	rtp_reactor.running = x;
+
+	switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "Started %u RTP reactor thread(s)\n", rtp_reactor.running);
+
+	switch_mutex_unlock(rtp_reactor.init_mutex);
+
+	return rtp_reactor.running ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_FALSE;
+}
+
+static void rtp_reactor_stop(void)
+{
+	switch_status_t st;
+	uint32_t x;
+
+	if (!rtp_reactor.running) {
+		return;
+	}
+
+	rtp_reactor.shutdown = 1;
+
+	for (x = 0; x < rtp_reactor.running; x++) {
+		rtp_reactor_handle_t *handle;
+
+		switch_thread_join(&st, rtp_reactor.thread[x]);
+		close(rtp_reactor.epfd[x]);
+
+		/* removed after the thread's last sweep */
+		while ((handle = rtp_reactor.graveyard[x])) {
+			rtp_reactor.graveyard[x] = handle->next;
+			free(handle);
+		}
+	}
+
+	rtp_reactor.running = 0;
+}
+
+static void rtp_reactor_add(switch_rtp_t *rtp_session)
+{
+	rtp_reactor_handle_t *handle;
+	rtp_ring_t *ring;
+	struct epoll_event ev = { 0 };
+	int idx, fd;
+
+	/* video frames are bigger than a ring slot and are read in bursts anyway */
+	if (!rtp_reactor.threads || rtp_session->flags[SWITCH_RTP_FLAG_VIDEO] || !rtp_session->sock_input) {
+		return;
+	}
+
+	if (rtp_reactor_start() != SWITCH_STATUS_SUCCESS) {
+		return;
+	}
+
+	if (!(ring = rtp_session->ring)) {
+		int i;
+
+		ring = switch_core_alloc(rtp_session->pool, sizeof(*ring));
+
+		for (i = 0; i < RTP_RING_LEN; i++) {
+			ring->msgs[i].buf = switch_core_alloc(rtp_session->pool, RTP_RING_BUF_LEN);
+			switch_sockaddr_create(&ring->msgs[i].from, rtp_session->pool);
+		}
+
+		switch_mutex_init(&ring->mutex, SWITCH_MUTEX_NESTED, rtp_session->pool);
+		switch_thread_cond_create(&ring->cond, rtp_session->pool);
+		rtp_session->ring = ring;
+	}
+
+	switch_zmalloc(handle, sizeof(*handle));
+	handle->ring = ring;
+
+	switch_mutex_lock(rtp_reactor.init_mutex);
+	idx = rtp_reactor.next++ % rtp_reactor.running;
+	switch_mutex_unlock(rtp_reactor.init_mutex);
+	handle->idx = idx;
+
+	switch_mutex_lock(ring->mutex);
+	ring->head = ring->tail = 0;
+	ring->sock = rtp_session->sock_input;
+	ring->handle = handle;
+	switch_mutex_unlock(ring->mutex);
+
+	fd = switch_socket_fd_get(rtp_session->sock_input);
+	ev.events = EPOLLIN;
+	ev.data.ptr = handle;
+
+	if (epoll_ctl(rtp_reactor.epfd[idx], EPOLL_CTL_ADD, fd, &ev) < 0) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_WARNING, 
+						  "%s cannot add socket to RTP reactor: %s\n", rtp_session_name(rtp_session), strerror(errno));
+		ring->handle = NULL;
+		free(handle);
+	}
+}
+
+static void rtp_reactor_del(switch_rtp_t *rtp_session)
+{
+	rtp_ring_t *ring = rtp_session->ring;
+	rtp_reactor_handle_t *handle;
+	int idx;
+
+	if (!ring || !(handle = ring->handle)) {
+		return;
+	}
+
+	idx = handle->idx;
+
+	switch_mutex_lock(rtp_reactor.mutex[idx]);
+	epoll_ctl(rtp_reactor.epfd[idx], EPOLL_CTL_DEL, switch_socket_fd_get(ring->sock), NULL);
+	handle->dead = 1;
+	handle->next = rtp_reactor.graveyard[idx];
+	rtp_reactor.graveyard[idx] = handle;
+	switch_mutex_unlock(rtp_reactor.mutex[idx]);
+
+	switch_mutex_lock(ring->mutex);
+	ring->handle = NULL;
+	rtp_session->stats.inbound.syscall_count += ring->syscalls;
+
+	if (ring->dropped) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG, 
+						  "%s RTP reactor dropped %u packet(s) the session did not read in time\n", rtp_session_name(rtp_session), ring->dropped);
+	}
+
+	ring->syscalls = ring->dropped = 0;
+	switch_thread_cond_broadcast(ring->cond);
+	switch_mutex_unlock(ring->mutex);
+}
+
+static switch_status_t rtp_ring_recvfrom(switch_rtp_t *rtp_session, switch_size_t *bytes)
+{
+	rtp_ring_t *ring = rtp_session->ring;
+	switch_status_t status = SWITCH_STATUS_BREAK;
+
+	*bytes = 0;
+
+	switch_mutex_lock(ring->mutex);
+
+	if (ring->tail != ring->head) {
+		switch_sockmsg_t *msg = &ring->msgs[ring->tail % RTP_RING_LEN];
+
+		if (!msg->truncated && msg->len <= sizeof(rtp_msg_t)) {
+			memcpy((void *) &rtp_session->recv_msg, msg->buf, msg->len);
+			switch_cp_addr(rtp_session->from_addr, msg->from);
+			*bytes = msg->len;
+		}
+
+		ring->tail++;
+		status = SWITCH_STATUS_SUCCESS;
+	}
+
+	switch_mutex_unlock(ring->mutex);
+
+	return status;
+}
+
+static switch_status_t rtp_ring_wait(rtp_ring_t *ring, switch_interval_time_t timeout)
+{
+	switch_status_t status;
+
+	switch_mutex_lock(ring->mutex);
+
+	if (ring->tail == ring->head && timeout > 0 && ring->handle) {
+		switch_thread_cond_timedwait(ring->cond, ring->mutex, timeout);
+	}
+
+	status = ring->tail != ring->head ? SWITCH_STATUS_SUCCESS : SWITCH_STATUS_TIMEOUT;
+
+	switch_mutex_unlock(ring->mutex);
+
+	return status;
+}
+
+#define rtp_ring_active(_rtp_session) (_rtp_session->ring && _rtp_session->ring->handle)
+#else
+#define rtp_reactor_add(_rtp_session)
+#define rtp_reactor_del(_rtp_session)
+#define rtp_reactor_stop()
+#define rtp_ring_active(_rtp_session) 0
+#define rtp_ring_recvfrom(_rtp_session, _bytes) SWITCH_STATUS_FALSE
+#define rtp_ring_wait(_ring, _timeout) SWITCH_STATUS_FALSE
+#endif
+
+static switch_status_t rtp_read_poll(switch_rtp_t *rtp_session, int *fdr, switch_interval_time_t timeout)
+{
+	/* packets already pulled off the socket by the last recvmmsg count as readable */
+	if (rtp_session->rbatch && rtp_session->rbatch->pos < rtp_session->rbatch->count) {
+		*fdr = 1;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	/* the reactor owns the socket, wait for it to hand us something */
+	if (rtp_ring_active(rtp_session)) {
+		switch_status_t status = rtp_ring_wait(rtp_session->ring, timeout);
+		*fdr = status == SWITCH_STATUS_SUCCESS ? 1 : 0;
+		return status;
+	}
+
+	return switch_poll(rtp_session->read_pollfd, 1, fdr, timeout);
+}
+
+static switch_status_t rtp_batch_recvfrom(switch_rtp_t *rtp_session, switch_size_t *bytes)
+{
+	rtp_batch_t *batch = rtp_session->rbatch;
+	switch_sockmsg_t *msg;
+
+	if (batch->pos >= batch->count) {
+		switch_status_t status;
+		int i, count = RTP_BATCH_LEN;
+
+		for (i = 0; i < RTP_BATCH_LEN; i++) {
+			batch->msgs[i].len = RTP_BATCH_BUF_LEN;
+		}
+
+		batch->pos = batch->count = 0;
+		status = switch_socket_recvmmsg(rtp_session->sock_input, batch->msgs, &count);
+		rtp_session->stats.inbound.syscall_count++;
+
+		if (status != SWITCH_STATUS_SUCCESS || !count) {
+			*bytes = 0;
+			return status;
+		}
+
+		batch->count = count;
+	}
+
+	msg = &batch->msgs[batch->pos++];
+
+	if (msg->truncated || msg->len > sizeof(rtp_msg_t)) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG, 
+						  "%s dropping oversized packet in batch mode\n", rtp_session_name(rtp_session));
+		*bytes = 0;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	memcpy((void *) &rtp_session->recv_msg, msg->buf, msg->len);
+	switch_cp_addr(rtp_session->from_addr, msg->from);
+	*bytes = msg->len;
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
+/* rollback gives back the sequence numbers of unsent packets, only valid when the batch ends with the newest packet */
+static switch_status_t rtp_batch_flush(switch_rtp_t *rtp_session, switch_bool_t rollback)
+{
+	rtp_batch_t *batch = rtp_session->wbatch;
+	switch_status_t status;
+	int count;
+
+	if (!batch || !batch->count) {
+		return SWITCH_STATUS_SUCCESS;
+	}
+
+	count = batch->count;
+	status = switch_socket_sendmmsg(rtp_session->sock_output, rtp_session->remote_addr, batch->msgs, &count);
+	rtp_session->stats.outbound.syscall_count++;
+
+	if (count < batch->count) {
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG, 
+						  "%s only sent %d of %d batched packets\n", rtp_session_name(rtp_session), count, batch->count);
+
+		if (rollback) {
+			rtp_session->seq -= (uint16_t) (batch->count - count);
+		}
+	}
+
+	batch->count = 0;
+
+	return status;
+}
+
+static switch_status_t rtp_batch_sendto(switch_rtp_t *rtp_session, rtp_msg_t *send_msg, switch_size_t bytes)
+{
+	rtp_batch_t *batch = rtp_session->wbatch;
+	uint32_t ts = ntohl(send_msg->header.ts);
 
-	switch_time_t send_time;
-	switch_byte_t auto_adj_used;
-	uint8_t pause_jb;
-	uint16_t last_seq;
-	switch_time_t last_read_time;
-	switch_size_t last_flush_packet_count;
-	uint32_t interdigit_delay;
-	switch_core_session_t *session;
-	payload_map_t **pmaps;
-	payload_map_t *pmap_tail;
-	int ice_adj;
-	uint8_t has_rtp;
-	uint8_t has_rtcp;
-	uint8_t has_ice;
-	uint8_t punts;
-	uint8_t clean;
-	uint32_t last_max_vb_frames;
-#ifdef ENABLE_ZRTP
-	zrtp_session_t *zrtp_session;
-	zrtp_profile_t *zrtp_profile;
-	zrtp_stream_t *zrtp_stream;
-	int zrtp_mitm_tries;
-	int zinit;
-#endif
+	/* a batch never spans more than one frame */
+	if (batch->count && batch->ts != ts) {
+		rtp_batch_flush(rtp_session, SWITCH_FALSE);
+	}
 
-};
+	if (bytes > RTP_BATCH_BUF_LEN) {
+		switch_status_t status;
+
+		rtp_batch_flush(rtp_session, SWITCH_FALSE);
+		rtp_session->stats.outbound.syscall_count++;
+
+		if ((status = switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, (void *) send_msg, &bytes)) != SWITCH_STATUS_SUCCESS) {
+			rtp_session->seq--;
+		}
+
+		return status;
+	}
+
+	memcpy(batch->msgs[batch->count].buf, (void *) send_msg, bytes);
+	batch->msgs[batch->count].len = bytes;
+	batch->ts = ts;
+	batch->count++;
+
+	if (send_msg->header.m || batch->count == RTP_BATCH_LEN) {
+		return rtp_batch_flush(rtp_session, SWITCH_TRUE);
+	}
+
+	return SWITCH_STATUS_SUCCESS;
+}
 
 struct switch_rtcp_report_block {
 	uint32_t ssrc; /* The SSRC identifier of the source to which the information in this reception report block pertains. */
@@ -1486,6 +2223,10 @@ SWITCH_DECLARE(void) switch_rtp_init(switch_memory_pool_t *pool)
 	srtp_init();
 #endif
 	switch_mutex_init(&port_lock, SWITCH_MUTEX_NESTED, pool);
+#ifdef RTP_REACTOR
+	rtp_reactor.pool = pool;
+	switch_mutex_init(&rtp_reactor.init_mutex, SWITCH_MUTEX_NESTED, pool);
+#endif
 	global_init = 1;
 }
 
@@ -1919,6 +2660,19 @@ static int rtcp_stats(switch_rtp_t *rtp_session)
 	return 1;
 }
 
+/* exp is the top 6 bits of parts[0], the mantissa the next bits of width */
+static uint32_t parse_bw_exp(uint8_t *parts, uint8_t bits)
+{
+	uint8_t exp = parts[0] >> 2;
+	uint64_t mantissa = ((uint32_t)(parts[0] & 0x03) << 16) | ((uint32_t)parts[1] << 8) | parts[2];
+	uint64_t bps;
+
+	mantissa >>= (18 - bits);
+	bps = exp > 32 ? UINT64_MAX : mantissa << exp;
+
+	return bps > UINT32_MAX ? UINT32_MAX : (uint32_t) bps;
+}
+
 static void calc_bw_exp(uint32_t bps, uint8_t bits, rtcp_tmmbx_t *tmmbx)
 {
 	uint32_t mantissa_max, i = 0;
@@ -1954,7 +2708,7 @@ static int using_ice(switch_rtp_t *rtp_session)
 	return 0;
 }
 
-#define MAX_NACK 10
+#define MAX_NACK 32
 static int check_rtcp_and_ice(switch_rtp_t *rtp_session)
 {
 	int ret = 0;
@@ -1986,14 +2740,7 @@ static int check_rtcp_and_ice(switch_rtp_t *rtp_session)
 	rate = rtp_session->rtcp_interval;
 
 	if (rtp_session->flags[SWITCH_RTP_FLAG_NACK] && rtp_session->vb) {
-		int n;
-		for (n = 0; n < MAX_NACK; n++) {
-			uint32_t nack = switch_jb_pop_nack(rtp_session->vb);
-
-			if (!nack) break;
-
-			cur_nack[nack_ttl++] = nack;
-		}
+		nack_ttl = switch_jb_pop_nacks(rtp_session->vb, cur_nack, MAX_NACK);
 	}
 
 
@@ -2095,32 +2842,33 @@ static int check_rtcp_and_ice(switch_rtp_t *rtp_session)
 			}
 
 			if (rtp_session->flags[SWITCH_RTP_FLAG_NACK] && nack_ttl > 0) {
+				switch_rtcp_ext_hdr_t *ext_hdr;
+				uint32_t *nack;
 				int n = 0;
 
+				/* one generic NACK message carrying every pid/blp pair */
+				p = (uint8_t *) (&rtp_session->rtcp_send_msg) + rtcp_bytes;
+				ext_hdr = (switch_rtcp_ext_hdr_t *) p;
+
+				ext_hdr->version = 2;
+				ext_hdr->p = 0;
+				ext_hdr->fmt = _RTCP_RTPFB_NACK;
+				ext_hdr->pt = _RTCP_PT_RTPFB;
+				ext_hdr->send_ssrc = htonl(rtp_session->ssrc);
+				ext_hdr->recv_ssrc = htonl(rtp_session->remote_ssrc);
+				ext_hdr->length = htons((uint16_t)(2 + nack_ttl));
+				p += sizeof(switch_rtcp_ext_hdr_t);
+				nack = (uint32_t *) p;
+
 				for (n = 0; n < nack_ttl; n++) {
-					switch_rtcp_ext_hdr_t *ext_hdr;
-					uint32_t *nack;
-					p = (uint8_t *) (&rtp_session->rtcp_send_msg) + rtcp_bytes;
-					ext_hdr = (switch_rtcp_ext_hdr_t *) p;
-					
-					ext_hdr->version = 2;
-					ext_hdr->p = 0;
-					ext_hdr->fmt = _RTCP_RTPFB_NACK;
-					ext_hdr->pt = _RTCP_PT_RTPFB;
-					ext_hdr->send_ssrc = htonl(rtp_session->ssrc);
-					ext_hdr->recv_ssrc = htonl(rtp_session->remote_ssrc);
-					ext_hdr->length = htons(3);
-					p += sizeof(switch_rtcp_ext_hdr_t);
-					nack = (uint32_t *) p;
-					*nack = cur_nack[n];
-
-					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Sending RTCP NACK %u\n", 
-									  ntohs(*nack & 0xFFFF));
-				
-					rtcp_bytes += sizeof(switch_rtcp_ext_hdr_t) + sizeof(cur_nack[n]);
+					nack[n] = cur_nack[n];
+
+					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Sending RTCP NACK %u blp %04x\n",
+									  ntohs(cur_nack[n] & 0xFFFF), ntohs(cur_nack[n] >> 16));
 					cur_nack[n] = 0;
 				}
 
+				rtcp_bytes += sizeof(switch_rtcp_ext_hdr_t) + nack_ttl * sizeof(cur_nack[0]);
 				nack_ttl = 0;
 			}
 			
@@ -2363,6 +3111,8 @@ SWITCH_DECLARE(void) switch_rtp_shutdown(void)
 	switch_core_hash_destroy(&alloc_hash);
 	switch_mutex_unlock(port_lock);
 
+	rtp_reactor_stop();
+
 #ifdef ENABLE_ZRTP
 	if (zrtp_on) {
 		zrtp_status_t status = zrtp_status_ok;
@@ -2378,6 +3128,23 @@ SWITCH_DECLARE(void) switch_rtp_shutdown(void)
 
 }
 
+SWITCH_DECLARE(uint32_t) switch_rtp_set_reactor_threads(uint32_t threads)
+{
+#ifdef RTP_REACTOR
+	/* only takes effect before the first session starts the reactor */
+	if (!rtp_reactor.running) {
+		if (threads > RTP_REACTOR_MAX_THREADS) {
+			threads = RTP_REACTOR_MAX_THREADS;
+		}
+		rtp_reactor.threads = threads;
+	}
+
+	return rtp_reactor.threads;
+#else
+	return 0;
+#endif
+}
+
 SWITCH_DECLARE(switch_port_t) switch_rtp_set_start_port(switch_port_t port)
 {
 	if (port) {
@@ -2714,6 +3481,8 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_local_address(switch_rtp_t *rtp_s
 
 	switch_socket_create_pollset(&rtp_session->read_pollfd, rtp_session->sock_input, SWITCH_POLLIN | SWITCH_POLLERR, rtp_session->pool);
 
+	rtp_reactor_add(rtp_session);
+
 	if (rtp_session->flags[SWITCH_RTP_FLAG_ENABLE_RTCP]) {
 		if ((status = enable_local_rtcp_socket(rtp_session, err)) == SWITCH_STATUS_SUCCESS) {
 			*err = "Success";
@@ -2775,9 +3544,7 @@ SWITCH_DECLARE(void) switch_rtp_reset_vb(switch_rtp_t *rtp_session)
 		switch_jb_reset(rtp_session->vb);
 	}
 
-	if (rtp_session->vbw) {
-		switch_jb_reset(rtp_session->vbw);
-	}
+	rtx_cache_reset(rtp_session);
 }
 
 SWITCH_DECLARE(void) switch_rtp_reset(switch_rtp_t *rtp_session)
@@ -3246,9 +4013,7 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_del_dtls(switch_rtp_t *rtp_session, d
 			switch_jb_reset(rtp_session->vb);
 		}
 
-		if (rtp_session->vbw) {
-			switch_jb_reset(rtp_session->vbw);
-		}
+		rtx_cache_reset(rtp_session);
 
 	}
 
@@ -3720,6 +4485,10 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_ssrc(switch_rtp_t *rtp_session, u
 	rtp_session->ssrc = ssrc;
 	rtp_session->send_msg.header.ssrc = htonl(rtp_session->ssrc);
 
+	if (rtp_session->rtx_ssrc) {
+		rtp_session->rtx_ssrc = SWITCH_RTP_RTX_SSRC(ssrc);
+	}
+
 	return SWITCH_STATUS_SUCCESS;
 }
 
@@ -3730,6 +4499,18 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_remote_ssrc(switch_rtp_t *rtp_ses
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_DECLARE(void) switch_rtp_set_rtx(switch_rtp_t *rtp_session, switch_payload_t rtx_pt, switch_payload_t apt)
+{
+	switch_mutex_lock(rtp_session->write_mutex);
+	if (rtx_pt && !rtp_session->rtx_ssrc) {
+		rtp_session->rtx_ssrc = SWITCH_RTP_RTX_SSRC(rtp_session->ssrc);
+		rtp_session->rtx_seq = (uint16_t) rand();
+	}
+	rtp_session->rtx_pt = rtx_pt;
+	rtp_session->rtx_apt = apt;
+	switch_mutex_unlock(rtp_session->write_mutex);
+}
+
 SWITCH_DECLARE(switch_status_t) switch_rtp_create(switch_rtp_t **new_rtp_session,
 												  switch_payload_t payload,
 												  uint32_t samples_per_interval,
@@ -3770,6 +4551,15 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_create(switch_rtp_t **new_rtp_session
 
 	switch_rtp_set_flags(rtp_session, flags);
 
+	if (rtp_session->flags[SWITCH_RTP_FLAG_BATCH_IO]) {
+		rtp_session->rbatch = rtp_batch_create(pool, SWITCH_TRUE);
+
+		/* only video writes bursts of packets back to back, audio gains nothing from batching writes */
+		if (rtp_session->flags[SWITCH_RTP_FLAG_VIDEO]) {
+			rtp_session->wbatch = rtp_batch_create(pool, SWITCH_FALSE);
+		}
+	}
+
 	/* for from address on recvfrom calls */
 	switch_sockaddr_create(&rtp_session->from_addr, pool);
 	switch_sockaddr_create(&rtp_session->rtp_from_addr, pool);
@@ -4123,6 +4913,49 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_set_video_buffer_size(switch_rtp_t *r
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_DECLARE(switch_status_t) switch_rtp_set_video_pacing(switch_rtp_t *rtp_session, uint32_t kbps)
+{
+	rtp_pacer_t *pacer;
+	switch_threadattr_t *thd_attr = NULL;
+
+	if (!switch_rtp_ready(rtp_session) || !rtp_session->flags[SWITCH_RTP_FLAG_VIDEO]) {
+		return SWITCH_STATUS_FALSE;
+	}
+
+	if (!kbps) {
+		kbps = RTP_PACER_DEFAULT_KBPS;
+	}
+
+	if ((pacer = rtp_session->pacer)) {
+		switch_mutex_lock(pacer->mutex);
+		pacer->kbps = kbps;
+		switch_mutex_unlock(pacer->mutex);
+	} else {
+		pacer = switch_core_alloc(rtp_session->pool, sizeof(*pacer));
+		pacer->kbps = kbps;
+		pacer->tokens = RTP_PACER_BURST;
+		pacer->last_fill = switch_micro_time_now();
+		pacer->running = 1;
+		switch_mutex_init(&pacer->mutex, SWITCH_MUTEX_NESTED, rtp_session->pool);
+		switch_thread_cond_create(&pacer->cond, rtp_session->pool);
+		rtp_session->pacer = pacer;
+
+		switch_threadattr_create(&thd_attr, rtp_session->pool);
+		switch_threadattr_stacksize_set(thd_attr, SWITCH_THREAD_STACKSIZE);
+		switch_threadattr_priority_set(thd_attr, SWITCH_PRI_REALTIME);
+
+		if (switch_thread_create(&pacer->thread, thd_attr, rtp_pacer_thread, rtp_session, rtp_session->pool) != SWITCH_STATUS_SUCCESS) {
+			pacer->running = 0;
+			pacer->thread = NULL;
+			return SWITCH_STATUS_FALSE;
+		}
+	}
+
+	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Pacing video at %ukbps.\n", kbps);
+
+	return SWITCH_STATUS_SUCCESS;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_rtp_debug_jitter_buffer(switch_rtp_t *rtp_session, const char *name)
 {
 	int x = 0;
@@ -4348,6 +5181,11 @@ SWITCH_DECLARE(switch_status_t) switch_rtp_req_bitrate(switch_rtp_t *rtp_session
 	return SWITCH_STATUS_SUCCESS;
 }
 
+SWITCH_DECLARE(uint32_t) switch_rtp_get_remote_bitrate(switch_rtp_t *rtp_session)
+{
+	return rtp_session ? rtp_session->remote_bitrate : 0;
+}
+
 SWITCH_DECLARE(switch_status_t) switch_rtp_ack_bitrate(switch_rtp_t *rtp_session, uint32_t bps)
 {
 	if (!rtp_write_ready(rtp_session, 0, __LINE__) || rtp_session->tmmbn) {
@@ -4426,6 +5264,7 @@ SWITCH_DECLARE(void) switch_rtp_kill_socket(switch_rtp_t *rtp_session)
 {
 	switch_assert(rtp_session != NULL);
 	switch_mutex_lock(rtp_session->flag_mutex);
+	rtp_reactor_del(rtp_session);
 	if (rtp_session->flags[SWITCH_RTP_FLAG_IO]) {
 		rtp_session->flags[SWITCH_RTP_FLAG_IO] = 0;
 		if (rtp_session->sock_input) {
@@ -4510,6 +5349,8 @@ SWITCH_DECLARE(void) switch_rtp_destroy(switch_rtp_t **rtp_session)
 	READ_DEC((*rtp_session));
 	WRITE_DEC((*rtp_session));
 
+	rtp_pacer_stop(*rtp_session);
+
 	if ((*rtp_session)->flags[SWITCH_RTP_FLAG_VAD]) {
 		switch_rtp_disable_vad(*rtp_session);
 	}
@@ -4534,9 +5375,6 @@ SWITCH_DECLARE(void) switch_rtp_destroy(switch_rtp_t **rtp_session)
 		switch_jb_destroy(&(*rtp_session)->vb);
 	}
 
-	if ((*rtp_session)->vbw) {
-		switch_jb_destroy(&(*rtp_session)->vbw);
-	}
 
 	if ((*rtp_session)->dtls && (*rtp_session)->dtls == (*rtp_session)->rtcp_dtls) {
 		(*rtp_session)->rtcp_dtls = NULL;
@@ -5012,9 +5850,7 @@ static switch_size_t do_flush(switch_rtp_t *rtp_session, int force, switch_size_
 			goto end;
 		}
 
-		if (rtp_session->vbw) {
-			switch_jb_reset(rtp_session->vbw);
-		}
+		rtx_cache_reset(rtp_session);
 
 		if (rtp_session->vb) {
 			//switch_jb_reset(rtp_session->vb);
@@ -5038,7 +5874,15 @@ static switch_size_t do_flush(switch_rtp_t *rtp_session, int force, switch_size_
 		do {
 			if (switch_rtp_ready(rtp_session)) {
 				bytes = sizeof(rtp_msg_t);
-				switch_socket_recvfrom(rtp_session->from_addr, rtp_session->sock_input, 0, (void *) &rtp_session->recv_msg, &bytes);
+
+				if (rtp_ring_active(rtp_session)) {
+					rtp_ring_recvfrom(rtp_session, &bytes);
+				} else if (rtp_session->rbatch) {
+					rtp_batch_recvfrom(rtp_session, &bytes);
+				} else {
+					switch_socket_recvfrom(rtp_session->from_addr, rtp_session->sock_input, 0, (void *) &rtp_session->recv_msg, &bytes);
+					rtp_session->stats.inbound.syscall_count++;
+				}
 				
 				if (bytes) {
 					int do_cng = 0;
@@ -5169,7 +6013,7 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 			}
 		}
 		
-		poll_status = switch_poll(rtp_session->read_pollfd, 1, &fdr, to);
+		poll_status = rtp_read_poll(rtp_session, &fdr, to);
 		
 		if (rtp_session->flags[SWITCH_RTP_FLAG_USE_TIMER] && rtp_session->timer.interval) {
 			switch_core_timer_sync(&rtp_session->timer);
@@ -5195,7 +6039,14 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 	memset(&rtp_session->last_rtp_hdr, 0, sizeof(rtp_session->last_rtp_hdr));
 
 	if (poll_status == SWITCH_STATUS_SUCCESS) {
-		status = switch_socket_recvfrom(rtp_session->from_addr, rtp_session->sock_input, 0, (void *) &rtp_session->recv_msg, bytes);
+		if (rtp_ring_active(rtp_session)) {
+			status = rtp_ring_recvfrom(rtp_session, bytes);
+		} else if (rtp_session->rbatch) {
+			status = rtp_batch_recvfrom(rtp_session, bytes);
+		} else {
+			status = switch_socket_recvfrom(rtp_session->from_addr, rtp_session->sock_input, 0, (void *) &rtp_session->recv_msg, bytes);
+			rtp_session->stats.inbound.syscall_count++;
+		}
 	} else {
 		*bytes = 0;
 	}
@@ -5252,7 +6103,8 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 			rtp_session->last_rtp_hdr = rtp_session->recv_msg.header;
 
 			
-			if (rtp_session->flags[SWITCH_RTP_FLAG_DETECT_SSRC]) {
+			if (rtp_session->flags[SWITCH_RTP_FLAG_DETECT_SSRC] &&
+				!(rtp_session->rtx_pt && rtp_session->last_rtp_hdr.pt == rtp_session->rtx_pt)) {
 				//if (rtp_session->remote_ssrc != rtp_session->stats.rtcp.peer_ssrc && rtp_session->stats.rtcp.peer_ssrc) {
 				//	rtp_session->remote_ssrc = rtp_session->stats.rtcp.peer_ssrc;
 				//}
@@ -5489,6 +6341,7 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 #ifdef ENABLE_SRTP
 			if (rtp_session->flags[SWITCH_RTP_FLAG_SECURE_RECV] && rtp_session->has_rtp && 
 				(check_recv_payload(rtp_session) || 
+				 (rtp_session->rtx_pt && rtp_session->last_rtp_hdr.pt == rtp_session->rtx_pt) ||
 				 rtp_session->last_rtp_hdr.pt == rtp_session->recv_te || 
 				 rtp_session->last_rtp_hdr.pt == rtp_session->cng_pt)) {
 				//if (rtp_session->flags[SWITCH_RTP_FLAG_SECURE_RECV] && (!rtp_session->ice.ice_user || rtp_session->has_rtp)) {
@@ -5557,6 +6410,37 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 		}
 
 
+		if (rtp_session->has_rtp && rtp_session->rtx_pt && *bytes &&
+			!rtp_session->flags[SWITCH_RTP_FLAG_PROXY_MEDIA] && !rtp_session->flags[SWITCH_RTP_FLAG_UDPTL]) {
+			if (rtp_session->recv_msg.header.pt != rtp_session->rtx_pt) {
+				rtp_session->rtx_media_ssrc = rtp_session->recv_msg.header.ssrc;
+			} else {
+				/* RFC 4588: restore the original sequence number, payload type and ssrc */
+				uint8_t *p = (uint8_t *) &rtp_session->recv_msg.header;
+				switch_size_t hlen = 12 + rtp_session->recv_msg.header.cc * 4;
+				uint16_t osn;
+
+				if (rtp_session->recv_msg.header.x && *bytes > hlen + 4) {
+					hlen += 4 + ntohs(*(uint16_t *) (p + hlen + 2)) * 4;
+				}
+
+				if (*bytes <= hlen + 2 || !rtp_session->rtx_media_ssrc) {
+					*bytes = 0;
+					return SWITCH_STATUS_BREAK;
+				}
+
+				memcpy(&osn, p + hlen, 2);
+				memmove(p + hlen, p + hlen + 2, *bytes - hlen - 2);
+				*bytes -= 2;
+
+				rtp_session->recv_msg.header.seq = osn;
+				rtp_session->recv_msg.header.pt = rtp_session->rtx_apt;
+				rtp_session->recv_msg.header.ssrc = rtp_session->rtx_media_ssrc;
+				rtp_session->last_rtp_hdr = rtp_session->recv_msg.header;
+				rtp_session->stats.inbound.rtx_packet_count++;
+			}
+		}
+
 		if (rtp_session->has_rtp) {
 			if (rtp_session->recv_msg.header.cc > 0) { /* Contributing Source Identifiers (4 bytes = sizeof CSRC header)*/
 				rtp_session->recv_msg.ebody = RTP_BODY(rtp_session) + (rtp_session->recv_msg.header.cc * 4);
@@ -5775,74 +6659,138 @@ static switch_status_t read_rtp_packet(switch_rtp_t *rtp_session, switch_size_t
 	return status;
 }
 
-static void handle_nack(switch_rtp_t *rtp_session, uint32_t nack)
+/* resend one packet from the rtx cache, wrapped in RFC 4588 format when an rtx payload was negotiated */
+static switch_status_t rtx_resend(switch_rtp_t *rtp_session, uint16_t seq)
 {
-	switch_size_t bytes = 0;
-	rtp_msg_t send_msg[1] = {{{0}}};
-	uint16_t seq = (uint16_t) (nack & 0xFFFF);
-	uint16_t blp = (uint16_t) (nack >> 16);
-	int i;
-	const char *tx_host = NULL;
-	const char *old_host = NULL;
-	const char *my_host = NULL;
-	char bufa[50], bufb[50], bufc[50];
+	rtx_cache_slot_t *slot;
+	rtp_msg_t send_msg[1];
+	switch_size_t bytes;
+	switch_status_t status = SWITCH_STATUS_FALSE;
+
+	WRITE_INC(rtp_session);
+
+#ifdef ENABLE_ZRTP
+	if (zrtp_on && !rtp_session->flags[SWITCH_RTP_FLAG_PROXY_MEDIA]) {
+		goto end;
+	}
+#endif
+
+	if (!(slot = rtx_cache_find(rtp_session, seq))) {
+		goto end;
+	}
+
+	/* NACKed again, the retransmission got lost too so let the key frame fallback recover */
+	if (slot->resent) {
+		goto end;
+	}
+
+	slot->resent = 1;
+	bytes = slot->len;
+	memcpy(&send_msg->header, slot->data, bytes);
+
+	if (rtp_session->rtx_pt) {
+		uint32_t hlen = 12 + send_msg->header.cc * 4;
+		uint8_t *p = (uint8_t *) &send_msg->header;
+
+		if (send_msg->header.x) {
+			uint16_t ext_len = ntohs(*(uint16_t *) (p + hlen + 2));
+
+			hlen += 4 + ext_len * 4;
+		}
 
-	if (!(rtp_session->flags[SWITCH_RTP_FLAG_NACK] && rtp_session->vbw)) {
-		return;  /* not enabled */
+		if (hlen > bytes || bytes + 2 > sizeof(*send_msg)) {
+			goto end;
+		}
+
+		/* the original sequence number goes in front of the payload */
+		memmove(p + hlen + 2, p + hlen, bytes - hlen);
+		memcpy(p + hlen, &seq, 2);
+		bytes += 2;
+
+		send_msg->header.pt = rtp_session->rtx_pt;
+		send_msg->header.seq = htons(rtp_session->rtx_seq++);
+		send_msg->header.ssrc = htonl(rtp_session->rtx_ssrc);
+	}
+
+#ifdef ENABLE_SRTP
+	if (rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND] && rtp_session->send_ctx[rtp_session->srtp_idx_rtp]) {
+		int sbytes = (int) bytes;
+		err_status_t stat;
+
+		if ((stat = srtp_protect(rtp_session->send_ctx[rtp_session->srtp_idx_rtp], &send_msg->header, &sbytes))) {
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_ERROR,
+							  "Error: %s SRTP protection of retransmission failed with code %d\n", rtp_type(rtp_session), stat);
+			goto end;
+		}
+
+		bytes = sbytes;
 	}
+#endif
 
 	if (rtp_session->flags[SWITCH_RTP_FLAG_DEBUG_RTP_WRITE]) {
+		const char *tx_host;
+		const char *old_host;
+		const char *my_host;
+		char bufa[50], bufb[50], bufc[50];
+
 		tx_host = switch_get_addr(bufa, sizeof(bufa), rtp_session->rtcp_from_addr);
 		old_host = switch_get_addr(bufb, sizeof(bufb), rtp_session->remote_addr);
 		my_host = switch_get_addr(bufc, sizeof(bufc), rtp_session->local_addr);
+
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG_CLEAN(rtp_session->session), SWITCH_LOG_CONSOLE,
+						  "X %s b=%4ld %s:%u %s:%u %s:%u pt=%d ts=%u seq=%u osn=%u m=%d\n",
+						  rtp_session->session ? switch_channel_get_name(switch_core_session_get_channel(rtp_session->session)) : "NoName",
+						  (long) bytes,
+						  my_host, switch_sockaddr_get_port(rtp_session->local_addr),
+						  old_host, rtp_session->remote_port,
+						  tx_host, switch_sockaddr_get_port(rtp_session->rtcp_from_addr),
+						  send_msg->header.pt, ntohl(send_msg->header.ts), ntohs(send_msg->header.seq), ntohs(seq), send_msg->header.m);
 	}
 
-	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Got NACK [%u][0x%x] for seq %u\n", nack, nack, ntohs(seq));
-	
-	if (switch_jb_get_packet_by_seq(rtp_session->vbw, seq, (switch_rtp_packet_t *) send_msg, &bytes) == SWITCH_STATUS_SUCCESS) {
+	status = switch_rtp_write_raw(rtp_session, (void *) send_msg, &bytes, SWITCH_FALSE);
 
-		if (rtp_session->flags[SWITCH_RTP_FLAG_DEBUG_RTP_WRITE]) {
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG_CLEAN(rtp_session->session), SWITCH_LOG_CONSOLE,
-							  "X %s b=%4ld %s:%u %s:%u %s:%u pt=%d ts=%u seq=%u m=%d\n",
-							  rtp_session->session ? switch_channel_get_name(switch_core_session_get_channel(rtp_session->session)) : "NoName",
-							  (long) bytes,
-							  my_host, switch_sockaddr_get_port(rtp_session->local_addr),
-							  old_host, rtp_session->remote_port,
-							  tx_host, switch_sockaddr_get_port(rtp_session->rtcp_from_addr),
-							  send_msg->header.pt, ntohl(send_msg->header.ts), ntohs(send_msg->header.seq), send_msg->header.m);
+ end:
 
-		}
-		//switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG1, "RE----SEND %u\n", ntohs(send_msg->header.seq));
-		switch_rtp_write_raw(rtp_session, (void *) send_msg, &bytes, SWITCH_FALSE);
-	} else {
-		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Cannot send NACK for seq %u\n", ntohs(seq));
+	WRITE_DEC(rtp_session);
+
+	return status;
+}
+
+/* returns the number of requested packets that were no longer in the rtx cache */
+static int handle_nack(switch_rtp_t *rtp_session, uint32_t nack)
+{
+	uint16_t seq = (uint16_t) (nack & 0xFFFF);
+	uint16_t blp = (uint16_t) (nack >> 16);
+	int i, missed = 0;
+
+	if (!rtp_session->flags[SWITCH_RTP_FLAG_NACK]) {
+		return 0;  /* not enabled */
 	}
 
+	switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Got NACK [%u][0x%x] for seq %u\n", nack, nack, ntohs(seq));
+
 	blp = ntohs(blp);
-	for (i = 0; i < 16; i++) {
-		if (blp & (1 << i)) {
-			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Also Got NACK for seq %u\n", ntohs(seq) + i + 1);
-			/* If they are missing more than one, may as well gen a key frame for good measure */
-			switch_core_media_gen_key_frame(rtp_session->session);
-			if (switch_jb_get_packet_by_seq(rtp_session->vbw, htons(ntohs(seq) + i + 1), (switch_rtp_packet_t *) &send_msg, &bytes) == SWITCH_STATUS_SUCCESS) {
-				if (rtp_session->flags[SWITCH_RTP_FLAG_DEBUG_RTP_WRITE]) {
-					switch_log_printf(SWITCH_CHANNEL_SESSION_LOG_CLEAN(rtp_session->session), SWITCH_LOG_CONSOLE,
-									  "X %s b=%4ld %s:%u %s:%u %s:%u pt=%d ts=%u seq=%u m=%d\n",
-									  rtp_session->session ? switch_channel_get_name(switch_core_session_get_channel(rtp_session->session)) : "NoName",
-									  (long) bytes,
-									  my_host, switch_sockaddr_get_port(rtp_session->local_addr),
-									  old_host, rtp_session->remote_port,
-									  tx_host, switch_sockaddr_get_port(rtp_session->rtcp_from_addr),
-									  send_msg->header.pt, ntohl(send_msg->header.ts), ntohs(send_msg->header.seq), send_msg->header.m);
-					
-				}
-				//switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG1, "RE----SEND %u\n", ntohs(send_msg->header.seq));
-				switch_rtp_write_raw(rtp_session, (void *) &send_msg, &bytes, SWITCH_FALSE);
-			} else {
-				switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Cannot send NACK for seq %u\n", ntohs(seq) + i);
-			}
+
+	for (i = -1; i < 16; i++) {
+		uint16_t this_seq;
+
+		if (i > -1 && !(blp & (1 << i))) {
+			continue;
+		}
+
+		this_seq = htons(ntohs(seq) + i + 1);
+		rtp_session->stats.outbound.nack_count++;
+
+		if (rtx_resend(rtp_session, this_seq) == SWITCH_STATUS_SUCCESS) {
+			rtp_session->stats.outbound.rtx_packet_count++;
+		} else {
+			rtp_session->stats.outbound.rtx_miss_count++;
+			missed++;
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Cannot resend NACKed seq %u\n", ntohs(this_seq));
 		}
 	}
+
+	return missed;
 }
 
 static switch_status_t process_rtcp_report(switch_rtp_t *rtp_session, rtcp_msg_t *msg, switch_size_t bytes)
@@ -5862,24 +6810,45 @@ static switch_status_t process_rtcp_report(switch_rtp_t *rtp_session, rtcp_msg_t
 		
 		if (msg->header.type == _RTCP_PT_PSFB && (extp->header.fmt == _RTCP_PSFB_FIR || extp->header.fmt == _RTCP_PSFB_PLI)) {
 			switch_core_media_gen_key_frame(rtp_session->session);
-			if (rtp_session->vbw) {
-				switch_jb_reset(rtp_session->vbw);
-			}
+			rtx_cache_reset(rtp_session);
 		}
 
 		if (msg->header.type == _RTCP_PT_RTPFB && extp->header.fmt == _RTCP_RTPFB_NACK) {
 			uint32_t *nack = (uint32_t *) extp->body;
-			int i;
+			int i, missed = 0;
 			
 			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Got NACK count %d\n", ntohs(extp->header.length) - 2);
 
 
 			for (i = 0; i < ntohs(extp->header.length) - 2; i++) {
-				handle_nack(rtp_session, *nack);
+				missed += handle_nack(rtp_session, *nack);
 				nack++;
 			}
 
-			switch_core_media_gen_key_frame(rtp_session->session);
+			/* only fall back to a key frame when retransmission could not cover the loss */
+			if (missed) {
+				switch_core_media_gen_key_frame(rtp_session->session);
+			}
+		}
+
+		if (msg->header.type == _RTCP_PT_RTPFB && extp->header.fmt == _RTCP_RTPFB_TMMBR && ntohs(extp->header.length) >= 4) {
+			rtcp_tmmbx_t *tmmbx = (rtcp_tmmbx_t *) extp->body;
+
+			rtp_session->remote_bitrate = parse_bw_exp(tmmbx->parts, 17);
+
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Got TMMBR %u\n", rtp_session->remote_bitrate);
+
+			if (rtp_session->flags[SWITCH_RTP_FLAG_TMMBR]) {
+				rtp_session->tmmbn = rtp_session->remote_bitrate;
+			}
+		}
+
+		if (msg->header.type == _RTCP_PT_PSFB && extp->header.fmt == _RTCP_PSFB_AFB &&
+			ntohs(extp->header.length) >= 4 && !memcmp(extp->body, "REMB", 4)) {
+			/* REMB: unique identifier, number of ssrcs, then a 6 bit exponent and 18 bit mantissa */
+			rtp_session->remote_bitrate = parse_bw_exp((uint8_t *) extp->body + 5, 18);
+
+			switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG1, "Got REMB %u\n", rtp_session->remote_bitrate);
 		}
 
 	} else
@@ -6203,7 +7172,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 			rtp_session->read_pollfd) {
 			
 			if (rtp_session->jb && !rtp_session->pause_jb && jb_valid(rtp_session)) {
-				while (switch_poll(rtp_session->read_pollfd, 1, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
+				while (rtp_read_poll(rtp_session, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
 					status = read_rtp_packet(rtp_session, &bytes, flags, SWITCH_STATUS_SUCCESS, SWITCH_FALSE);
 
 					if (status == SWITCH_STATUS_GENERR) {
@@ -6226,7 +7195,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 				
 			} else if ((rtp_session->flags[SWITCH_RTP_FLAG_AUTOFLUSH] || rtp_session->flags[SWITCH_RTP_FLAG_STICKY_FLUSH])) {
 				
-				if (switch_poll(rtp_session->read_pollfd, 1, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
+				if (rtp_read_poll(rtp_session, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
 					status = read_rtp_packet(rtp_session, &bytes, flags, SWITCH_STATUS_SUCCESS, SWITCH_FALSE);
 					if (status == SWITCH_STATUS_GENERR) {
 						ret = -1;
@@ -6245,7 +7214,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 					}
 
 					if (bytes) {
-						if (switch_poll(rtp_session->read_pollfd, 1, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
+						if (rtp_read_poll(rtp_session, &fdr, 0) == SWITCH_STATUS_SUCCESS) {
 							rtp_session->hot_hits++;//+= rtp_session->samples_per_interval;
 							
 							switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(rtp_session->session), SWITCH_LOG_DEBUG10, "%s Hot Hit %d\n", 
@@ -6344,7 +7313,7 @@ static int rtp_common_read(switch_rtp_t *rtp_session, switch_payload_t *payload_
 				pt = 0;
 			}
 			
-			poll_status = switch_poll(rtp_session->read_pollfd, 1, &fdr, pt);
+			poll_status = rtp_read_poll(rtp_session, &fdr, pt);
 
 
 			//if (rtp_session->flags[SWITCH_RTP_FLAG_VIDEO]) {
@@ -7494,6 +8463,10 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 			switch_swap_linear((int16_t *)send_msg->body, (int) datalen);
 		}
 
+		if (rtp_session->flags[SWITCH_RTP_FLAG_NACK]) {
+			rtx_cache_put(rtp_session, send_msg, bytes);
+		}
+
 #ifdef ENABLE_SRTP
 		if (rtp_session->flags[SWITCH_RTP_FLAG_SECURE_SEND]) {
 			int sbytes = (int) bytes;
@@ -7589,16 +8562,6 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 
 		}
 		
-		if (rtp_session->flags[SWITCH_RTP_FLAG_NACK]) {
-			if (!rtp_session->vbw) {
-				switch_jb_create(&rtp_session->vbw, SJB_VIDEO, 30, 30, rtp_session->pool);
-				if (rtp_session->vbw) {
-					switch_jb_set_flag(rtp_session->vbw, SJB_QUEUE_ONLY);
-					//switch_jb_debug_level(rtp_session->vbw, 10);
-				}
-			}
-			switch_jb_put_packet(rtp_session->vbw, (switch_rtp_packet_t *)send_msg, bytes);
-		}
 
 #ifdef RTP_WRITE_PLOSS
 		{
@@ -7622,10 +8585,20 @@ static int rtp_common_write(switch_rtp_t *rtp_session,
 		//
 		//	//switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_WARNING, "SEND %u\n", ntohs(send_msg->header.seq));
 		//}
-		if (switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, (void *) send_msg, &bytes) != SWITCH_STATUS_SUCCESS) {
-			rtp_session->seq--;
-			ret = -1;
-			goto end;
+		if (rtp_session->pacer && rtp_session->pacer->running && bytes <= RTP_PACER_BUF_LEN) {
+			rtp_pacer_push(rtp_session, send_msg, bytes);
+		} else if (rtp_session->wbatch) {
+			if (rtp_batch_sendto(rtp_session, send_msg, bytes) != SWITCH_STATUS_SUCCESS) {
+				ret = -1;
+				goto end;
+			}
+		} else {
+			if (switch_socket_sendto(rtp_session->sock_output, rtp_session->remote_addr, 0, (void *) send_msg, &bytes) != SWITCH_STATUS_SUCCESS) {
+				rtp_session->seq--;
+				ret = -1;
+				goto end;
+			}
+			rtp_session->stats.outbound.syscall_count++;
 		}
 #endif
 		rtp_session->last_write_ts = this_ts;
@@ -7792,6 +8765,7 @@ SWITCH_DECLARE(int) switch_rtp_write_frame(switch_rtp_t *rtp_session, switch_fra
 			return -1;
 		}
 
+		rtp_session->stats.outbound.syscall_count++;
 
 		rtp_session->stats.outbound.raw_bytes += bytes;
 		rtp_session->stats.outbound.media_bytes += bytes;
@@ -7960,6 +8934,21 @@ SWITCH_DECLARE(switch_rtp_stats_t *) switch_rtp_get_stats(switch_rtp_t *rtp_sess
 		switch_jb_get_frames(rtp_session->jb, NULL, NULL, NULL, (uint32_t *)&s->inbound.largest_jb_size);
 	}
 
+	if (rtp_session->pacer) {
+		switch_mutex_lock(rtp_session->pacer->mutex);
+		s->outbound.pacing_queue_depth = rtp_session->pacer->head - rtp_session->pacer->tail;
+		switch_mutex_unlock(rtp_session->pacer->mutex);
+	}
+
+	if (rtp_session->vb) {
+		uint32_t requested = 0, recovered = 0, late = 0;
+
+		switch_jb_get_nack_stats(rtp_session->vb, &requested, &recovered, &late);
+		s->inbound.nack_count = requested;
+		s->inbound.nack_recovered_count = recovered;
+		s->inbound.nack_late_count = late;
+	}
+
 	do_mos(rtp_session, SWITCH_FALSE);
 
 	switch_mutex_unlock(rtp_session->flag_mutex);
@@ -8106,6 +9095,11 @@ SWITCH_DECLARE(uint32_t) switch_rtp_get_ssrc(switch_rtp_t *rtp_session)
 	return rtp_session->ssrc;
 }
 
+SWITCH_DECLARE(uint32_t) switch_rtp_get_rtx_ssrc(switch_rtp_t *rtp_session)
+{
+	return rtp_session->rtx_ssrc;
+}
+
 SWITCH_DECLARE(void) switch_rtp_set_private(switch_rtp_t *rtp_session, void *private_data)
 {
 	rtp_session->private_data = private_data;
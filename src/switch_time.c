@@ -52,6 +52,13 @@
 #define MAX_ELEMENTS 3600
 #define IDLE_SPEED 100
 
+/* Timers sharing an interval are spread over up to TIMER_PHASES phases so they do not all wake
+   on the same ms, and the waiters of each phase are split over up to TIMER_SHARDS condition
+   variables (one per core).  Phases are kept on a wheel with one slot per ms. */
+#define TIMER_PHASES 20
+#define TIMER_SHARDS 16
+#define TIMER_WHEEL_SIZE 4096	/* power of 2 larger than MAX_ELEMENTS */
+
 /* In Windows, enable the montonic timer for better timer accuracy,
  * GetSystemTimeAsFileTime does not update on timeBeginPeriod on these OS.
  * Flag SCF_USE_WIN32_MONOTONIC must be enabled to activate it (start parameter -monotonic-clock).
@@ -104,6 +111,10 @@ static struct {
 	int32_t use_cond_yield;
 	switch_mutex_t *mutex;
 	uint32_t timer_count;
+	switch_mutex_t *wheel_mutex;
+	uint64_t wheel_ms;
+	uint32_t shards;
+	uint32_t next_shard;
 } globals;
 
 #ifdef WIN32
@@ -116,11 +127,36 @@ SWITCH_MODULE_SHUTDOWN_FUNCTION(softtimer_shutdown);
 SWITCH_MODULE_RUNTIME_FUNCTION(softtimer_runtime);
 SWITCH_MODULE_DEFINITION(CORE_SOFTTIMER_MODULE, softtimer_load, softtimer_shutdown, softtimer_runtime);
 
+struct timer_shard {
+	switch_mutex_t *mutex;
+	switch_thread_cond_t *cond;
+	/* wake latency, only touched with mutex held */
+	uint64_t jitter[SWITCH_TIMER_JITTER_BUCKETS];
+	uint64_t jitter_max;
+};
+typedef struct timer_shard timer_shard_t;
+
+struct timer_phase {
+	uint64_t tick;
+	uint32_t count;
+	uint32_t roll;
+	uint32_t interval;
+	uint32_t offset;
+	switch_time_t due;
+	uint8_t queued;
+	struct timer_phase *next;
+	struct timer_phase *fire_next;
+	timer_shard_t shard[TIMER_SHARDS];
+};
+typedef struct timer_phase timer_phase_t;
+
 struct timer_private {
 	switch_size_t reference;
 	switch_size_t start;
 	uint32_t roll;
 	uint32_t ready;
+	timer_phase_t *phase;
+	timer_shard_t *shard;
 };
 typedef struct timer_private timer_private_t;
 
@@ -131,10 +167,13 @@ struct timer_matrix {
 	switch_mutex_t *mutex;
 	switch_thread_cond_t *cond;
 	switch_thread_rwlock_t *rwlock;
+	uint32_t phases;
+	timer_phase_t *phase;
 };
 typedef struct timer_matrix timer_matrix_t;
 
 static timer_matrix_t TIMER_MATRIX[MAX_ELEMENTS + 1];
+static timer_phase_t *TIMER_WHEEL[TIMER_WHEEL_SIZE];
 
 static switch_time_t time_now(int64_t offset);
 
@@ -676,9 +715,174 @@ SWITCH_DECLARE(void) switch_cond_yield(switch_interval_time_t t)
 
 }
 
+/* globals.mutex must be held */
+static timer_phase_t *timer_pick_phase(int interval)
+{
+	timer_matrix_t *matrix = &TIMER_MATRIX[interval];
+	timer_phase_t *phase;
+	uint32_t i, j;
+
+	if (!matrix->phase) {
+		matrix->phases = interval < TIMER_PHASES ? interval : TIMER_PHASES;
+		matrix->phase = switch_core_alloc(module_pool, matrix->phases * sizeof(timer_phase_t));
+
+		for (i = 0; i < matrix->phases; i++) {
+			phase = &matrix->phase[i];
+			phase->interval = interval;
+			phase->offset = i * (interval / matrix->phases);
+
+			for (j = 0; j < globals.shards; j++) {
+				switch_mutex_init(&phase->shard[j].mutex, SWITCH_MUTEX_NESTED, module_pool);
+				switch_thread_cond_create(&phase->shard[j].cond, module_pool);
+			}
+		}
+	}
+
+	/* stagger new timers onto the least loaded phase */
+	phase = &matrix->phase[0];
+	for (i = 1; i < matrix->phases; i++) {
+		if (matrix->phase[i].count < phase->count) {
+			phase = &matrix->phase[i];
+		}
+	}
+
+	return phase;
+}
+
+/* globals.wheel_mutex must be held, queues the phase on the next ms matching its offset */
+static void timer_wheel_insert(timer_phase_t *phase)
+{
+	uint64_t at = globals.wheel_ms + 1;
+	uint32_t slot;
+
+	at += (phase->offset + phase->interval - (uint32_t) (at % phase->interval)) % phase->interval;
+	slot = (uint32_t) (at & (TIMER_WHEEL_SIZE - 1));
+
+	phase->next = TIMER_WHEEL[slot];
+	TIMER_WHEEL[slot] = phase;
+	phase->queued = 1;
+}
+
+/* Called by the runtime thread once for every ms that elapsed, due is when that ms should have happened */
+static void timer_wheel_advance(switch_time_t due)
+{
+	timer_phase_t *phase, *next, *fire = NULL;
+	uint32_t slot, i;
+
+	switch_mutex_lock(globals.wheel_mutex);
+
+	slot = (uint32_t) (++globals.wheel_ms & (TIMER_WHEEL_SIZE - 1));
+	phase = TIMER_WHEEL[slot];
+	TIMER_WHEEL[slot] = NULL;
+
+	for (; phase; phase = next) {
+		next = phase->next;
+
+		if (!phase->count) {
+			phase->queued = 0;
+			continue;
+		}
+
+		phase->due = due;
+		phase->tick++;
+
+		if (phase->tick == MAX_TICK) {
+			phase->tick = 0;
+			phase->roll++;
+		}
+
+		timer_wheel_insert(phase);
+		phase->fire_next = fire;
+		fire = phase;
+	}
+
+	switch_mutex_unlock(globals.wheel_mutex);
+
+	/* shard waiters only hold the mutex for a tick check, a trylock could miss one parked in cond_wait */
+	for (phase = fire; phase; phase = phase->fire_next) {
+		for (i = 0; i < globals.shards; i++) {
+			switch_mutex_lock(phase->shard[i].mutex);
+			switch_thread_cond_broadcast(phase->shard[i].cond);
+			switch_mutex_unlock(phase->shard[i].mutex);
+		}
+	}
+}
+
+/* shard->mutex must be held */
+static void timer_jitter_sample(timer_shard_t *shard, switch_time_t due)
+{
+	switch_time_t now = time_now(runtime.offset);
+	uint64_t usec = now > due ? (uint64_t) (now - due) : 0;
+	uint32_t b = 0;
+
+	while (b < SWITCH_TIMER_JITTER_BUCKETS - 1 && usec > SWITCH_TIMER_JITTER_USEC(b)) {
+		b++;
+	}
+
+	shard->jitter[b]++;
+
+	if (usec > shard->jitter_max) {
+		shard->jitter_max = usec;
+	}
+}
+
+SWITCH_DECLARE(uint32_t) switch_time_get_jitter_stats(switch_timer_jitter_stats_t *stats, uint32_t max)
+{
+	uint32_t x, i, j, b, n = 0;
+
+	if (!globals.mutex) {
+		return 0;
+	}
+
+	switch_mutex_lock(globals.mutex);
+
+	for (x = 2; x <= MAX_ELEMENTS && n < max; x++) {
+		timer_matrix_t *matrix = &TIMER_MATRIX[x];
+		switch_timer_jitter_stats_t *st = &stats[n];
+
+		if (!matrix->phase) {
+			continue;
+		}
+
+		memset(st, 0, sizeof(*st));
+		st->interval = x;
+		st->timers = matrix->count;
+		st->shards = globals.shards;
+
+		for (i = 0; i < matrix->phases; i++) {
+			timer_phase_t *phase = &matrix->phase[i];
+
+			if (phase->count) {
+				st->phases++;
+			}
+
+			for (j = 0; j < globals.shards; j++) {
+				switch_mutex_lock(phase->shard[j].mutex);
+				for (b = 0; b < SWITCH_TIMER_JITTER_BUCKETS; b++) {
+					st->hist[b] += phase->shard[j].jitter[b];
+					st->samples += phase->shard[j].jitter[b];
+				}
+				if (phase->shard[j].jitter_max > st->max_usec) {
+					st->max_usec = phase->shard[j].jitter_max;
+				}
+				switch_mutex_unlock(phase->shard[j].mutex);
+			}
+		}
+
+		if (st->timers || st->samples) {
+			n++;
+		}
+	}
+
+	switch_mutex_unlock(globals.mutex);
+
+	return n;
+}
+
 static switch_status_t timer_init(switch_timer_t *timer)
 {
 	timer_private_t *private_info;
+	timer_phase_t *phase;
 	int sanity = 0;
 
 	timer->start = switch_micro_time_now();
@@ -704,22 +908,30 @@ static switch_status_t timer_init(switch_timer_t *timer)
 		}
 	}
 
-	if (globals.RUNNING != 1 || !globals.mutex || timer->interval < 1) {
+	if (globals.RUNNING != 1 || !globals.mutex || timer->interval < 1 || timer->interval > MAX_ELEMENTS) {
 		return SWITCH_STATUS_FALSE;
 	}
 
 	if ((private_info = switch_core_alloc(timer->memory_pool, sizeof(*private_info)))) {
 		switch_mutex_lock(globals.mutex);
-		if (!TIMER_MATRIX[timer->interval].mutex) {
-			switch_mutex_init(&TIMER_MATRIX[timer->interval].mutex, SWITCH_MUTEX_NESTED, module_pool);
-			switch_thread_cond_create(&TIMER_MATRIX[timer->interval].cond, module_pool);
-		}
+		phase = timer_pick_phase(timer->interval);
 		TIMER_MATRIX[timer->interval].count++;
+		private_info->phase = phase;
+		private_info->shard = &phase->shard[globals.next_shard++ % globals.shards];
+
+		/* phase->count is written under both locks so the runtime can read it under wheel_mutex alone */
+		switch_mutex_lock(globals.wheel_mutex);
+		phase->count++;
+		if (!phase->queued) {
+			timer_wheel_insert(phase);
+		}
+		switch_mutex_unlock(globals.wheel_mutex);
 		switch_mutex_unlock(globals.mutex);
+
 		timer->private_info = private_info;
-		private_info->start = private_info->reference = (switch_size_t)TIMER_MATRIX[timer->interval].tick;
+		private_info->start = private_info->reference = (switch_size_t)phase->tick;
 		private_info->start -= 2; /* switch_core_timer_init sets samplecount to samples, this makes first next() step once */
-		private_info->roll = TIMER_MATRIX[timer->interval].roll;
+		private_info->roll = phase->roll;
 		private_info->ready = 1;
 
 		if (runtime.microseconds_per_tick > 10000  && (timer->interval % (int)(runtime.microseconds_per_tick / 1000)) != 0 && (timer->interval % 10) == 0) {
@@ -746,9 +958,9 @@ static switch_status_t timer_init(switch_timer_t *timer)
 	return SWITCH_STATUS_MEMERR;
 }
 
-#define check_roll() if (private_info->roll < TIMER_MATRIX[timer->interval].roll) {	\
+#define check_roll() if (private_info->roll < private_info->phase->roll) {	\
 		private_info->roll++;											\
-		private_info->reference = private_info->start = (switch_size_t)TIMER_MATRIX[timer->interval].tick;	\
+		private_info->reference = private_info->start = (switch_size_t)private_info->phase->tick;	\
 		private_info->start--; /* Must have a diff */					\
 	}																	\
 
@@ -809,7 +1021,7 @@ static switch_status_t timer_sync(switch_timer_t *timer)
 	}
 
 	/* sync the clock */
-	private_info->reference = (switch_size_t)(timer->tick = TIMER_MATRIX[timer->interval].tick);
+	private_info->reference = (switch_size_t)(timer->tick = private_info->phase->tick);
 
 	/* apply timestamp */
 	timer_step(timer);
@@ -821,12 +1033,8 @@ static switch_status_t timer_sync(switch_timer_t *timer)
 static switch_status_t timer_next(switch_timer_t *timer)
 {
 	timer_private_t *private_info;
-
-#ifdef DISABLE_1MS_COND
-	int cond_index = timer->interval;
-#else
-	int cond_index = 1;
-#endif
+	timer_phase_t *phase;
+	timer_shard_t *shard;
 	int delta;
 
 	if (timer->interval == 1) {
@@ -840,14 +1048,16 @@ static switch_status_t timer_next(switch_timer_t *timer)
 #endif
 
 	private_info = timer->private_info;
+	phase = private_info->phase;
+	shard = private_info->shard;
 
-	delta = (int) (private_info->reference - TIMER_MATRIX[timer->interval].tick);
+	delta = (int) (private_info->reference - phase->tick);
 
 
 
 	/* sync up timer if it's not been called for a while otherwise it will return instantly several times until it catches up */
 	if (delta < -1) {
-		private_info->reference = (switch_size_t)(timer->tick = TIMER_MATRIX[timer->interval].tick);
+		private_info->reference = (switch_size_t)(timer->tick = phase->tick);
 	}
 	timer_step(timer);
 
@@ -856,7 +1066,7 @@ static switch_status_t timer_next(switch_timer_t *timer)
 		goto end;
 	}
 
-	while (globals.RUNNING == 1 && private_info->ready && TIMER_MATRIX[timer->interval].tick < private_info->reference) {
+	while (globals.RUNNING == 1 && private_info->ready && phase->tick < private_info->reference) {
 		check_roll();
 
 		switch_os_yield();
@@ -866,11 +1076,12 @@ static switch_status_t timer_next(switch_timer_t *timer)
 			globals.use_cond_yield = 0;
 		} else {
 			if (globals.use_cond_yield == 1) {
-				switch_mutex_lock(TIMER_MATRIX[cond_index].mutex);
-				if (TIMER_MATRIX[timer->interval].tick < private_info->reference) {
-					switch_thread_cond_wait(TIMER_MATRIX[cond_index].cond, TIMER_MATRIX[cond_index].mutex);
+				switch_mutex_lock(shard->mutex);
+				if (phase->tick < private_info->reference) {
+					switch_thread_cond_wait(shard->cond, shard->mutex);
+					timer_jitter_sample(shard, phase->due);
 				}
-				switch_mutex_unlock(TIMER_MATRIX[cond_index].mutex);
+				switch_mutex_unlock(shard->mutex);
 			} else {
 				do_sleep(1000);
 			}
@@ -904,7 +1115,7 @@ static switch_status_t timer_check(switch_timer_t *timer, switch_bool_t step)
 
 	check_roll();
 
-	timer->tick = TIMER_MATRIX[timer->interval].tick;
+	timer->tick = private_info->phase->tick;
 
 	if (timer->tick < private_info->reference) {
 		timer->diff = (switch_size_t)(private_info->reference - timer->tick);
@@ -943,12 +1154,14 @@ static switch_status_t timer_destroy(switch_timer_t *timer)
 
 	private_info = timer->private_info;
 
-	if (timer->interval < MAX_ELEMENTS) {
+	if (private_info && private_info->phase) {
 		switch_mutex_lock(globals.mutex);
 		TIMER_MATRIX[timer->interval].count--;
-		if (TIMER_MATRIX[timer->interval].count == 0) {
-			TIMER_MATRIX[timer->interval].tick = 0;
+		switch_mutex_lock(globals.wheel_mutex);
+		if (--private_info->phase->count == 0) {
+			private_info->phase->tick = 0;
 		}
+		switch_mutex_unlock(globals.wheel_mutex);
 		switch_mutex_unlock(globals.mutex);
 	}
 	if (private_info) {
@@ -1019,8 +1232,7 @@ static void win32_init_timers(void)
 SWITCH_MODULE_RUNTIME_FUNCTION(softtimer_runtime)
 {
 	switch_time_t too_late = runtime.microseconds_per_tick * 1000;
-	uint32_t current_ms = 0;
-	uint32_t x, tick = 0, sps_interval_ticks = 0;
+	uint32_t x, y, tick = 0, sps_interval_ticks = 0;
 	switch_time_t ts = 0, last = 0;
 	int fwd_errs = 0, rev_errs = 0;
 	int profile_tick = 0;
@@ -1132,7 +1344,6 @@ SWITCH_MODULE_RUNTIME_FUNCTION(softtimer_runtime)
 					int64_t diff = (int64_t) (ts - last);
 					switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Reverse Clock Skew Detected!\n");
 					runtime.reference = switch_time_now();
-					current_ms = 0;
 					tick = 0;
 					runtime.initiated += diff;
 					rev_errs++;
@@ -1194,7 +1405,6 @@ SWITCH_MODULE_RUNTIME_FUNCTION(softtimer_runtime)
 				switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_CRIT, "Forward Clock Skew Detected!\n");
 				fwd_errs++;
 				runtime.reference = switch_time_now();
-				current_ms = 0;
 				tick = 0;
 				runtime.initiated += diff;
 			}
@@ -1210,7 +1420,6 @@ SWITCH_MODULE_RUNTIME_FUNCTION(softtimer_runtime)
 		}
 
 		runtime.timestamp = ts;
-		current_ms += (runtime.microseconds_per_tick / 1000);
 		tick++;
 
 		if (time_sync < runtime.time_sync) {
@@ -1263,40 +1472,34 @@ SWITCH_MODULE_RUNTIME_FUNCTION(softtimer_runtime)
 #endif
 
 
-		if (MATRIX && (current_ms % (runtime.microseconds_per_tick / 1000)) == 0) {
-			for (x = (runtime.microseconds_per_tick / 1000); x <= MAX_ELEMENTS; x += (runtime.microseconds_per_tick / 1000)) {
-				if ((current_ms % x) == 0) {
-					if (TIMER_MATRIX[x].count) {
-						TIMER_MATRIX[x].tick++;
-#ifdef DISABLE_1MS_COND
+		if (MATRIX) {
+			uint32_t tick_ms = runtime.microseconds_per_tick / 1000;
+			switch_time_t due = runtime.reference - runtime.microseconds_per_tick;
 
-						if (TIMER_MATRIX[x].mutex && switch_mutex_trylock(TIMER_MATRIX[x].mutex) == SWITCH_STATUS_SUCCESS) {
-							switch_thread_cond_broadcast(TIMER_MATRIX[x].cond);
-							switch_mutex_unlock(TIMER_MATRIX[x].mutex);
-						}
-#endif
-						if (TIMER_MATRIX[x].tick == MAX_TICK) {
-							TIMER_MATRIX[x].tick = 0;
-							TIMER_MATRIX[x].roll++;
-						}
-					}
-				}
+			/* walk every ms of the tick so phases finer than the resolution still fire */
+			for (x = 0; x < tick_ms; x++) {
+				due += 1000;
+				timer_wheel_advance(due);
 			}
 		}
-
-		if (current_ms == MAX_ELEMENTS) {
-			current_ms = 0;
-		}
 	}
 
 	globals.use_cond_yield = 0;
 	
-	for (x = (runtime.microseconds_per_tick / 1000); x <= MAX_ELEMENTS; x += (runtime.microseconds_per_tick / 1000)) {
-		if (TIMER_MATRIX[x].mutex && switch_mutex_trylock(TIMER_MATRIX[x].mutex) == SWITCH_STATUS_SUCCESS) {
-			switch_thread_cond_broadcast(TIMER_MATRIX[x].cond);
-			switch_mutex_unlock(TIMER_MATRIX[x].mutex);
+	switch_mutex_lock(globals.mutex);
+	for (x = 2; x <= MAX_ELEMENTS; x++) {
+		timer_matrix_t *matrix = &TIMER_MATRIX[x];
+		uint32_t i;
+
+		for (i = 0; matrix->phase && i < matrix->phases; i++) {
+			for (y = 0; y < globals.shards; y++) {
+				switch_mutex_lock(matrix->phase[i].shard[y].mutex);
+				switch_thread_cond_broadcast(matrix->phase[i].shard[y].cond);
+				switch_mutex_unlock(matrix->phase[i].shard[y].mutex);
+			}
 		}
 	}
+	switch_mutex_unlock(globals.mutex);
 
 	if (tfd > -1) {
 		close(tfd);
@@ -1507,6 +1710,14 @@ SWITCH_MODULE_LOAD_FUNCTION(softtimer_load)
 
 	memset(&globals, 0, sizeof(globals));
 	switch_mutex_init(&globals.mutex, SWITCH_MUTEX_NESTED, module_pool);
+	switch_mutex_init(&globals.wheel_mutex, SWITCH_MUTEX_NESTED, module_pool);
+
+	globals.shards = switch_core_cpu_count();
+	if (globals.shards < 1) {
+		globals.shards = 1;
+	} else if (globals.shards > TIMER_SHARDS) {
+		globals.shards = TIMER_SHARDS;
+	}
 
 	if ((switch_event_bind_removable(modname, SWITCH_EVENT_RELOADXML, NULL, event_handler, NULL, &NODE) != SWITCH_STATUS_SUCCESS)) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Couldn't bind!\n");
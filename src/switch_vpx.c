@@ -50,6 +50,7 @@
 
 #define SLICE_SIZE SWITCH_DEFAULT_VIDEO_SIZE
 #define KEY_FRAME_MIN_FREQ 250000
+#define VPX_MAX_ENCODER_THREADS 8
 
 /*	http://tools.ietf.org/html/draft-ietf-payload-vp8-10
 
@@ -292,6 +293,10 @@ struct vpx_context {
 	vpx_codec_ctx_t	decoder;
 	uint8_t decoder_init;
 	switch_buffer_t *vpx_packet_buffer;
+	uint8_t *direct_data;
+	switch_size_t direct_len;
+	uint64_t bytes_buffered;
+	uint64_t bytes_direct;
 	int got_key_frame;
 	int no_key_frame;
 	int got_start_frame;
@@ -307,9 +312,95 @@ struct vpx_context {
 	switch_buffer_t *pbuffer;
 	switch_time_t start_time;
 	switch_image_t *patch_img;
+	int threads;
+	int encode_usec;
+	int encode_usec_max;
 };
 typedef struct vpx_context vpx_context_t;
 
+/* encoder threads are shared by every vpx encoder in the process so a busy conference cannot oversubscribe the box */
+static struct {
+	switch_mutex_t *mutex;
+	int max_threads;
+	int used_threads;
+} vpx_globals;
+
+static int vpx_wanted_threads(vpx_context_t *context)
+{
+	int pixels = context->codec_settings.video.width * context->codec_settings.video.height;
+	int threads;
+
+	if (pixels <= 320 * 240) {
+		threads = 1;
+	} else if (pixels <= 640 * 480) {
+		threads = 2;
+	} else if (pixels <= 1280 * 720) {
+		threads = 4;
+	} else {
+		threads = VPX_MAX_ENCODER_THREADS;
+	}
+
+	if (threads > switch_core_cpu_count()) {
+		threads = switch_core_cpu_count();
+	}
+
+	return threads > 0 ? threads : 1;
+}
+
+static void vpx_release_threads(vpx_context_t *context)
+{
+	if (!context->threads) {
+		return;
+	}
+
+	switch_mutex_lock(vpx_globals.mutex);
+	vpx_globals.used_threads -= context->threads;
+	switch_mutex_unlock(vpx_globals.mutex);
+
+	context->threads = 0;
+}
+
+/* every encoder gets at least one thread, extra ones only while the process budget lasts */
+static int vpx_reserve_threads(vpx_context_t *context)
+{
+	int wanted = vpx_wanted_threads(context), extra;
+
+	vpx_release_threads(context);
+
+	switch_mutex_lock(vpx_globals.mutex);
+	extra = vpx_globals.max_threads - vpx_globals.used_threads - 1;
+	if (extra < 0) {
+		extra = 0;
+	}
+	context->threads = wanted - 1 > extra ? extra + 1 : wanted;
+	vpx_globals.used_threads += context->threads;
+	switch_mutex_unlock(vpx_globals.mutex);
+
+	return context->threads;
+}
+
+/* log2 of the number of VP8 token partitions or VP9 tile columns */
+static int vpx_partitions(vpx_context_t *context)
+{
+	int parts = 0;
+
+	while ((1 << parts) < context->threads && parts < 3) {
+		parts++;
+	}
+
+	if (context->is_vp9) {
+		/* VP9 tiles must be at least 256 pixels wide */
+		while (parts && (context->codec_settings.video.width >> parts) < 256) {
+			parts--;
+		}
+	} else if (!parts && context->codec_settings.video.width * context->codec_settings.video.height > 640 * 480) {
+		/* lets the far end decode large pictures in parallel even when we encode on one thread */
+		parts = 1;
+	}
+
+	return parts;
+}
+
 
 static switch_status_t init_decoder(switch_codec_t *codec)
 {
@@ -367,9 +458,8 @@ static switch_status_t init_encoder(switch_codec_t *codec)
 {
 	vpx_context_t *context = (vpx_context_t *)codec->private_info;
 	vpx_codec_enc_cfg_t *config = &context->config;
-	int token_parts = 1;
-	int cpus = switch_core_cpu_count();
-	int sane, threads = 1;
+	int token_parts = 0;
+	int sane;
 	
 	if (!context->codec_settings.video.width) {
 		context->codec_settings.video.width = 1280;
@@ -413,13 +503,16 @@ static switch_status_t init_encoder(switch_codec_t *codec)
 	config->rc_target_bitrate = context->bandwidth;
 	config->g_lag_in_frames = 0;
 	config->kf_max_dist = 360;//2000;
-	threads = cpus / 4;
-	if (threads < 1) threads = 1;
-	config->g_threads = threads;
+
+	/* libvpx sets up its worker threads at init time, a bandwidth change keeps what we have */
+	if (!context->encoder_init) {
+		config->g_threads = vpx_reserve_threads(context);
+	}
+
+	token_parts = vpx_partitions(context);
 	
 	if (context->is_vp9) {
 		//config->rc_dropframe_thresh = 2;
-		token_parts = (cpus > 1) ? 3 : 0;
 
 		if (context->lossless) {
 			config->rc_min_quantizer = 0;
@@ -439,7 +532,6 @@ static switch_status_t init_encoder(switch_codec_t *codec)
 		// settings
 		config->g_profile = 2;
 		config->g_error_resilient = VPX_ERROR_RESILIENT_PARTITIONS;
-		token_parts = (cpus > 1) ? 3 : 0;
 
 		// rate control settings
 		config->rc_dropframe_thresh = 0;
@@ -543,11 +635,15 @@ static switch_status_t init_encoder(switch_codec_t *codec)
 
 		if (vpx_codec_enc_init(&context->encoder, context->encoder_interface, config, 0 & VPX_CODEC_USE_OUTPUT_PARTITION) != VPX_CODEC_OK) {
 			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "Codec %s init error: [%d:%s]\n", vpx_codec_iface_name(context->encoder_interface), context->encoder.err, context->encoder.err_detail);
+			vpx_release_threads(context);
 			return SWITCH_STATUS_FALSE;
 		}
 		
 		context->encoder_init = 1;
 
+		switch_log_printf(SWITCH_CHANNEL_SESSION_LOG(codec->session), SWITCH_LOG_DEBUG, "VPX encoder %dx%d using %d thread(s), %d partition(s), %d/%d process threads in use\n",
+						  config->g_w, config->g_h, config->g_threads, 1 << token_parts, vpx_globals.used_threads, vpx_globals.max_threads);
+
 		if (context->is_vp9) {
 			if (context->lossless) {
 				vpx_codec_control(&context->encoder, VP9E_SET_LOSSLESS, 1);
@@ -557,7 +653,10 @@ static switch_status_t init_encoder(switch_codec_t *codec)
 			}
 
 			vpx_codec_control(&context->encoder, VP8E_SET_STATIC_THRESHOLD, 1000);
-			vpx_codec_control(&context->encoder, VP8E_SET_TOKEN_PARTITIONS, token_parts);
+			vpx_codec_control(&context->encoder, VP9E_SET_TILE_COLUMNS, token_parts);
+#ifdef VPX_CTRL_VP9E_SET_ROW_MT
+			vpx_codec_control(&context->encoder, VP9E_SET_ROW_MT, config->g_threads > 1);
+#endif
 			vpx_codec_control(&context->encoder, VP9E_SET_TUNE_CONTENT, VP9E_CONTENT_SCREEN);
 
 		} else {
@@ -793,7 +892,7 @@ static switch_status_t switch_vpx_encode(switch_codec_t *codec, switch_frame_t *
 	int64_t pts;
 	vpx_enc_frame_flags_t vpx_flags = 0;
 	switch_time_t now;
-	int err;
+	int err, spent;
 
 	if (frame->flags & SFF_SAME_IMAGE) {
 		return consume_partition(context, frame);
@@ -856,12 +955,20 @@ static switch_status_t switch_vpx_encode(switch_codec_t *codec, switch_frame_t *
 
 	dur = context->last_ms ? (now - context->last_ms) / 1000 : pts;
 
-	if ((err = vpx_codec_encode(&context->encoder,
-						 (vpx_image_t *) frame->img,
-						 pts,
-						 dur,
-						 vpx_flags,
-						 VPX_DL_REALTIME)) != VPX_CODEC_OK) {
+	err = vpx_codec_encode(&context->encoder,
+						   (vpx_image_t *) frame->img,
+						   pts,
+						   dur,
+						   vpx_flags,
+						   VPX_DL_REALTIME);
+
+	spent = (int) (switch_time_now() - now);
+	context->encode_usec = context->encode_usec ? (context->encode_usec * 7 + spent) / 8 : spent;
+	if (spent > context->encode_usec_max) {
+		context->encode_usec_max = spent;
+	}
+
+	if (err != VPX_CODEC_OK) {
 		switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "VPX encode error %d:%s:%s\n",
 			err, vpx_codec_error(&context->encoder), vpx_codec_error_detail(&context->encoder));
 		frame->datalen = 0;
@@ -960,7 +1067,16 @@ static switch_status_t buffer_vp8_packets(vpx_context_t *context, switch_frame_t
 		return SWITCH_STATUS_RESTART;
 	}
 
+	if (S && frame->m && !switch_buffer_inuse(context->vpx_packet_buffer)) {
+		/* whole frame in one packet, decode it straight out of the frame data */
+		context->direct_data = data;
+		context->direct_len = len;
+		context->bytes_direct += len;
+		return SWITCH_STATUS_SUCCESS;
+	}
+
 	switch_buffer_write(context->vpx_packet_buffer, data, len);
+	context->bytes_buffered += len;
 	return SWITCH_STATUS_SUCCESS;
 }
 
@@ -1167,6 +1283,8 @@ static switch_status_t switch_vpx_decode(switch_codec_t *codec, switch_frame_t *
 	}
 
 	decoder = &context->decoder;
+	context->direct_data = NULL;
+	context->direct_len = 0;
 	
 	// switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_INFO, "len: %d ts: %u mark:%d\n", frame->datalen, frame->timestamp, frame->m);
 
@@ -1206,7 +1324,7 @@ static switch_status_t switch_vpx_decode(switch_codec_t *codec, switch_frame_t *
 
 	// switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "====READ buf:%ld got_key:%d st:%d m:%d\n", switch_buffer_inuse(context->vpx_packet_buffer), context->got_key_frame, status, frame->m);
 
-	len = switch_buffer_inuse(context->vpx_packet_buffer);
+	len = context->direct_data ? context->direct_len : switch_buffer_inuse(context->vpx_packet_buffer);
 
 	//if (frame->m && (status != SWITCH_STATUS_SUCCESS || !len)) {
 		//switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_ERROR, "WTF????? %d %ld\n", status, len);
@@ -1217,7 +1335,11 @@ static switch_status_t switch_vpx_decode(switch_codec_t *codec, switch_frame_t *
 		int corrupted = 0;
 		int err;
 
-		switch_buffer_peek_zerocopy(context->vpx_packet_buffer, (void *)&data);
+		if (context->direct_data) {
+			data = context->direct_data;
+		} else {
+			switch_buffer_peek_zerocopy(context->vpx_packet_buffer, (void *)&data);
+		}
 
 		context->dec_iter = NULL;
 		err = vpx_codec_decode(decoder, data, (unsigned int)len, NULL, 0);
@@ -1318,6 +1440,18 @@ static switch_status_t switch_vpx_control(switch_codec_t *codec,
 	case SCC_VIDEO_GEN_KEYFRAME:
 		context->need_key_frame = 1;		
 		break;
+	case SCC_VIDEO_ENCODE_TIME:
+		/* smoothed usec per encoded frame, the worst one seen goes in cmd_arg when asked for */
+		if (rtype) {
+			*rtype = SCCT_INT;
+		}
+		if (ret_data) {
+			*ret_data = (void *) &context->encode_usec;
+		}
+		if (atype == SCCT_INT && cmd_arg) {
+			*((int *) cmd_arg) = context->encode_usec_max;
+		}
+		break;
 	case SCC_VIDEO_BANDWIDTH:
 		{
 			switch(ctype) {
@@ -1349,11 +1483,17 @@ static switch_status_t switch_vpx_destroy(switch_codec_t *codec)
 	vpx_context_t *context = (vpx_context_t *)codec->private_info;
 
 	if (context) {
+
+		if ((codec->flags & SWITCH_CODEC_FLAG_DECODE)) {
+			switch_log_printf(SWITCH_CHANNEL_LOG, SWITCH_LOG_DEBUG, "VPX decoder buffered %" SWITCH_UINT64_T_FMT " bytes, decoded %" SWITCH_UINT64_T_FMT " bytes in place\n",
+							  context->bytes_buffered, context->bytes_direct);
+		}
 		
 		switch_img_free(&context->patch_img);
 
 		if ((codec->flags & SWITCH_CODEC_FLAG_ENCODE)) {
 			vpx_codec_destroy(&context->encoder);
+			vpx_release_threads(context);
 		}
 
 		if ((codec->flags & SWITCH_CODEC_FLAG_DECODE)) {
@@ -1375,9 +1515,22 @@ static switch_status_t switch_vpx_destroy(switch_codec_t *codec)
 SWITCH_MODULE_LOAD_FUNCTION(mod_vpx_load)
 {
 	switch_codec_interface_t *codec_interface;
+	const char *var;
 
 	/* connect my internal structure to the blank pointer passed to me */
 	*module_interface = switch_loadable_module_create_module_interface(pool, modname);
+
+	memset(&vpx_globals, 0, sizeof(vpx_globals));
+	switch_mutex_init(&vpx_globals.mutex, SWITCH_MUTEX_NESTED, pool);
+
+	if ((var = switch_core_get_variable("vpx_max_encoder_threads"))) {
+		vpx_globals.max_threads = atoi(var);
+	}
+
+	if (vpx_globals.max_threads <= 0) {
+		vpx_globals.max_threads = switch_core_cpu_count();
+	}
+
 	SWITCH_ADD_CODEC(codec_interface, "VP8 Video");
 	switch_core_codec_add_video_implementation(pool, codec_interface, 99, "VP8", NULL,
 											   switch_vpx_init, switch_vpx_encode, switch_vpx_decode, switch_vpx_control, switch_vpx_destroy);
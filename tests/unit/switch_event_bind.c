@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+static int hits = 0;
+static int misses = 0;
+
+static void hit_callback(switch_event_t *event)
+{
+  hits++;
+}
+
+static void miss_callback(switch_event_t *event)
+{
+  misses++;
+}
+
+static switch_event_node_t **bind_noise(int count)
+{
+  switch_event_node_t **nodes = calloc(count, sizeof(switch_event_node_t *));
+  char *subclass = NULL;
+  int x = 0;
+
+  for ( x = 0; x < count; x++) {
+    subclass = switch_mprintf("test::noise_%d", x);
+    switch_event_bind_removable("test", SWITCH_EVENT_CUSTOM, subclass, miss_callback, NULL, &nodes[x]);
+    free(subclass);
+  }
+
+  return nodes;
+}
+
+static void unbind_noise(switch_event_node_t **nodes, int count)
+{
+  int x = 0;
+
+  for ( x = 0; x < count; x++) {
+    switch_event_unbind(&nodes[x]);
+  }
+  free(nodes);
+}
+
+int main () {
+  switch_event_t *event = NULL;
+  switch_event_node_t *node = NULL, **noise = NULL;
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  int x = 0, loops = 10;
+
+#ifdef BENCHMARK
+  int counts[] = { 1, 10, 100, 1000 };
+  int c = 0;
+  switch_time_t start_ts, end_ts;
+  unsigned long long micro_total = 0;
+
+  loops = 100000;
+  plan(2);
+#else
+  switch_event_node_t *all_node = NULL;
+
+  plan(7);
+#endif
+
+  status = switch_core_init(SCF_NONE, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  status = switch_event_bind_removable("test", SWITCH_EVENT_CUSTOM, "test::hit", hit_callback, NULL, &node);
+  ok( status == SWITCH_STATUS_SUCCESS, "Bind subclass callback");
+
+#ifndef BENCHMARK
+  noise = bind_noise(loops);
+
+  for ( x = 0; x < loops; x++) {
+    switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, "test::hit");
+    switch_event_deliver(&event);
+  }
+
+  cmp_ok( hits, "==", loops, "Subclass callback sees every matching event");
+  cmp_ok( misses, "==", 0, "Other subclass bindings are skipped");
+
+  switch_event_bind_removable("test", SWITCH_EVENT_ALL, NULL, miss_callback, NULL, &all_node);
+  switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, "test::hit");
+  switch_event_deliver(&event);
+  cmp_ok( misses, "==", 1, "Catch-all binding still sees subclassed events");
+
+  switch_event_unbind(&all_node);
+  unbind_noise(noise, loops);
+  switch_event_unbind(&node);
+
+  ok( node == NULL, "Unbind subclass callback");
+
+  hits = 0;
+  switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, "test::hit");
+  switch_event_deliver(&event);
+  cmp_ok( hits, "==", 0, "Unbound callback is no longer called");
+#else
+  for ( c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+    noise = bind_noise(counts[c]);
+
+    start_ts = switch_time_now();
+    for ( x = 0; x < loops; x++) {
+      switch_event_create_subclass(&event, SWITCH_EVENT_CUSTOM, "test::hit");
+      switch_event_deliver(&event);
+    }
+    end_ts = switch_time_now();
+
+    micro_total = end_ts - start_ts;
+    note("switch_event deliver: %d bindings, Total %lluus / %d loops, %.0f events per second\n",
+         counts[c] + 1, micro_total, loops, micro_total ? loops * 1000000.0 / micro_total : 0);
+
+    unbind_noise(noise, counts[c]);
+  }
+
+  switch_event_unbind(&node);
+#endif
+
+  switch_core_destroy();
+
+  done_testing();
+}
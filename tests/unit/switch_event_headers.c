@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+int main () {
+  switch_event_t *event = NULL;
+  switch_bool_t verbose = SWITCH_TRUE;
+  const char *err = NULL;
+  int loops = 300, x = 0;
+  switch_status_t status = SWITCH_STATUS_SUCCESS;
+  char **index = NULL;
+
+#ifdef BENCHMARK
+  int counts[] = { 10, 30, 100, 300, 1000 };
+  int c = 0, lookups = 100000;
+  switch_time_t start_ts, end_ts;
+  unsigned long long micro_total = 0;
+
+  loops = 1000;
+  plan(1);
+#else
+  switch_event_header_t *hp = NULL;
+  int in_order = 1;
+
+  plan(11);
+#endif
+
+  status = switch_core_init(SCF_MINIMAL, verbose, &err);
+
+  if ( !ok( status == SWITCH_STATUS_SUCCESS, "Initialize FreeSWITCH core\n")) {
+    bail_out(0, "Bail due to failure to initialize FreeSWITCH[%s]", err);
+  }
+
+  index = calloc(loops, sizeof(char *));
+  for ( x = 0; x < loops; x++) {
+    index[x] = switch_mprintf("variable_%d", x);
+  }
+
+#ifndef BENCHMARK
+  switch_event_create_plain(&event, SWITCH_EVENT_CHANNEL_DATA);
+
+  for ( x = 0; x < loops; x++) {
+    switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, index[x], index[x]);
+  }
+
+  ok( event->hindex != NULL, "Header index built for a large event");
+
+  for ( x = 0, hp = event->headers; hp; hp = hp->next, x++) {
+    if (x >= loops || strcmp(hp->name, index[x])) {
+      in_order = 0;
+    }
+  }
+  ok( in_order && x == loops, "Insertion order is preserved");
+
+  for ( x = 0; x < loops; x++) {
+    if (!switch_event_get_header(event, index[x]) || strcmp(switch_event_get_header(event, index[x]), index[x])) {
+      break;
+    }
+  }
+  cmp_ok( x, "==", loops, "Every header found through the index");
+
+  is( switch_event_get_header(event, "VARIABLE_7"), index[7], "Lookup is case insensitive");
+
+  switch_event_del_header(event, index[7]);
+  ok( switch_event_get_header(event, index[7]) == NULL, "Deleted header is gone");
+
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, index[7], "again");
+  is( switch_event_get_header(event, index[7]), "again", "Re-added header is found");
+
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, index[9], "second");
+  switch_event_del_header_val(event, index[9], index[9]);
+  is( switch_event_get_header(event, index[9]), "second", "Deleting the first of two duplicates finds the second");
+
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, index[11], "second");
+  switch_event_del_header_val(event, index[11], "second");
+  is( switch_event_get_header(event, index[11]), index[11], "Deleting the second of two duplicates keeps the first");
+
+  switch_event_del_header_val(event, index[9], "second");
+  ok( switch_event_get_header(event, index[9]) == NULL, "Deleting the last duplicate by value removes the name");
+
+  switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, index[9], "third");
+  is( switch_event_get_header(event, index[9]), "third", "Header re-added after delete by value is found");
+
+  switch_event_destroy(&event);
+#else
+  for ( c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+    switch_event_create_plain(&event, SWITCH_EVENT_CHANNEL_DATA);
+
+    for ( x = 0; x < counts[c]; x++) {
+      switch_event_add_header_string(event, SWITCH_STACK_BOTTOM, index[x], index[x]);
+    }
+
+    start_ts = switch_time_now();
+    for ( x = 0; x < lookups; x++) {
+      if ( !switch_event_get_header(event, index[x % counts[c]])) {
+        fail("Failed to lookup event header value");
+      }
+    }
+    end_ts = switch_time_now();
+
+    micro_total = end_ts - start_ts;
+    note("switch_event get_header: %d headers, Total %lluus / %d lookups, %.3f us per lookup\n",
+         counts[c], micro_total, lookups, micro_total / (double) lookups);
+
+    switch_event_destroy(&event);
+  }
+#endif
+
+  for ( x = 0; x < loops; x++) {
+    free(index[x]);
+  }
+  free(index);
+
+  switch_core_destroy();
+
+  done_testing();
+}
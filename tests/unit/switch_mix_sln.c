@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <switch.h>
+#include <tap.h>
+
+// #define BENCHMARK 1
+
+#define MAX_SAMPLES 960
+
+static const char *kernels[] = { "scalar", "sse2", "avx2" };
+
+static void fill(int16_t *data, uint32_t samples, int loud)
+{
+  uint32_t x = 0;
+
+  for ( x = 0; x < samples; x++) {
+    data[x] = (int16_t) (loud ? ((rand() & 1) ? SWITCH_SMAX : SWITCH_SMIN) : (rand() % 2001) - 1000);
+  }
+}
+
+static void mix(int16_t **members, int count, uint32_t samples, int32_t *main_frame, int16_t *out)
+{
+  int m = 0;
+
+  memset(main_frame, 0, samples * sizeof(main_frame[0]));
+
+  for ( m = 0; m < count; m++) {
+    switch_mix_sln_accumulate(main_frame, members[m], samples);
+  }
+
+  for ( m = 0; m < count; m++) {
+    switch_mix_sln_unmix(out + m * samples, main_frame, members[m], samples, samples);
+  }
+}
+
+int main () {
+  int16_t **members = NULL, *expect = NULL, *out = NULL;
+  int32_t main_frame[MAX_SAMPLES];
+  int count = 8, m = 0, k = 0;
+
+#ifdef BENCHMARK
+  int counts[] = { 10, 50, 200 };
+  uint32_t rates[] = { 8000, 16000, 48000 };
+  int c = 0, r = 0, loops = 1000, x = 0;
+  uint32_t samples = 0;
+  switch_time_t start_ts, end_ts;
+  unsigned long long micro_total = 0;
+
+  count = 200;
+  plan(1);
+#else
+  uint32_t lens[] = { 160, 163, 320, 7, 960 };
+  int l = 0, same = 0;
+
+  plan(7);
+#endif
+
+  members = calloc(count, sizeof(int16_t *));
+  for ( m = 0; m < count; m++) {
+    members[m] = calloc(MAX_SAMPLES, sizeof(int16_t));
+  }
+  expect = calloc(count * MAX_SAMPLES, sizeof(int16_t));
+  out = calloc(count * MAX_SAMPLES, sizeof(int16_t));
+
+  ok( switch_mix_sln_kernel("scalar") != NULL, "Scalar kernel is always available");
+
+#ifndef BENCHMARK
+  for ( k = 1; k < (int)(sizeof(kernels) / sizeof(kernels[0])); k++) {
+    skip( !switch_mix_sln_kernel(kernels[k]), 1, "%s kernel not supported on this cpu", kernels[k]);
+
+    same = 1;
+    for ( l = 0; l < (int)(sizeof(lens) / sizeof(lens[0])); l++) {
+      for ( m = 0; m < count; m++) {
+        fill(members[m], lens[l], l == 0);
+      }
+
+      switch_mix_sln_kernel("scalar");
+      mix(members, count, lens[l], main_frame, expect);
+      switch_mix_sln_kernel(kernels[k]);
+      mix(members, count, lens[l], main_frame, out);
+
+      if (memcmp(expect, out, count * lens[l] * sizeof(int16_t))) {
+        same = 0;
+      }
+    }
+    ok( same, "%s kernel matches the scalar mix, saturation included", kernels[k]);
+
+    end_skip;
+  }
+
+  switch_mix_sln_kernel("scalar");
+  fill(members[0], 160, 1);
+  memset(main_frame, 0, sizeof(main_frame));
+  switch_mix_sln_accumulate(main_frame, members[0], 160);
+  switch_mix_sln_accumulate(main_frame, members[0], 160);
+  switch_mix_sln_unmix(out, main_frame, NULL, 0, 160);
+  cmp_ok( out[0], "==", members[0][0] > 0 ? SWITCH_SMAX : SWITCH_SMIN, "Overflowing mix saturates");
+
+  switch_mix_sln_unmix(out, main_frame, members[0], 160, 160);
+  ok( !memcmp(out, members[0], 160 * sizeof(int16_t)), "Removing one copy leaves the other");
+
+  memset(main_frame, 0, sizeof(main_frame));
+  fill(members[1], 160, 0);
+  switch_mix_sln_accumulate(main_frame, members[1], 160);
+  switch_mix_sln_unmix(out, main_frame, members[1], 80, 160);
+  ok( out[0] == 0 && out[79] == 0 && out[80] == members[1][80], "Own audio is only removed for the samples it covers");
+
+  ok( switch_mix_sln_kernel(NULL) != NULL, "Best kernel selected");
+  note("best mixing kernel: %s\n", switch_mix_sln_kernel(NULL));
+#else
+  for ( m = 0; m < count; m++) {
+    fill(members[m], MAX_SAMPLES, 0);
+  }
+
+  for ( k = 0; k < (int)(sizeof(kernels) / sizeof(kernels[0])); k++) {
+    if (!switch_mix_sln_kernel(kernels[k])) {
+      note("%s kernel not supported on this cpu\n", kernels[k]);
+      continue;
+    }
+
+    for ( r = 0; r < (int)(sizeof(rates) / sizeof(rates[0])); r++) {
+      samples = rates[r] / 50;
+
+      for ( c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        start_ts = switch_time_now();
+        for ( x = 0; x < loops; x++) {
+          mix(members, counts[c], samples, main_frame, out);
+        }
+        end_ts = switch_time_now();
+
+        micro_total = end_ts - start_ts;
+        note("mix %s: %d members @%uHz, Total %lluus / %d frames, %.2f us per 20ms frame\n",
+             kernels[k], counts[c], rates[r], micro_total, loops, micro_total / (double) loops);
+      }
+    }
+  }
+#endif
+
+  for ( m = 0; m < count; m++) {
+    free(members[m]);
+  }
+  free(members);
+  free(expect);
+  free(out);
+
+  done_testing();
+}
@@ -15,3 +15,24 @@ tests_unit_switch_hash_CFLAGS = $(SWITCH_AM_CFLAGS)
 tests_unit_switch_hash_LDADD = $(FSLD)
 tests_unit_switch_hash_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
 
+
+check_PROGRAMS += tests/unit/switch_event_bind
+
+tests_unit_switch_event_bind_SOURCES = tests/unit/switch_event_bind.c
+tests_unit_switch_event_bind_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_event_bind_LDADD = $(FSLD)
+tests_unit_switch_event_bind_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/switch_event_headers
+
+tests_unit_switch_event_headers_SOURCES = tests/unit/switch_event_headers.c
+tests_unit_switch_event_headers_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_event_headers_LDADD = $(FSLD)
+tests_unit_switch_event_headers_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap
+
+check_PROGRAMS += tests/unit/switch_mix_sln
+
+tests_unit_switch_mix_sln_SOURCES = tests/unit/switch_mix_sln.c
+tests_unit_switch_mix_sln_CFLAGS = $(SWITCH_AM_CFLAGS)
+tests_unit_switch_mix_sln_LDADD = $(FSLD)
+tests_unit_switch_mix_sln_LDFLAGS = $(SWITCH_AM_LDFLAGS) -ltap